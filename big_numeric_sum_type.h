@@ -5,8 +5,10 @@
 //It is certainly more convenient to use mpq_class for everything
 //and only reduce when canonicalizing.
 //
-//The benchmarks in release show multiplication is ~2.5x faster on the sum type in word rational range,
-//and ~12x faster on the sum type in word integer range
+//CompareBench (compare_bench.cpp) measures the sum type and rat64_t against double, a naive __int128
+//rational, boost::rational<int64_t> and mpq_class. In release, multiplication on the sum type is ~4x
+//faster than mpq_class in word rational range and ~18x faster in word integer range. Operands near
+//the word limit overflow into GMP, and there the sum type is ~2.5x slower than mpq_class.
 //
 //There is also a 10x difference for multiplying a big integer by a little integer using a sum type
 //as opposed to using rationals
@@ -16,23 +18,344 @@
 //versus using a sum class, the sum class pays off.
 
 #include "rat64_t.h"
+#include <atomic>
+#include <functional>
+#include <limits>
 #include <gmpxx.h>
 #include <math.h>
+#include <type_traits>
+#include <vector>
 
 enum Type{
     GmpInt,
     GmpRat,
     WordInt,
     WordRat,
+    WideInt, //Integers past the WordInt range with up to 127 magnitude bits, kept in a WideSlab block
+    Dyadic, //m/2^e with an odd m below 2^55 in magnitude and 1 <= e <= 255, packed into the pointer word
+    Decimal, //m/10^s with m below 2^58 in magnitude and not a multiple of 10, and 1 <= s <= 18, packed into the pointer word
 };
 
+#if defined(__GNUC__) || defined(__clang__)
+#define NUMTYPE_COLD __attribute__((noinline, cold))
+#define NUMTYPE_LIKELY(x) __builtin_expect(!!(x), 1)
+#else
+#define NUMTYPE_COLD
+#define NUMTYPE_LIKELY(x) (x)
+#endif
+
 constexpr inline uint16_t typePair(Type a, Type b) noexcept{
-    return a + (b << 2);
+    return a + (b << 3);
 }
 
+//GMP payloads are intrusively reference counted, so copying a NumType only bumps a count.
+//A payload is cloned the first time a copy sharing it is mutated (copy-on-write).
+//Define NUMTYPE_NONATOMIC_REFCOUNT when values are never shared across threads
+//to use plain counters instead of atomics.
+template<typename T>
+struct SharedGmp{
+#ifdef NUMTYPE_NONATOMIC_REFCOUNT
+    uint32_t refs;
+#else
+    std::atomic<uint32_t> refs;
+#endif
+    T val;
+
+    template<typename... Args>
+    explicit SharedGmp(Args&&... args) : refs(1), val(std::forward<Args>(args)...) {}
+
+    inline void retain() noexcept{
+#ifdef NUMTYPE_NONATOMIC_REFCOUNT
+        refs++;
+#else
+        refs.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    inline void release() noexcept{
+#ifdef NUMTYPE_NONATOMIC_REFCOUNT
+        if(--refs == 0) delete this;
+#else
+        if(refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+#endif
+    }
+
+    inline bool unique() const noexcept{
+#ifdef NUMTYPE_NONATOMIC_REFCOUNT
+        return refs == 1;
+#else
+        return refs.load(std::memory_order_acquire) == 1;
+#endif
+    }
+};
+
+typedef SharedGmp<mpz_class> SharedBigInt;
+typedef SharedGmp<mpq_class> SharedBigRat;
+
+//Per-thread GMP registers for the temporaries of hot paths.
+//Registers are borrowed in stack order through ScratchInt/ScratchRat and keep
+//their limbs between uses, so steady-state calls don't allocate. Borrowers nested
+//deeper than the pool get a heap allocated temporary of their own instead.
+struct GmpScratch{
+    static constexpr size_t num_registers = 8;
+    static constexpr mp_bitcnt_t initial_bits = 256;
+
+    mpz_t ints[num_registers];
+    mpq_t rats[num_registers];
+    size_t ints_used = 0;
+    size_t rats_used = 0;
+
+    GmpScratch(){
+        for(size_t i = 0; i < num_registers; i++){
+            mpz_init2(ints[i], initial_bits);
+            mpq_init(rats[i]);
+            mpz_realloc2(mpq_numref(rats[i]), initial_bits);
+            mpz_realloc2(mpq_denref(rats[i]), initial_bits);
+        }
+    }
+
+    ~GmpScratch(){
+        for(size_t i = 0; i < num_registers; i++){
+            mpz_clear(ints[i]);
+            mpq_clear(rats[i]);
+        }
+    }
+
+    GmpScratch(const GmpScratch&) = delete;
+    GmpScratch& operator=(const GmpScratch&) = delete;
+
+    static GmpScratch& local(){
+        thread_local GmpScratch scratch;
+        return scratch;
+    }
+};
+
+struct ScratchInt{
+    GmpScratch& pool;
+    mpz_ptr z;
+    mpz_t spill;
+
+    ScratchInt() : pool(GmpScratch::local()){
+        if(pool.ints_used < GmpScratch::num_registers){
+            z = pool.ints[pool.ints_used];
+        }else{
+            mpz_init2(spill, GmpScratch::initial_bits);
+            z = spill;
+        }
+        pool.ints_used++;
+    }
+    ~ScratchInt(){
+        if(--pool.ints_used >= GmpScratch::num_registers) mpz_clear(spill);
+    }
+    ScratchInt(const ScratchInt&) = delete;
+    ScratchInt& operator=(const ScratchInt&) = delete;
+
+    operator mpz_ptr() const noexcept{
+        return z;
+    }
+};
+
+struct ScratchRat{
+    GmpScratch& pool;
+    mpq_ptr q;
+    mpq_t spill;
+
+    ScratchRat() : pool(GmpScratch::local()){
+        if(pool.rats_used < GmpScratch::num_registers){
+            q = pool.rats[pool.rats_used];
+        }else{
+            mpq_init(spill);
+            q = spill;
+        }
+        pool.rats_used++;
+    }
+    ~ScratchRat(){
+        if(--pool.rats_used >= GmpScratch::num_registers) mpq_clear(spill);
+    }
+    ScratchRat(const ScratchRat&) = delete;
+    ScratchRat& operator=(const ScratchRat&) = delete;
+
+    operator mpq_ptr() const noexcept{
+        return q;
+    }
+};
+
+#ifndef __SIZEOF_INT128__
+#error "The WideInt tier needs a compiler with __int128"
+#endif
+
+typedef __int128 WideWord;
+typedef unsigned __int128 UnsignedWideWord;
+
+//WideInt values live in 16 byte blocks recycled through a per-thread free list,
+//so an integer that outgrows 32 bits costs neither a malloc nor a GMP call in steady state.
+struct WideSlab{
+    union Block{
+        WideWord val;
+        Block* next;
+    };
+
+    static constexpr size_t max_free = 4096;
+
+    //Trivially destructible, so it stays usable while other thread_locals are torn down
+    struct FreeList{
+        Block* head;
+        size_t count;
+        bool closed;
+    };
+
+    static FreeList& freeList() noexcept{
+        thread_local FreeList list = {nullptr, 0, false};
+        return list;
+    }
+
+    //Hands the cached blocks back to the heap when the thread exits
+    struct Drain{
+        ~Drain(){
+            FreeList& list = freeList();
+            list.closed = true;
+            while(list.head){
+                Block* block = list.head;
+                list.head = block->next;
+                delete block;
+            }
+            list.count = 0;
+        }
+    };
+
+    static WideWord* acquire(WideWord val){
+        FreeList& list = freeList();
+        Block* block;
+        if(list.head){
+            block = list.head;
+            list.head = block->next;
+            list.count--;
+        }else{
+            thread_local Drain drain;
+            (void)drain;
+            block = new Block;
+        }
+        block->val = val;
+        return &block->val;
+    }
+
+    static void release(WideWord* val) noexcept{
+        Block* block = reinterpret_cast<Block*>(val);
+        FreeList& list = freeList();
+        if(list.closed || list.count >= max_free){
+            delete block;
+        }else{
+            block->next = list.head;
+            list.head = block;
+            list.count++;
+        }
+    }
+};
+
+//Define NUMTYPE_TRACE to log the arithmetic and comparisons of any thread running a TraceRecorder
+//(num_trace.h), for replay with trace_replay. Otherwise the hooks compile to nothing.
+//A scope only records when it is the outermost one, so operations built from others are logged once.
+#ifdef NUMTYPE_TRACE
+struct NumType;
+struct TraceScope{
+    TraceScope(char op, const NumType& lhs, const NumType& rhs);
+    TraceScope(char op, const NumType& lhs, WideWord rhs);
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+    ~TraceScope();
+};
+#define NUMTYPE_TRACE_OP(op, rhs) TraceScope trace_scope(op, *this, rhs)
+#else
+#define NUMTYPE_TRACE_OP(op, rhs)
+#endif
+
+//Define NUMTYPE_STATS to keep per thread histograms of operand bit lengths for each operation and
+//of latencies for each typePair (num_stats.h). Otherwise the hooks compile to nothing. As with
+//traces, only the outermost operation is measured.
+#ifdef NUMTYPE_STATS
+struct NumType;
+struct StatsScope{
+    uint64_t start;
+    uint32_t pair;
+    StatsScope(char op, const NumType& lhs, const NumType& rhs);
+    StatsScope(char op, const NumType& lhs, WideWord rhs);
+    StatsScope(const StatsScope&) = delete;
+    StatsScope& operator=(const StatsScope&) = delete;
+    ~StatsScope();
+};
+#define NUMTYPE_STATS_OP(op, rhs) StatsScope stats_scope(op, *this, rhs)
+#else
+#define NUMTYPE_STATS_OP(op, rhs)
+#endif
+
+//The trace scope opens first, so recording a trace is not counted in the latencies
+#define NUMTYPE_OP_HOOK(op, rhs) NUMTYPE_TRACE_OP(op, rhs); NUMTYPE_STATS_OP(op, rhs)
+
+#ifndef NUMTYPE_BINOMIAL_CACHE_SIZE
+#define NUMTYPE_BINOMIAL_CACHE_SIZE 256
+#endif
+
+//Every factorial that fits a WordInt, and all of Pascal's triangle up to the first row with a
+//coefficient that does not. Past that row C(n,k) with k <= n/2 fits exactly when n <= max_n[k].
+struct WordCombinatorics{
+    static constexpr uint32_t num_factorials = 13;
+    static constexpr uint32_t pascal_rows = 34;
+    static constexpr uint32_t num_bounds = 17;
+
+    struct Tables{
+        int32_t factorial[num_factorials] = {};
+        int32_t pascal[pascal_rows*(pascal_rows+1)/2] = {};
+        uint32_t max_n[num_bounds] = {};
+    };
+
+    static constexpr uint32_t rowStart(uint32_t n) noexcept{
+        return n*(n+1)/2;
+    }
+
+    //Largest n >= 2k with C(n,k) <= INT32_MAX, found by walking down the k-th diagonal
+    static constexpr uint32_t maxBinomialN(uint32_t k) noexcept{
+        uint64_t c = 1; //C(2k, k)
+        for(uint64_t i = 1; i <= k; i++) c = c * (k+i) / i;
+        uint32_t n = 2*k;
+        while(c <= INT32_MAX){
+            c = c * (n+1) / (n+1-k);
+            n++;
+        }
+        return n-1;
+    }
+
+    static constexpr Tables build() noexcept{
+        Tables t;
+        t.factorial[0] = 1;
+        for(uint32_t i = 1; i < num_factorials; i++) t.factorial[i] = t.factorial[i-1] * int32_t(i);
+
+        for(uint32_t n = 0; n < pascal_rows; n++){
+            t.pascal[rowStart(n)] = t.pascal[rowStart(n)+n] = 1;
+            for(uint32_t k = 1; k < n; k++)
+                t.pascal[rowStart(n)+k] = t.pascal[rowStart(n-1)+k-1] + t.pascal[rowStart(n-1)+k];
+        }
+
+        t.max_n[0] = std::numeric_limits<uint32_t>::max();
+        t.max_n[1] = std::numeric_limits<int32_t>::max();
+        for(uint32_t k = 2; k < num_bounds; k++) t.max_n[k] = maxBinomialN(k);
+        return t;
+    }
+
+    static const Tables tables;
+};
+
+inline constexpr WordCombinatorics::Tables WordCombinatorics::tables = WordCombinatorics::build();
+
+static_assert(WordCombinatorics::tables.factorial[12] == 479001600, "12! is the largest int32 factorial");
+static_assert(WordCombinatorics::tables.pascal[WordCombinatorics::rowStart(33) + 16] == 1166803110,
+              "Row 33 is the last row of Pascal's triangle that fits an int32");
+static_assert(WordCombinatorics::tables.max_n[2] == 65536, "C(65536,2) is the largest int32 pair count");
+static_assert(WordCombinatorics::maxBinomialN(16) == 33, "C(34,17) overflows an int32");
+
 struct NumType{
     void* data;
     Type type;
+    uint32_t reserved_bits = 0; //Capacity requested through reserve(), kept in what would be padding
 
     inline int64_t asWordInt() const noexcept {
         assert(type == WordInt);
@@ -44,241 +367,1441 @@ struct NumType{
         assert(type == WordRat);
         return static_cast<rat64_t>(data);
     }
-    inline mpz_class& asBigInt() const noexcept {
+    inline WideWord* wideSlot() const noexcept {
+        assert(type == WideInt);
+        return reinterpret_cast<WideWord*>(data);
+    }
+    inline WideWord asWide() const noexcept {
+        return *wideSlot();
+    }
+    //Either integer word tier as a 128 bit value
+    inline WideWord wideOperand() const noexcept {
+        return type == WideInt ? asWide() : static_cast<WideWord>(asWordInt());
+    }
+    //Either word tier as a rat64_t
+    inline rat64_t wordOperand() const noexcept {
+        return type == WordInt ? rat64_t(static_cast<int32_t>(asWordInt())) : asWordRat();
+    }
+    //Dyadic values are packed as m*2^8 + e
+    inline int64_t dyadicMantissa() const noexcept {
+        assert(type == Dyadic);
+        return reinterpret_cast<int64_t>(data) >> 8;
+    }
+    inline uint32_t dyadicExponent() const noexcept {
+        assert(type == Dyadic);
+        return static_cast<uint32_t>(reinterpret_cast<uint64_t>(data) & 0xff);
+    }
+    //The value as m/2^e, if it is dyadic: the integer tiers, Dyadic, and word fractions over a power of two
+    inline bool dyadicOperand(WideWord& m, uint32_t& e) const noexcept {
+        switch (type) {
+            case Dyadic:
+                m = dyadicMantissa();
+                e = dyadicExponent();
+                return true;
+            case WordInt:
+            case WideInt:
+                m = wideOperand();
+                e = 0;
+                return true;
+            case WordRat:{
+                const rat64_t q = asWordRat();
+                if(q.den & (q.den - 1)) return false;
+                m = q.num;
+                e = rat64_t::bitLength(q.den) - 1;
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+    //Decimal values are packed as m*2^5 + s
+    inline int64_t decimalMantissa() const noexcept {
+        assert(type == Decimal);
+        return reinterpret_cast<int64_t>(data) >> 5;
+    }
+    inline uint32_t decimalScale() const noexcept {
+        assert(type == Decimal);
+        return static_cast<uint32_t>(reinterpret_cast<uint64_t>(data) & 0x1f);
+    }
+    //The value as m/10^s with s <= 18, if it has one: the integer tiers, Decimal, and word or dyadic
+    //fractions whose denominator divides 10^18
+    inline bool decimalOperand(WideWord& m, uint32_t& s) const noexcept {
+        switch (type) {
+            case Decimal:
+                m = decimalMantissa();
+                s = decimalScale();
+                return true;
+            case WordInt:
+            case WideInt:
+                m = wideOperand();
+                s = 0;
+                return true;
+            case WordRat:{
+                const rat64_t q = asWordRat();
+                const uint32_t twos = __builtin_ctz(q.den);
+                uint32_t odd = q.den >> twos;
+                uint32_t fives = 0;
+                for(; odd % 5 == 0; odd /= 5) fives++;
+                if(odd != 1 || twos > max_decimal_scale) return false;
+                s = std::max(twos, fives);
+                m = static_cast<WideWord>(q.num) * static_cast<int64_t>(powers_of_ten[s] / q.den);
+                return true;
+            }
+            case Dyadic:
+                if(dyadicExponent() > max_decimal_scale) return false;
+                s = dyadicExponent();
+                m = static_cast<WideWord>(dyadicMantissa()) * static_cast<int64_t>(powers_of_ten[s] >> s);
+                return true;
+            default:
+                return false;
+        }
+    }
+    inline SharedBigInt* bigIntPayload() const noexcept {
         assert(type == GmpInt);
-        return *reinterpret_cast<mpz_class*>(data);
+        return reinterpret_cast<SharedBigInt*>(data);
     }
-    inline mpq_class& asBigRat() const noexcept {
+    inline SharedBigRat* bigRatPayload() const noexcept {
         assert(type == GmpRat);
-        return *reinterpret_cast<mpq_class*>(data);
+        return reinterpret_cast<SharedBigRat*>(data);
     }
-    inline mpz_class* takeOwnerShipOfBigInt() noexcept{
-        assert(type == GmpInt);
+    inline const mpz_class& asBigInt() const noexcept {
+        return bigIntPayload()->val;
+    }
+    inline const mpq_class& asBigRat() const noexcept {
+        return bigRatPayload()->val;
+    }
+    inline mpz_class& mutableBigInt(){
+        SharedBigInt* payload = bigIntPayload();
+        if(!payload->unique()){
+            SharedBigInt* clone = new SharedBigInt(payload->val);
+            payload->release();
+            data = payload = clone;
+        }
+        return payload->val;
+    }
+    inline mpq_class& mutableBigRat(){
+        SharedBigRat* payload = bigRatPayload();
+        if(!payload->unique()){
+            SharedBigRat* clone = new SharedBigRat(payload->val);
+            payload->release();
+            data = payload = clone;
+        }
+        return payload->val;
+    }
+    inline void releaseBig() noexcept{
+        if(type == GmpInt) bigIntPayload()->release();
+        else if(type == GmpRat) bigRatPayload()->release();
+        else if(type == WideInt) WideSlab::release(wideSlot());
+    }
+    inline void retainBig() const noexcept{
+        if(type == GmpInt) bigIntPayload()->retain();
+        else if(type == GmpRat) bigRatPayload()->retain();
+    }
+    inline mpz_class* takeOwnerShipOfBigInt(){
+        mpz_class* owned = new mpz_class(std::move(mutableBigInt()));
+        bigIntPayload()->release();
+        data = 0;
         type = WordInt;
-        return reinterpret_cast<mpz_class*>(data);
+        return owned;
     }
-    inline mpq_class* takeOwnerShipOfBigRat() noexcept{
-        assert(type == GmpRat);
+    inline mpq_class* takeOwnerShipOfBigRat(){
+        mpq_class* owned = new mpq_class(std::move(mutableBigRat()));
+        bigRatPayload()->release();
+        data = 0;
         type = WordInt;
-        return reinterpret_cast<mpq_class*>(data);
+        return owned;
     }
 
-    void bigIntReduce() noexcept{
-        auto z = asBigInt();
-        if(z <= std::numeric_limits<int32_t>::max() && z > std::numeric_limits<int32_t>::min()){
-            int64_t next = z.get_si();
-            delete reinterpret_cast<mpz_class*>(data);
-            data = reinterpret_cast<void*>(next);
-            type = WordInt;
-        }
+    static constexpr mp_bitcnt_t wide_bits = 127;
+
+    static WideWord getWide(mpz_srcptr z) noexcept{
+        assert(mpz_sizeinbase(z, 2) <= wide_bits);
+        uint64_t limbs[2] = {0, 0};
+        mpz_export(limbs, nullptr, -1, sizeof(uint64_t), 0, 0, z);
+        const UnsignedWideWord magnitude = (static_cast<UnsignedWideWord>(limbs[1]) << 64) | limbs[0];
+        return mpz_sgn(z) < 0 ? -static_cast<WideWord>(magnitude) : static_cast<WideWord>(magnitude);
     }
 
-    template<bool canonicalize = true>
-    void bigRatReduce(){
-        auto r = asBigRat();
-        if(canonicalize) r.canonicalize();
+    static mp_bitcnt_t wideBitLength(WideWord val) noexcept{
+        const UnsignedWideWord magnitude = val < 0 ? -static_cast<UnsignedWideWord>(val) : val;
+        const uint64_t high = static_cast<uint64_t>(magnitude >> 64);
+        return high ? 64 + rat64_t::bitLength(high) : rat64_t::bitLength(static_cast<uint64_t>(magnitude));
+    }
 
-        if(r.get_den() == 1){
-            if(r.get_num() <= std::numeric_limits<int32_t>::max() &&
-               r.get_num() > std::numeric_limits<int32_t>::min()){
-                int64_t next = r.get_num().get_si();
-                delete reinterpret_cast<mpq_class*>(data);
-                data = reinterpret_cast<void*>(next);
-                type = WordInt;
+    static void setWide(mpz_ptr rop, WideWord val){
+        const UnsignedWideWord magnitude = val < 0 ? -static_cast<UnsignedWideWord>(val) : val;
+        const uint64_t limbs[2] = {static_cast<uint64_t>(magnitude), static_cast<uint64_t>(magnitude >> 64)};
+        mpz_import(rop, 2, -1, sizeof(uint64_t), 0, 0, limbs);
+        if(val < 0) mpz_neg(rop, rop);
+    }
+
+    //Stores an integer result in the narrowest tier. Must not be called while holding a GMP payload.
+    void storeWide(WideWord val){
+        assert(!isGmp());
+        if(val <= std::numeric_limits<int32_t>::max() && val > std::numeric_limits<int32_t>::min()){
+            if(type == WideInt) WideSlab::release(wideSlot());
+            data = reinterpret_cast<void*>(static_cast<int64_t>(val));
+            type = WordInt;
+        }else if(val != static_cast<WideWord>(static_cast<UnsignedWideWord>(1) << wide_bits)){ //-2^127
+            if(type == WideInt){
+                *wideSlot() = val;
             }else{
-                mpz_class* next = new mpz_class(r.get_num());
-                delete reinterpret_cast<mpq_class*>(data);
-                data = next;
-                type = GmpInt;
+                data = WideSlab::acquire(val);
+                type = WideInt;
             }
-        }else if(r.get_den() <= std::numeric_limits<uint32_t>::max() &&
-                 r.get_num() <= std::numeric_limits<int32_t>::max() &&
-                 r.get_num() > std::numeric_limits<int32_t>::min()){
-            rat64_t next(r.get_num().get_si(), r.get_den().get_ui());
-            delete reinterpret_cast<mpq_class*>(data);
+        }else{
+            releaseBig();
+            SharedBigInt* next = sizedBigInt(128);
+            setWide(next->val.get_mpz_t(), val);
             data = next;
-            type = WordRat;
+            type = GmpInt;
         }
     }
 
-    void wordRatReduce() noexcept{
-        rat64_t r = asWordRat();
-        r.canonicalize();
+    static NumType fromWide(WideWord val){
+        NumType ans;
+        ans.storeWide(val);
+        return ans;
+    }
 
-        if(r.den==1){
-            data = reinterpret_cast<void*>(r.num);
-            type = WordInt;
+    //Moves a WideInt onto a GMP payload for the operations that have no two limb kernel
+    void widenToBig(){
+        const WideWord val = asWide();
+        WideSlab::release(wideSlot());
+        SharedBigInt* next = promotedBigInt(128);
+        setWide(next->val.get_mpz_t(), val);
+        data = next;
+        type = GmpInt;
+    }
+
+    NumType wideToBig() const{
+        NumType ans(*this);
+        ans.widenToBig();
+        return ans;
+    }
+
+    static constexpr int64_t dyadic_mantissa_limit = int64_t(1) << 55;
+    static constexpr uint32_t max_dyadic_exponent = 255;
+
+    static uint32_t wideTrailingZeros(UnsignedWideWord x) noexcept{
+        assert(x != 0);
+        const uint64_t low = static_cast<uint64_t>(x);
+        return low ? __builtin_ctzll(low) : 64 + __builtin_ctzll(static_cast<uint64_t>(x >> 64));
+    }
+
+    //Stores m/2^e in its canonical tier. Must not be called while holding a GMP payload.
+    void storeDyadic(WideWord m, uint32_t e){
+        if(m != 0 && e != 0){
+            const uint32_t shift = std::min(e, wideTrailingZeros(static_cast<UnsignedWideWord>(m)));
+            m >>= shift;
+            e -= shift;
+        }
+        if(m == 0 || e == 0){
+            storeWide(m);
+        }else if(e <= max_dyadic_exponent && m < dyadic_mantissa_limit && m > -dyadic_mantissa_limit){
+            if(type == WideInt) WideSlab::release(wideSlot());
+            data = reinterpret_cast<void*>(static_cast<uint64_t>(static_cast<int64_t>(m)) << 8 | e);
+            type = Dyadic;
         }else{
-            data = r;
+            releaseBig();
+            SharedBigRat* next = sizedBigRat(wideBitLength(m), e + 1);
+            setWide(mpq_numref(next->val.get_mpq_t()), m);
+            mpz_set_ui(mpq_denref(next->val.get_mpq_t()), 0);
+            mpz_setbit(mpq_denref(next->val.get_mpq_t()), e);
+            data = next;
+            type = GmpRat;
         }
     }
 
-    void reduce(){
+    static NumType dyadic(int64_t mantissa, uint32_t exponent){
+        NumType ans;
+        ans.storeDyadic(mantissa, exponent);
+        return ans;
+    }
+
+    //Every finite double is a dyadic rational, so the conversion is exact
+    static NumType fromDouble(double val){
+        assert(isfinite(val));
+        int exponent;
+        const int64_t mantissa = static_cast<int64_t>(ldexp(frexp(val, &exponent), 53));
+        const int shift = exponent - 53;
+        if(shift <= 0) return dyadic(mantissa, -shift);
+        if(shift <= 126 - 53) return fromWide(mantissa * (static_cast<WideWord>(1) << shift));
+        ScratchInt z;
+        setInt64(z, mantissa);
+        mpz_mul_2exp(z, z, shift);
+        return fromScratch(z.z);
+    }
+
+    //The nearest double for the word and packed tiers. GMP values are truncated, as by mpz_get_d and mpq_get_d.
+    double toDouble() const{
         switch (type) {
-            case WordRat: wordRatReduce(); break;
-            case GmpInt: bigIntReduce(); break;
-            case GmpRat: bigRatReduce(); break;
-            case WordInt: break;
+            case WordInt: return static_cast<double>(asWordInt());
+            case WordRat: return static_cast<double>(asWordRat());
+            case WideInt: return static_cast<double>(asWide());
+            case Dyadic: return ldexp(static_cast<double>(dyadicMantissa()), -static_cast<int>(dyadicExponent()));
+            case Decimal: return static_cast<double>(decimalMantissa()) / static_cast<double>(powers_of_ten[decimalScale()]);
+            case GmpInt: return asBigInt().get_d();
+            case GmpRat: return asBigRat().get_d();
         }
+        return 0;
     }
 
-    inline mpz_class toBigInt(int64_t z){
-        mpz_class big((int32_t)(z >> 32));
-        mpz_mul_2exp(big.get_mpz_t(), big.get_mpz_t(), 32);
-        mpz_add_ui(big.get_mpz_t(), big.get_mpz_t(), (uint32_t)z);
-        return big;
+    //The same value in the rational tiers, for the operations without a dyadic kernel
+    NumType dyadicToRat() const{
+        const int64_t m = dyadicMantissa();
+        const uint32_t e = dyadicExponent();
+        if(e < 32 && fitsWordInt(m)) return NumType(rat64_t(static_cast<int32_t>(m), uint32_t(1) << e));
+        NumType ans;
+        SharedBigRat* payload = sizedBigRat(64, e + 1);
+        setInt64(mpq_numref(payload->val.get_mpq_t()), m);
+        mpz_set_ui(mpq_denref(payload->val.get_mpq_t()), 0);
+        mpz_setbit(mpq_denref(payload->val.get_mpq_t()), e);
+        ans.data = payload;
+        ans.type = GmpRat;
+        return ans;
     }
 
-    void wordIntClamp(){
-        assert(type == WordInt);
-        int64_t z = reinterpret_cast<int64_t>(data);
-        if(z > std::numeric_limits<int32_t>::max() || z <= std::numeric_limits<int32_t>::min()){
-            mpz_class* next = new mpz_class((int32_t)(z >> 32));
-            mpz_mul_2exp(next->get_mpz_t(), next->get_mpz_t(), 32);
-            mpz_add_ui(next->get_mpz_t(), next->get_mpz_t(), (uint32_t)z);
-            data = next;
-            type = GmpInt;
+    //Shifts the mantissa with the smaller exponent so both are over 2^max(ea, eb), false if it would pass 126 bits
+    static bool alignDyadic(WideWord& a, uint32_t ea, WideWord& b, uint32_t eb) noexcept{
+        if(ea < eb) return alignDyadic(b, eb, a, ea);
+        const uint32_t shift = ea - eb;
+        if(b == 0 || shift == 0) return true;
+        if(wideBitLength(b) + shift > 126) return false;
+        b = static_cast<WideWord>(static_cast<UnsignedWideWord>(b) << shift);
+        return true;
+    }
+
+    //Dyadic kernels are shifts and 128 bit integer ops with no gcd. They return false, leaving this
+    //unchanged, when an operand is not dyadic or a mantissa would not fit.
+    bool setDyadicSum(const NumType& other){
+        WideWord a, b;
+        uint32_t ea, eb;
+        WideWord sum;
+        if(!dyadicOperand(a, ea) || !other.dyadicOperand(b, eb) || !alignDyadic(a, ea, b, eb) ||
+           __builtin_add_overflow(a, b, &sum))
+            return false;
+        storeDyadic(sum, std::max(ea, eb));
+        return true;
+    }
+
+    bool setDyadicProduct(const NumType& other){
+        WideWord a, b;
+        uint32_t ea, eb;
+        WideWord product;
+        if(!dyadicOperand(a, ea) || !other.dyadicOperand(b, eb) || __builtin_mul_overflow(a, b, &product))
+            return false;
+        storeDyadic(product, ea + eb);
+        return true;
+    }
+
+    //Only a divisor whose odd part is 1 keeps the quotient dyadic
+    bool setDyadicQuotient(const NumType& other){
+        WideWord a, b;
+        uint32_t ea, eb;
+        if(!dyadicOperand(a, ea) || !other.dyadicOperand(b, eb)) return false;
+        assert(b != 0);
+        const UnsignedWideWord magnitude = b < 0 ? -static_cast<UnsignedWideWord>(b) : b;
+        if(magnitude & (magnitude - 1)) return false;
+        if(b < 0) a = -a;
+        const int64_t e = int64_t(ea) + wideTrailingZeros(magnitude) - int64_t(eb);
+        if(e >= 0){
+            storeDyadic(a, static_cast<uint32_t>(e));
+        }else if(a == 0){
+            storeWide(0);
+        }else{
+            if(wideBitLength(a) - e > 126) return false;
+            storeWide(static_cast<WideWord>(static_cast<UnsignedWideWord>(a) << -e));
         }
+        return true;
     }
 
-    NumType() : data(0), type(WordInt) {}
-    NumType(int32_t val) : data(reinterpret_cast<void*>(val)), type(WordInt) {}
-    NumType(const rat64_t& r) : data(r), type(WordRat) {}
-    NumType(rat64_t::SignedHalfWord num, rat64_t::UnsignedHalfWord den) : data(rat64_t(num, den)), type(WordRat){}
-    NumType(const mpz_class& val) : data(new mpz_class(val)), type(GmpInt) {}
-    NumType(const mpq_class& val) : data(new mpq_class(val)), type(GmpRat) {}
-    ~NumType(){
-        if(type == GmpInt) delete reinterpret_cast<mpz_class*>(data);
-        else if(type == GmpRat) delete reinterpret_cast<mpq_class*>(data);
+    //Big dyadic values are a GmpInt, or a GmpRat over a power of two
+    static bool bigDyadicExponent(mpz_srcptr den, mp_bitcnt_t& e) noexcept{
+        if(den == nullptr){
+            e = 0;
+            return true;
+        }
+        e = mpz_scan1(den, 0);
+        return mpz_sizeinbase(den, 2) == e + 1;
     }
-    NumType(const NumType& other){
-        type = other.type;
 
-        //std::cout << "Copy constructor" << std::endl;
+    //The dyadic kernels for sums and products past 128 bits, which shift instead of taking the gcd of mpq_add
+    template<bool product>
+    bool setBigDyadic(const NumType& other){
+        ScratchRat lhs_scratch, rhs_scratch;
+        mpz_srcptr lhs_num, lhs_den, rhs_num, rhs_den;
+        fractionView(lhs_scratch, lhs_num, lhs_den);
+        other.fractionView(rhs_scratch, rhs_num, rhs_den);
+        mp_bitcnt_t lhs_e, rhs_e;
+        if(!bigDyadicExponent(lhs_den, lhs_e) || !bigDyadicExponent(rhs_den, rhs_e)) return false;
 
-        if(type == GmpInt){
-            data = reinterpret_cast<void*>(new mpz_class(other.asBigInt()));
-        }else if(type == GmpRat){
-            data = reinterpret_cast<void*>(new mpq_class(other.asBigRat()));
+        ScratchInt num;
+        mp_bitcnt_t e;
+        if(product){
+            mpz_mul(num, lhs_num, rhs_num);
+            e = lhs_e + rhs_e;
+        }else{
+            ScratchInt aligned;
+            e = std::max(lhs_e, rhs_e);
+            mpz_mul_2exp(num, lhs_num, e - lhs_e);
+            mpz_mul_2exp(aligned, rhs_num, e - rhs_e);
+            mpz_add(num, num, aligned);
+        }
+        if(mpz_sgn(num.z) == 0){
+            setZero();
+            return true;
+        }
+        const mp_bitcnt_t shift = std::min(e, mpz_scan1(num, 0));
+        mpz_tdiv_q_2exp(num, num, shift);
+        e -= shift;
+
+        if(e == 0){
+            *this = fromScratch(num.z);
+        }else if(e <= max_dyadic_exponent && mpz_sizeinbase(num, 2) < 56){
+            releaseBig();
+            type = WordInt;
+            storeDyadic(getWide(num), static_cast<uint32_t>(e));
         }else{
-            data = other.data;
+            if(type != GmpRat){
+                releaseBig();
+                data = sizedBigRat(mpz_sizeinbase(num, 2), e + 1);
+                type = GmpRat;
+            }
+            mpq_class& q = mutableBigRat();
+            mpz_swap(q.get_num_mpz_t(), num);
+            mpz_set_ui(q.get_den_mpz_t(), 0);
+            mpz_setbit(q.get_den_mpz_t(), e);
         }
+        return true;
     }
-    NumType(NumType&& other) noexcept{
-        type = other.type;
-        data = other.data;
-        other.type = WordInt; //You gave me any pointers, so don't free them!
+
+    //Sign of (this - other) for a Dyadic against any tier
+    int compareDyadic(const NumType& other) const{
+        WideWord a, b;
+        uint32_t ea, eb;
+        if(dyadicOperand(a, ea) && other.dyadicOperand(b, eb) && alignDyadic(a, ea, b, eb))
+            return (a > b) - (a < b);
+        return compareFractions(other);
     }
-    NumType& operator=(NumType&& other) noexcept{
-        type = other.type;
-        data = other.data;
-        other.type = WordInt; //You gave me any pointers, so don't free them!
-        return *this;
+
+    //Sign of (this - other) by cross multiplying the fraction views
+    int compareFractions(const NumType& other) const{
+        ScratchRat lhs_scratch, rhs_scratch;
+        mpz_srcptr lhs_num, lhs_den, rhs_num, rhs_den;
+        fractionView(lhs_scratch, lhs_num, lhs_den);
+        other.fractionView(rhs_scratch, rhs_num, rhs_den);
+        ScratchInt lhs, rhs;
+        if(rhs_den) mpz_mul(lhs, lhs_num, rhs_den);
+        else mpz_set(lhs, lhs_num);
+        if(lhs_den) mpz_mul(rhs, rhs_num, lhs_den);
+        else mpz_set(rhs, rhs_num);
+        return mpz_cmp(lhs, rhs);
     }
-    NumType& operator=(const NumType& other){
-        if(type == GmpInt) delete reinterpret_cast<mpz_class*>(data);
-        else if(type == GmpRat) delete reinterpret_cast<mpq_class*>(data);
 
-        type = other.type;
+    static constexpr int64_t decimal_mantissa_limit = int64_t(1) << 58;
+    static constexpr uint32_t max_decimal_scale = 18;
+    static constexpr uint64_t powers_of_ten[20] = {
+        1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+        1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+        100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+        1000000000000000000ull, 10000000000000000000ull};
+
+    //10^s for s <= 38
+    static UnsignedWideWord widePowerOfTen(uint32_t s) noexcept{
+        assert(s <= 38);
+        if(s < 20) return powers_of_ten[s];
+        return static_cast<UnsignedWideWord>(powers_of_ten[s - 19]) * powers_of_ten[19];
+    }
 
-        if(other.type == GmpInt){
-            data = reinterpret_cast<void*>(new mpz_class(other.asBigInt()));
-        }else if(other.type == GmpRat){
-            data = reinterpret_cast<void*>(new mpq_class(other.asBigRat()));
+    //m/10^s in lowest terms, which only takes cancelling the factors of 2 and 5 shared with m
+    static void decimalFraction(WideWord m, uint32_t s, WideWord& num, WideWord& den) noexcept{
+        assert(s <= 38);
+        if(m == 0){
+            num = 0;
+            den = 1;
+            return;
+        }
+        const uint32_t twos = std::min(s, wideTrailingZeros(static_cast<UnsignedWideWord>(m)));
+        m >>= twos;
+        uint32_t fives = 0;
+        for(; fives < s && m % 5 == 0; m /= 5) fives++;
+        num = m;
+        den = static_cast<WideWord>((widePowerOfTen(s - fives) >> (s - fives)) << (s - twos));
+    }
+
+    //Stores m/10^s in its canonical tier for s <= 36. Must not be called while holding a GMP payload.
+    void storeDecimal(WideWord m, uint32_t s){
+        assert(s <= 2*max_decimal_scale);
+        if(m >= std::numeric_limits<int64_t>::min() && m <= std::numeric_limits<int64_t>::max()){
+            int64_t small = static_cast<int64_t>(m);
+            for(; s != 0 && small % 10 == 0; s--) small /= 10;
+            m = small;
+        }else{
+            for(; s != 0 && m % 10 == 0; s--) m /= 10;
+        }
+        if(s == 0){
+            storeWide(m);
+        }else if(s <= max_decimal_scale && m < decimal_mantissa_limit && m > -decimal_mantissa_limit){
+            if(type == WideInt) WideSlab::release(wideSlot());
+            data = reinterpret_cast<void*>(static_cast<uint64_t>(static_cast<int64_t>(m)) << 5 | s);
+            type = Decimal;
         }else{
-            data = other.data;
+            WideWord num, den;
+            decimalFraction(m, s, num, den);
+            storeWideFraction(num, den);
         }
+    }
 
-        return *this;
+    static NumType decimal(int64_t mantissa, uint32_t scale){
+        assert(scale <= max_decimal_scale);
+        NumType ans;
+        ans.storeDecimal(mantissa, scale);
+        return ans;
     }
 
-    std::string toString() const{
-        switch (type) {
-            case WordInt: return std::to_string(asWordInt());
-            case WordRat: return asWordRat().toStr();
-            case GmpInt: return asBigInt().get_str();
-            case GmpRat: return asBigRat().get_str();
-            default: assert(false);
+    //Parses [-]digits[.digits] exactly. Only text past 128 bits or 36 fractional digits is read by GMP.
+    static NumType parseDecimal(const std::string& text){
+        size_t i = 0;
+        const bool negative = !text.empty() && text[0] == '-';
+        if(negative) i++;
+
+        constexpr UnsignedWideWord max_magnitude = static_cast<UnsignedWideWord>(-1) >> 1;
+        UnsignedWideWord magnitude = 0;
+        bool fits = true;
+        bool point = false;
+        uint32_t scale = 0;
+        size_t digits = 0;
+        for(; i < text.size(); i++){
+            if(text[i] == '.' && !point){
+                point = true;
+                continue;
+            }
+            if(text[i] < '0' || text[i] > '9') throw std::invalid_argument("decimal text is not of the form [-]d.d");
+            const uint32_t digit = static_cast<uint32_t>(text[i] - '0');
+            if(magnitude > (max_magnitude - digit) / 10) fits = false;
+            else magnitude = 10*magnitude + digit;
+            scale += point;
+            digits++;
+        }
+        if(digits == 0) throw std::invalid_argument("decimal text is missing digits");
+
+        if(fits && scale <= 2*max_decimal_scale){
+            NumType ans;
+            ans.storeDecimal(negative ? -static_cast<WideWord>(magnitude) : static_cast<WideWord>(magnitude), scale);
+            return ans;
         }
+        std::string integer;
+        integer.reserve(text.size());
+        for(char c : text) if(c != '.') integer.push_back(c);
+        ScratchRat q;
+        mpz_set_str(mpq_numref(q.q), integer.c_str(), 10);
+        mpz_ui_pow_ui(mpq_denref(q.q), 10, scale);
+        mpq_canonicalize(q);
+        return fromScratch(q.q);
     }
 
-    friend std::ostream& operator<<(std::ostream& out, const NumType& num){
-        out << num.toString();
-        return out;
+    //Decimal text for values with a terminating expansion of at most 18 fractional digits, a fraction otherwise
+    std::string toDecimalString() const{
+        WideWord m;
+        uint32_t s;
+        if(!decimalOperand(m, s)) return toString();
+        if(s == 0) return wideToString(m);
+        std::string digits = wideToString(m < 0 ? -m : m);
+        if(digits.size() <= s) digits.insert(0, s + 1 - digits.size(), '0');
+        digits.insert(digits.size() - s, 1, '.');
+        if(m < 0) digits.insert(0, 1, '-');
+        return digits;
     }
 
-    template<bool reduce = true>
-    NumType operator-() const noexcept{
-        switch (type) {
-            case WordInt:
-                assert(asWordInt() != std::numeric_limits<int32_t>::min());
-                return NumType(-asWordInt());
-            case WordRat:
-                return NumType(-asWordRat());
-            case GmpInt:
-                return NumType((-asBigInt()).get_val());
-            case GmpRat:
-                return NumType(-asBigRat());
-        }
+    //The same value in the rational tiers, for the operations without a decimal kernel
+    NumType decimalToRat() const{
+        WideWord num, den;
+        decimalFraction(decimalMantissa(), decimalScale(), num, den);
+        NumType ans;
+        ans.storeWideFraction(num, den);
+        return ans;
     }
 
-    bool operator==(const NumType& other) const noexcept{
-        if(type != other.type) return false;
-        else if(type >= WordInt) return data == other.data;
-        else if(type == GmpInt) return asBigInt() == other.asBigInt();
-        else return asBigRat() == other.asBigRat();
+    //Scales the mantissa with the smaller scale so both are over 10^max(sa, sb), false if it would overflow
+    static bool alignDecimal(WideWord& a, uint32_t sa, WideWord& b, uint32_t sb) noexcept{
+        if(sa < sb) return alignDecimal(b, sb, a, sa);
+        return sa == sb || !__builtin_mul_overflow(b, static_cast<WideWord>(powers_of_ten[sa - sb]), &b);
     }
 
-    bool operator!=(const NumType& other) const noexcept{
-        if(type != other.type) return true;
-        else if(type >= WordInt) return data != other.data;
-        else if(type == GmpInt) return asBigInt() != other.asBigInt();
-        else return asBigRat() != other.asBigRat();
+    //Decimal kernels are 128 bit integer ops and powers of ten with no gcd, so a sum at the same scale is
+    //an integer add. They return false, leaving this unchanged, when an operand is not decimal or would not fit.
+    bool setDecimalSum(const NumType& other){
+        WideWord a, b;
+        uint32_t sa, sb;
+        WideWord sum;
+        if(!decimalOperand(a, sa) || !other.decimalOperand(b, sb) || !alignDecimal(a, sa, b, sb) ||
+           __builtin_add_overflow(a, b, &sum))
+            return false;
+        storeDecimal(sum, std::max(sa, sb));
+        return true;
     }
 
-    bool operator<(const NumType& other) const{
-        switch (typePair(type, other.type)) {
-            case typePair(WordInt, WordInt): return asWordInt() < other.asWordInt();
-            case typePair(WordInt, WordRat): return asWordInt() < other.asWordRat();
-            case typePair(WordInt, GmpInt): return (int32_t)asWordInt() < other.asBigInt();
-            case typePair(WordInt, GmpRat): return (int32_t)asWordInt() < other.asBigRat();
-            case typePair(WordRat, WordInt): return asWordRat() < (int32_t)other.asWordInt();
-            case typePair(WordRat, WordRat): return asWordRat() < other.asWordRat();
-            case typePair(WordRat, GmpInt): return asWordRat().num < other.asBigInt()*asWordRat().den;
-            case typePair(WordRat, GmpRat): return 1 < other.asBigRat()*asWordRat().den/asWordRat().num;
-            case typePair(GmpInt, WordInt): return asBigInt() < (int32_t)other.asWordInt();
-            case typePair(GmpInt, WordRat): return asBigInt()*other.asWordRat().den < other.asWordRat().num;
-            case typePair(GmpInt, GmpInt): return asBigInt() < other.asBigInt();
-            case typePair(GmpInt, GmpRat): return asBigInt() < other.asBigRat();
-            case typePair(GmpRat, WordInt): return asBigRat() < (int32_t)other.asWordInt();
-            case typePair(GmpRat, WordRat): return asBigRat()*other.asWordRat().den/other.asWordRat().num < 1;
-            case typePair(GmpRat, GmpInt): return asBigRat() < other.asBigInt();
-            case typePair(GmpRat, GmpRat): return asBigRat() < other.asBigRat();
+    bool setDecimalProduct(const NumType& other){
+        WideWord a, b;
+        uint32_t sa, sb;
+        WideWord product;
+        if(!decimalOperand(a, sa) || !other.decimalOperand(b, sb) || __builtin_mul_overflow(a, b, &product))
+            return false;
+        storeDecimal(product, sa + sb);
+        return true;
+    }
+
+    //Only a divisor of the form 2^x*5^y keeps the quotient decimal, as a/(2^x*5^y) = a*2^(k-x)*5^(k-y)/10^k
+    bool setDecimalQuotient(const NumType& other){
+        WideWord a, b;
+        uint32_t sa, sb;
+        if(!decimalOperand(a, sa) || !other.decimalOperand(b, sb)) return false;
+        assert(b != 0);
+        UnsignedWideWord magnitude = b < 0 ? -static_cast<UnsignedWideWord>(b) : b;
+        const uint32_t twos = wideTrailingZeros(magnitude);
+        magnitude >>= twos;
+        uint32_t fives = 0;
+        for(; magnitude % 5 == 0; magnitude /= 5) fives++;
+        const uint32_t k = std::max(twos, fives);
+        if(magnitude != 1 || k > max_decimal_scale) return false;
+
+        const WideWord factor = static_cast<WideWord>((powers_of_ten[k - fives] >> (k - fives)) << (k - twos));
+        WideWord scaled;
+        if(__builtin_mul_overflow(a, b < 0 ? -factor : factor, &scaled)) return false;
+        const int64_t s = int64_t(sa) + k - int64_t(sb);
+        if(s >= 0){
+            storeDecimal(scaled, static_cast<uint32_t>(s));
+        }else{
+            if(__builtin_mul_overflow(scaled, static_cast<WideWord>(powers_of_ten[-s]), &scaled)) return false;
+            storeWide(scaled);
         }
+        return true;
+    }
 
-        assert(false);
+    //Sign of (this - other) for a Decimal against any tier
+    int compareDecimal(const NumType& other) const{
+        WideWord a, b;
+        uint32_t sa, sb;
+        if(decimalOperand(a, sa) && other.decimalOperand(b, sb) && alignDecimal(a, sa, b, sb))
+            return (a > b) - (a < b);
+        return compareFractions(other);
     }
 
-    bool operator<(int32_t other) const{
-        switch (type) {
-            case WordInt: return asWordInt() < other;
-            case WordRat: return asWordRat() < other;
-            case GmpInt: return asBigInt() < other;
-            case GmpRat: return asBigRat() < other;
-        }
+    //Pairs of a Dyadic or Decimal with an operand outside their kernels run on the equal WordRat or GmpRat
+    template<bool reduce, typename Op>
+    void throughRat(const NumType& other, Op op){
+        if(type == Dyadic) *this = dyadicToRat();
+        else if(type == Decimal) *this = decimalToRat();
+        if(other.type == Dyadic) op(*this, other.dyadicToRat());
+        else if(other.type == Decimal) op(*this, other.decimalToRat());
+        else op(*this, other);
     }
 
-    bool operator>(int32_t other) const{
-        switch (type) {
-            case WordInt: return asWordInt() > other;
-            case WordRat: return asWordRat() > other;
-            case GmpInt: return asBigInt() > other;
-            case GmpRat: return asBigRat() > other;
+    void bigIntReduce(){
+        mpz_srcptr z = asBigInt().get_mpz_t();
+        if(mpz_sizeinbase(z, 2) <= wide_bits){
+            const WideWord next = getWide(z);
+            bigIntPayload()->release();
+            type = WordInt;
+            storeWide(next);
         }
     }
 
+    template<bool canonicalize = true>
+    void bigRatReduce(){
+        if(canonicalize) mutableBigRat().canonicalize();
+        const mpq_class& r = asBigRat();
+
+        if(r.get_den() == 1){
+            if(mpz_sizeinbase(r.get_num_mpz_t(), 2) <= wide_bits){
+                const WideWord next = getWide(r.get_num_mpz_t());
+                bigRatPayload()->release();
+                type = WordInt;
+                storeWide(next);
+            }else{
+                SharedBigInt* next = new SharedBigInt();
+                if(bigRatPayload()->unique()) mpz_swap(next->val.get_mpz_t(), mutableBigRat().get_num_mpz_t());
+                else next->val = r.get_num();
+                bigRatPayload()->release();
+                data = next;
+                type = GmpInt;
+            }
+        }else if(r.get_den() <= std::numeric_limits<uint32_t>::max() &&
+                 r.get_num() <= std::numeric_limits<int32_t>::max() &&
+                 r.get_num() > std::numeric_limits<int32_t>::min()){
+            rat64_t next(r.get_num().get_si(), r.get_den().get_ui());
+            bigRatPayload()->release();
+            data = next;
+            type = WordRat;
+        }
+    }
+
+    void wordRatReduce() noexcept{
+        rat64_t r = asWordRat();
+        r.canonicalize();
+
+        if(r.den==1){
+            data = reinterpret_cast<void*>(r.num);
+            type = WordInt;
+        }else{
+            data = r;
+        }
+    }
+
+    void reduce(){
+        switch (type) {
+            case WordRat: wordRatReduce(); break;
+            case GmpInt: bigIntReduce(); break;
+            case GmpRat: bigRatReduce(); break;
+            case WordInt: break;
+            case WideInt: break;
+            case Dyadic: break;
+            case Decimal: break;
+        }
+    }
+
+    static void setInt64(mpz_ptr rop, int64_t z){
+        if constexpr(sizeof(long) >= sizeof(int64_t)){
+            mpz_set_si(rop, z);
+        }else{
+            mpz_set_si(rop, (int32_t)(z >> 32));
+            mpz_mul_2exp(rop, rop, 32);
+            mpz_add_ui(rop, rop, (uint32_t)z);
+        }
+    }
+
+    static void setUint64(mpz_ptr rop, uint64_t z){
+        if constexpr(sizeof(unsigned long) >= sizeof(uint64_t)){
+            mpz_set_ui(rop, z);
+        }else{
+            mpz_set_ui(rop, (uint32_t)(z >> 32));
+            mpz_mul_2exp(rop, rop, 32);
+            mpz_add_ui(rop, rop, (uint32_t)z);
+        }
+    }
+
+    //The word tiers are at most 32 bits in magnitude, so they always fit an unsigned long
+    static void addSigned(mpz_ptr rop, mpz_srcptr op, int64_t z){
+        if(z >= 0) mpz_add_ui(rop, op, z);
+        else mpz_sub_ui(rop, op, -z);
+    }
+
+    static void addMulSigned(mpz_ptr rop, mpz_srcptr op, int64_t z){
+        if(z >= 0) mpz_addmul_ui(rop, op, z);
+        else mpz_submul_ui(rop, op, -z);
+    }
+
+    static mp_bitcnt_t bitLength(const mpz_class& z){
+        return mpz_sizeinbase(z.get_mpz_t(), 2);
+    }
+
+    //New payloads are sized up front so the operation filling them does not reallocate
+    static SharedBigInt* newBigInt(mp_bitcnt_t bits){
+        SharedBigInt* payload = new SharedBigInt();
+        mpz_realloc2(payload->val.get_mpz_t(), bits);
+        return payload;
+    }
+
+    static SharedBigRat* newBigRat(mp_bitcnt_t num_bits, mp_bitcnt_t den_bits){
+        SharedBigRat* payload = new SharedBigRat();
+        mpz_realloc2(mpq_numref(payload->val.get_mpq_t()), num_bits);
+        mpz_realloc2(mpq_denref(payload->val.get_mpq_t()), den_bits);
+        return payload;
+    }
+
+    //Growth policy. A value which outgrows its storage inside a loop usually keeps growing, while GMP
+    //regrows to the exact size needed, so a product accumulated over n limbs reallocates n times.
+    //Storage created when a value is promoted out of the word tiers, or regrown by an in-place
+    //operation, instead gets twice the bits the operation needs, or the reserved capacity if larger.
+    mp_bitcnt_t growthBits(mp_bitcnt_t needed) const noexcept{
+        return std::max<mp_bitcnt_t>(2 * needed, reserved_bits);
+    }
+
+    static mp_bitcnt_t capacityBits(mpz_srcptr z) noexcept{
+        return static_cast<mp_bitcnt_t>(z->_mp_alloc) * GMP_NUMB_BITS;
+    }
+
+    //Call before an in-place operation whose result can take up to `limbs` limbs, the same bound GMP reallocates on
+    void growLimbs(mpz_ptr z, mp_size_t limbs) const{
+        const mp_bitcnt_t needed = static_cast<mp_bitcnt_t>(limbs) * GMP_NUMB_BITS;
+        if(capacityBits(z) < needed) mpz_realloc2(z, growthBits(needed));
+    }
+
+    //Storage for a result of this value honours its reservation
+    SharedBigInt* sizedBigInt(mp_bitcnt_t bits) const{
+        return newBigInt(std::max<mp_bitcnt_t>(bits, reserved_bits));
+    }
+
+    SharedBigRat* sizedBigRat(mp_bitcnt_t num_bits, mp_bitcnt_t den_bits) const{
+        return newBigRat(std::max<mp_bitcnt_t>(num_bits, reserved_bits), std::max<mp_bitcnt_t>(den_bits, reserved_bits));
+    }
+
+    SharedBigInt* promotedBigInt(mp_bitcnt_t bits) const{
+        return newBigInt(growthBits(bits));
+    }
+
+    SharedBigRat* promotedBigRat(mp_bitcnt_t num_bits, mp_bitcnt_t den_bits) const{
+        return newBigRat(growthBits(num_bits), growthBits(den_bits));
+    }
+
+    //Requests room for values of up to `bits` magnitude bits, in the numerator and denominator of a fraction.
+    //GMP storage grows now. A value in a smaller tier keeps the request and gets the capacity when it is
+    //promoted, so an accumulator updated in place is sized once. Copies do not inherit the request.
+    void reserve(mp_bitcnt_t bits){
+        reserved_bits = static_cast<uint32_t>(std::min<mp_bitcnt_t>(bits, std::numeric_limits<uint32_t>::max()));
+        if(type == GmpInt){
+            mpz_ptr z = mutableBigInt().get_mpz_t();
+            if(capacityBits(z) < bits) mpz_realloc2(z, bits);
+        }else if(type == GmpRat){
+            mpq_ptr q = mutableBigRat().get_mpq_t();
+            if(capacityBits(mpq_numref(q)) < bits) mpz_realloc2(mpq_numref(q), bits);
+            if(capacityBits(mpq_denref(q)) < bits) mpz_realloc2(mpq_denref(q), bits);
+        }
+    }
+
+    //Bits this value can hold without reallocating: the GMP capacity, or the reserved capacity in the smaller tiers
+    mp_bitcnt_t capacity() const noexcept{
+        if(type == GmpInt) return capacityBits(asBigInt().get_mpz_t());
+        if(type == GmpRat) return std::min(capacityBits(asBigRat().get_num_mpz_t()), capacityBits(asBigRat().get_den_mpz_t()));
+        return reserved_bits;
+    }
+
+    //Turns a GmpInt into a GmpRat with the integer as numerator, reusing its limbs
+    mpq_class& promoteBigIntToBigRat(){
+        SharedBigRat* q = new SharedBigRat();
+        mpz_swap(mpq_numref(q->val.get_mpq_t()), mutableBigInt().get_mpz_t());
+        bigIntPayload()->release();
+        data = q;
+        type = GmpRat;
+        return q->val;
+    }
+
+    //Copies a scratch result into a new NumType, skipping the allocation when it fits a word
+    static NumType fromScratch(mpz_srcptr z){
+        if(mpz_fits_sint_p(z) && mpz_cmp_si(z, std::numeric_limits<int32_t>::min()) != 0)
+            return NumType(static_cast<int32_t>(mpz_get_si(z)));
+        if(mpz_sizeinbase(z, 2) <= wide_bits) return fromWide(getWide(z));
+        NumType ans;
+        SharedBigInt* payload = newBigInt(mpz_sizeinbase(z, 2));
+        mpz_set(payload->val.get_mpz_t(), z);
+        ans.data = payload;
+        ans.type = GmpInt;
+        return ans;
+    }
+
+    static NumType fromScratch(mpq_srcptr q){
+        if(mpz_cmp_ui(mpq_denref(q), 1) == 0) return fromScratch(mpq_numref(q));
+        NumType ans;
+        SharedBigRat* payload = newBigRat(mpz_sizeinbase(mpq_numref(q), 2), mpz_sizeinbase(mpq_denref(q), 2));
+        mpq_set(payload->val.get_mpq_t(), q);
+        ans.data = payload;
+        ans.type = GmpRat;
+        ans.bigRatReduce<false>();
+        return ans;
+    }
+
+    inline mpz_class toBigInt(int64_t z){
+        mpz_class big;
+        setInt64(big.get_mpz_t(), z);
+        return big;
+    }
+
+    void wordIntClamp(){
+        assert(type == WordInt);
+        int64_t z = reinterpret_cast<int64_t>(data);
+        if(z > std::numeric_limits<int32_t>::max() || z <= std::numeric_limits<int32_t>::min()){
+            data = WideSlab::acquire(z);
+            type = WideInt;
+        }
+    }
+
+    NumType() : data(0), type(WordInt) {}
+    NumType(int32_t val) : data(reinterpret_cast<void*>(val)), type(WordInt) {}
+    NumType(const rat64_t& r) : data(r), type(WordRat) {}
+    NumType(rat64_t::SignedHalfWord num, rat64_t::UnsignedHalfWord den) : data(rat64_t(num, den)), type(WordRat){}
+    NumType(const mpz_class& val) : data(new SharedBigInt(val)), type(GmpInt) {}
+    NumType(const mpq_class& val) : data(new SharedBigRat(val)), type(GmpRat) {}
+    NumType(mpz_class&& val) : data(new SharedBigInt(std::move(val))), type(GmpInt) {}
+    NumType(mpq_class&& val) : data(new SharedBigRat(std::move(val))), type(GmpRat) {}
+    ~NumType(){
+        releaseBig();
+    }
+    NumType(const NumType& other) noexcept{
+        type = other.type;
+        data = other.type == WideInt ? WideSlab::acquire(other.asWide()) : other.data;
+        retainBig();
+    }
+    NumType(NumType&& other) noexcept{
+        type = other.type;
+        data = other.data;
+        other.type = WordInt; //You gave me any pointers, so don't free them!
+    }
+    NumType& operator=(NumType&& other) noexcept{
+        releaseBig();
+        type = other.type;
+        data = other.data;
+        other.type = WordInt; //You gave me any pointers, so don't free them!
+        return *this;
+    }
+    NumType& operator=(const NumType& other) noexcept{
+        if(other.type == WideInt){
+            if(type == WideInt){
+                *wideSlot() = other.asWide(); //Reuse the block, also safe for self-assignment
+            }else{
+                releaseBig();
+                data = WideSlab::acquire(other.asWide());
+                type = WideInt;
+            }
+            return *this;
+        }
+
+        other.retainBig(); //Retain first in case of self-assignment
+        releaseBig();
+        type = other.type;
+        data = other.data;
+
+        return *this;
+    }
+
+    std::string toString() const{
+        switch (type) {
+            case WordInt: return std::to_string(asWordInt());
+            case WordRat: return asWordRat().toStr();
+            case GmpInt: return asBigInt().get_str();
+            case GmpRat: return asBigRat().get_str();
+            case WideInt: return wideToString(asWide());
+            case Dyadic:
+                if(dyadicExponent() < 64)
+                    return std::to_string(dyadicMantissa()) + '/' + std::to_string(uint64_t(1) << dyadicExponent());
+                return dyadicToRat().toString();
+            case Decimal:{
+                WideWord num, den;
+                decimalFraction(decimalMantissa(), decimalScale(), num, den);
+                return wideToString(num) + '/' + wideToString(den);
+            }
+            default: assert(false);
+        }
+    }
+
+    static std::string wideToString(WideWord val){
+        UnsignedWideWord magnitude = val < 0 ? -static_cast<UnsignedWideWord>(val) : val;
+        char digits[41];
+        char* end = digits + sizeof(digits);
+        char* begin = end;
+        do{
+            *--begin = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        }while(magnitude);
+        if(val < 0) *--begin = '-';
+        return std::string(begin, end);
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const NumType& num){
+        out << num.toString();
+        return out;
+    }
+
+    inline bool isGmp() const noexcept{
+        return type == GmpInt || type == GmpRat;
+    }
+
+    void negate(){
+        switch (type) {
+            case WordInt:
+                assert(asWordInt() != std::numeric_limits<int32_t>::min());
+                data = reinterpret_cast<void*>(-asWordInt());
+                break;
+            case WordRat:
+                data = -asWordRat();
+                break;
+            case GmpInt:{
+                mpz_class& z = mutableBigInt();
+                mpz_neg(z.get_mpz_t(), z.get_mpz_t());
+                break;
+            }
+            case GmpRat:{
+                mpq_class& q = mutableBigRat();
+                mpq_neg(q.get_mpq_t(), q.get_mpq_t());
+                break;
+            }
+            case WideInt:
+                //Wide values exclude -2^127, and INT32_MIN is wide, so the tier never changes
+                *wideSlot() = -asWide();
+                break;
+            case Dyadic:
+                storeDyadic(-dyadicMantissa(), dyadicExponent());
+                break;
+            case Decimal:
+                storeDecimal(-decimalMantissa(), decimalScale());
+                break;
+        }
+    }
+
+    template<bool reduce = true>
+    NumType operator-() &&{
+        negate();
+        return std::move(*this);
+    }
+
+    template<bool reduce = true>
+    NumType operator-() const& noexcept{
+        switch (type) {
+            case WordInt:
+                assert(asWordInt() != std::numeric_limits<int32_t>::min());
+                return NumType(-asWordInt());
+            case WordRat:
+                return NumType(-asWordRat());
+            case GmpInt:
+                return NumType(mpz_class(-asBigInt()));
+            case GmpRat:
+                return NumType(-asBigRat());
+            case WideInt:
+                return fromWide(-asWide());
+            case Dyadic:
+                return dyadic(-dyadicMantissa(), dyadicExponent());
+            case Decimal:
+                return decimal(-decimalMantissa(), decimalScale());
+        }
+    }
+
+    //Values built with reduce=false, or from an unreduced fraction, may hold the same number in
+    //different tiers or terms, so anything but an exact match of canonical tiers compares by value
+    bool operator==(const NumType& other) const{
+        NUMTYPE_OP_HOOK('=', other);
+        if(type != other.type) return compare(other) == 0;
+        else if(type == WideInt) return asWide() == other.asWide();
+        else if(type == WordInt || type == Dyadic || type == Decimal) return data == other.data;
+        else if(type == WordRat){
+            const rat64_t lhs = asWordRat();
+            const rat64_t rhs = other.asWordRat();
+            return static_cast<int64_t>(lhs.num) * rhs.den == static_cast<int64_t>(rhs.num) * lhs.den;
+        }
+        else if(type == GmpInt) return asBigInt() == other.asBigInt();
+        else return asBigRat() == other.asBigRat();
+    }
+
+    bool operator!=(const NumType& other) const{
+        return !operator==(other);
+    }
+
+    //Consistent with operator==: equal values hash equally whatever their tier or terms
+    static uint64_t mixHash(uint64_t seed, uint64_t val) noexcept{
+        return seed ^ (val + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2));
+    }
+
+    static uint64_t wideHash(WideWord val) noexcept{
+        const UnsignedWideWord bits = static_cast<UnsignedWideWord>(val);
+        return mixHash(mixHash(0, static_cast<uint64_t>(bits)), static_cast<uint64_t>(bits >> 64));
+    }
+
+    static uint64_t bigHash(mpz_srcptr z) noexcept{
+        if(mpz_sizeinbase(z, 2) <= wide_bits) return wideHash(getWide(z));
+        uint64_t seed = mpz_sgn(z) < 0;
+        for(size_t i = 0; i < mpz_size(z); i++) seed = mixHash(seed, mpz_getlimbn(z, i));
+        return seed;
+    }
+
+    uint64_t hash() const{
+        switch (type) {
+            case WordInt: return wideHash(asWordInt());
+            case WideInt: return wideHash(asWide());
+            case WordRat:{
+                rat64_t q = asWordRat();
+                q.canonicalize();
+                return q.den == 1 ? wideHash(q.num) : mixHash(wideHash(q.num), wideHash(q.den));
+            }
+            case GmpInt: return bigHash(asBigInt().get_mpz_t());
+            case GmpRat:{
+                const mpq_class& q = asBigRat();
+                if(q.get_den() == 1) return bigHash(q.get_num_mpz_t());
+                return mixHash(bigHash(q.get_num_mpz_t()), bigHash(q.get_den_mpz_t()));
+            }
+            case Dyadic:
+                if(dyadicExponent() < 127) return mixHash(wideHash(dyadicMantissa()), wideHash(static_cast<WideWord>(1) << dyadicExponent()));
+                return dyadicToRat().hash();
+            case Decimal:{
+                WideWord num, den;
+                decimalFraction(decimalMantissa(), decimalScale(), num, den);
+                return mixHash(wideHash(num), wideHash(den));
+            }
+        }
+        assert(false);
+        return 0;
+    }
+
+    template<typename T>
+    static constexpr int threeWay(const T& lhs, const T& rhs) noexcept{
+        return (lhs > rhs) - (lhs < rhs);
+    }
+
+    int sign() const noexcept{
+        switch (type) {
+            case WordInt: return threeWay<int64_t>(asWordInt(), 0);
+            case WordRat: return threeWay<int32_t>(asWordRat().num, 0);
+            case GmpInt: return mpz_sgn(asBigInt().get_mpz_t());
+            case GmpRat: return mpq_sgn(asBigRat().get_mpq_t());
+            case WideInt: return threeWay<WideWord>(asWide(), 0);
+            case Dyadic: return threeWay<int64_t>(dyadicMantissa(), 0);
+            case Decimal: return threeWay<int64_t>(decimalMantissa(), 0);
+        }
+        assert(false);
+        return 0;
+    }
+
+    //Sign of z - n/d. Past 33 bits z outweighs any word fraction, otherwise z*d is compared in a scratch register.
+    static int compareBigWord(mpz_srcptr z, const rat64_t& q){
+        if(mpz_sizeinbase(z, 2) > 33) return mpz_sgn(z);
+        if(q.den == 1) return threeWay(mpz_cmp_si(z, q.num), 0);
+        ScratchInt scaled;
+        mpz_mul_ui(scaled, z, q.den);
+        return threeWay(mpz_cmp_si(scaled.z, q.num), 0);
+    }
+
+    //Three-way comparison, the sign of (this - other), for every pair of tiers without allocating.
+    //Word pairs cross multiply in 64 bits. Otherwise operands of different sign are decided without
+    //looking at magnitudes, and GMP pairs compare in place or in the scratch registers.
+    int compare(const NumType& other) const{
+        NUMTYPE_OP_HOOK('<', other);
+        switch (typePair(type, other.type)) {
+            case typePair(WordInt, WordInt): return threeWay(asWordInt(), other.asWordInt());
+            case typePair(WordInt, WordRat):
+            case typePair(WordRat, WordInt):
+            case typePair(WordRat, WordRat):{
+                const rat64_t lhs = wordOperand();
+                const rat64_t rhs = other.wordOperand();
+                return threeWay(static_cast<int64_t>(lhs.num) * rhs.den, static_cast<int64_t>(rhs.num) * lhs.den);
+            }
+            default: break;
+        }
+
+        const int lhs_sign = sign();
+        const int rhs_sign = other.sign();
+        if(lhs_sign != rhs_sign) return threeWay(lhs_sign, rhs_sign);
+        if(lhs_sign == 0) return 0;
+
+        switch (typePair(type, other.type)) {
+            case typePair(WordInt, GmpInt):
+            case typePair(WordRat, GmpInt):
+                return -compareBigWord(other.asBigInt().get_mpz_t(), wordOperand());
+            case typePair(GmpInt, WordInt):
+            case typePair(GmpInt, WordRat):
+                return compareBigWord(asBigInt().get_mpz_t(), other.wordOperand());
+            case typePair(WordInt, GmpRat):
+            case typePair(WordRat, GmpRat):{
+                const rat64_t q = wordOperand();
+                return -threeWay(mpq_cmp_si(other.asBigRat().get_mpq_t(), q.num, q.den), 0);
+            }
+            case typePair(GmpRat, WordInt):
+            case typePair(GmpRat, WordRat):{
+                const rat64_t q = other.wordOperand();
+                return threeWay(mpq_cmp_si(asBigRat().get_mpq_t(), q.num, q.den), 0);
+            }
+            case typePair(GmpInt, GmpInt): return threeWay(mpz_cmp(asBigInt().get_mpz_t(), other.asBigInt().get_mpz_t()), 0);
+            case typePair(GmpInt, GmpRat): return -threeWay(mpq_cmp_z(other.asBigRat().get_mpq_t(), asBigInt().get_mpz_t()), 0);
+            case typePair(GmpRat, GmpInt): return threeWay(mpq_cmp_z(asBigRat().get_mpq_t(), other.asBigInt().get_mpz_t()), 0);
+            case typePair(GmpRat, GmpRat): return threeWay(mpq_cmp(asBigRat().get_mpq_t(), other.asBigRat().get_mpq_t()), 0);
+            case typePair(WideInt, WordInt):
+            case typePair(WideInt, WordRat):
+            case typePair(WideInt, GmpInt):
+            case typePair(WideInt, GmpRat):
+            case typePair(WideInt, WideInt):
+                return compareWide(other);
+            case typePair(WordInt, WideInt):
+            case typePair(WordRat, WideInt):
+            case typePair(GmpInt, WideInt):
+            case typePair(GmpRat, WideInt):
+                return -other.compareWide(*this);
+            case typePair(Dyadic, WordInt):
+            case typePair(Dyadic, WordRat):
+            case typePair(Dyadic, GmpInt):
+            case typePair(Dyadic, GmpRat):
+            case typePair(Dyadic, WideInt):
+            case typePair(Dyadic, Dyadic):
+                return compareDyadic(other);
+            case typePair(WordInt, Dyadic):
+            case typePair(WordRat, Dyadic):
+            case typePair(GmpInt, Dyadic):
+            case typePair(GmpRat, Dyadic):
+            case typePair(WideInt, Dyadic):
+                return -other.compareDyadic(*this);
+            case typePair(Decimal, WordInt):
+            case typePair(Decimal, WordRat):
+            case typePair(Decimal, GmpInt):
+            case typePair(Decimal, GmpRat):
+            case typePair(Decimal, WideInt):
+            case typePair(Decimal, Dyadic):
+            case typePair(Decimal, Decimal):
+                return compareDecimal(other);
+            case typePair(WordInt, Decimal):
+            case typePair(WordRat, Decimal):
+            case typePair(GmpInt, Decimal):
+            case typePair(GmpRat, Decimal):
+            case typePair(WideInt, Decimal):
+            case typePair(Dyadic, Decimal):
+                return -other.compareDecimal(*this);
+        }
+
+        assert(false);
+        return 0;
+    }
+
+    //Primitive operands compare against the tier of this value alone, without building a NumType.
+    //An integer operand is any int64_t or uint64_t, so z*den and z*10^18 still fit in 128 bits.
+    int compareInteger(WideWord z) const{
+        NUMTYPE_OP_HOOK('<', z);
+        switch (type) {
+            case WordInt: return threeWay<WideWord>(asWordInt(), z);
+            case WordRat: return threeWay<WideWord>(asWordRat().num, z * asWordRat().den);
+            case GmpInt:
+                if(z < 0) return threeWay(mpz_cmp_si(asBigInt().get_mpz_t(), static_cast<long>(z)), 0);
+                return threeWay(mpz_cmp_ui(asBigInt().get_mpz_t(), static_cast<unsigned long>(z)), 0);
+            case GmpRat:
+                if(z < 0) return threeWay(mpq_cmp_si(asBigRat().get_mpq_t(), static_cast<long>(z), 1), 0);
+                return threeWay(mpq_cmp_ui(asBigRat().get_mpq_t(), static_cast<unsigned long>(z), 1), 0);
+            case WideInt: return threeWay<WideWord>(asWide(), z);
+            case Dyadic:{
+                //Past 2^-62 the magnitude is below 2^-7, so only the sign of a nonzero integer matters
+                const uint32_t e = dyadicExponent();
+                if(e > 62) return z == 0 ? threeWay<int64_t>(dyadicMantissa(), 0) : z < 0 ? 1 : -1;
+                return threeWay<WideWord>(dyadicMantissa(), z * (WideWord(1) << e));
+            }
+            case Decimal:
+                return threeWay<WideWord>(decimalMantissa(), z * static_cast<WideWord>(powers_of_ten[decimalScale()]));
+        }
+        assert(false);
+        return 0;
+    }
+
+    //Integers of up to 64 bits, and unscoped enums which promote to them
+    template<typename T>
+    using IfPrimitive = std::enable_if_t<(std::is_integral<T>::value || std::is_enum<T>::value) &&
+                                         std::is_convertible<T, int64_t>::value && sizeof(T) <= sizeof(int64_t), int>;
+
+    template<typename T, IfPrimitive<T> = 0>
+    int compare(T other) const{
+        return compareInteger(other);
+    }
+
+    int compare(const rat64_t& other) const{
+        if(other.den == 1) return compareInteger(other.num);
+        switch (type) {
+            case WordInt:
+            case WordRat:{
+                const rat64_t lhs = wordOperand();
+                return threeWay(static_cast<int64_t>(lhs.num) * other.den, static_cast<int64_t>(other.num) * lhs.den);
+            }
+            case GmpInt: return compareBigWord(asBigInt().get_mpz_t(), other);
+            case GmpRat: return threeWay(mpq_cmp_si(asBigRat().get_mpq_t(), other.num, other.den), 0);
+            default: return compare(NumType(other));
+        }
+    }
+
+    bool operator<(const NumType& other) const{
+        return compare(other) < 0;
+    }
+
+    bool operator>(const NumType& other) const{
+        return compare(other) > 0;
+    }
+
+    bool operator<=(const NumType& other) const{
+        return compare(other) <= 0;
+    }
+
+    bool operator>=(const NumType& other) const{
+        return compare(other) >= 0;
+    }
+
+    template<typename T, IfPrimitive<T> = 0>
+    bool operator==(T other) const{
+        return compareInteger(other) == 0;
+    }
+
+    template<typename T, IfPrimitive<T> = 0>
+    bool operator!=(T other) const{
+        return compareInteger(other) != 0;
+    }
+
+    template<typename T, IfPrimitive<T> = 0>
+    bool operator<(T other) const{
+        return compareInteger(other) < 0;
+    }
+
+    template<typename T, IfPrimitive<T> = 0>
+    bool operator>(T other) const{
+        return compareInteger(other) > 0;
+    }
+
+    template<typename T, IfPrimitive<T> = 0>
+    bool operator<=(T other) const{
+        return compareInteger(other) <= 0;
+    }
+
+    template<typename T, IfPrimitive<T> = 0>
+    bool operator>=(T other) const{
+        return compareInteger(other) >= 0;
+    }
+
+    bool operator==(const rat64_t& other) const{
+        return compare(other) == 0;
+    }
+
+    bool operator!=(const rat64_t& other) const{
+        return compare(other) != 0;
+    }
+
+    bool operator<(const rat64_t& other) const{
+        return compare(other) < 0;
+    }
+
+    bool operator>(const rat64_t& other) const{
+        return compare(other) > 0;
+    }
+
+    bool operator<=(const rat64_t& other) const{
+        return compare(other) <= 0;
+    }
+
+    bool operator>=(const rat64_t& other) const{
+        return compare(other) >= 0;
+    }
+
+    void setZero() noexcept{
+        releaseBig();
+        data = 0;
+        type = WordInt;
+    }
+
+    //Replaces a word tier value with (a/b)*(c/d) where the word multiply overflowed.
+    //The operands are canonical word fractions, so the cross-reduced product fits 64 bits.
+    template<bool reduce = true>
+    void setWordProduct(int64_t a, uint64_t b, int64_t c, uint64_t d){
+        assert(!isGmp());
+        const uint64_t gcd1 = std::gcd(static_cast<uint64_t>(std::abs(a)), d);
+        const uint64_t gcd2 = std::gcd(static_cast<uint64_t>(std::abs(c)), b);
+        SharedBigRat* next = promotedBigRat(64, 64);
+        setInt64(mpq_numref(next->val.get_mpq_t()), (a/static_cast<int64_t>(gcd1)) * (c/static_cast<int64_t>(gcd2)));
+        setUint64(mpq_denref(next->val.get_mpq_t()), (b/gcd2) * (d/gcd1));
+        data = next;
+        type = GmpRat;
+        if(reduce) bigRatReduce<false>();
+    }
+
+    //Replaces a word tier value with (a/b)+(c/d) where the word addition overflowed.
+    //The numerator can need 65 bits, so it is accumulated in the new payload.
+    template<bool reduce = true>
+    void setWordSum(int64_t a, uint64_t b, int64_t c, uint64_t d){
+        assert(!isGmp());
+        SharedBigRat* next = promotedBigRat(96, 64);
+        mpz_ptr num = mpq_numref(next->val.get_mpq_t());
+        mpz_ptr den = mpq_denref(next->val.get_mpq_t());
+        setInt64(num, a);
+        mpz_mul_ui(num, num, d);
+        setInt64(den, c);
+        mpz_mul_ui(den, den, b);
+        mpz_add(num, num, den);
+        setUint64(den, b*d);
+        mpq_canonicalize(next->val.get_mpq_t());
+        data = next;
+        type = GmpRat;
+        if(reduce) bigRatReduce<false>();
+    }
+
+    //Two limb kernels for pairs of WordInt/WideInt operands. Results past 127 bits are finished in GMP.
+    void setWideSum(WideWord a, WideWord b){
+        WideWord sum;
+        if(!__builtin_add_overflow(a, b, &sum)){
+            storeWide(sum);
+            return;
+        }
+        releaseBig();
+        SharedBigInt* next = promotedBigInt(1 + std::max(wideBitLength(a), wideBitLength(b)));
+        ScratchInt rhs;
+        setWide(next->val.get_mpz_t(), a);
+        setWide(rhs, b);
+        mpz_add(next->val.get_mpz_t(), next->val.get_mpz_t(), rhs);
+        data = next;
+        type = GmpInt;
+    }
+
+    void setWideProduct(WideWord a, WideWord b){
+        WideWord product;
+        if(!__builtin_mul_overflow(a, b, &product)){
+            storeWide(product);
+            return;
+        }
+        releaseBig();
+        SharedBigInt* next = promotedBigInt(wideBitLength(a) + wideBitLength(b));
+        ScratchInt rhs;
+        setWide(next->val.get_mpz_t(), a);
+        setWide(rhs, b);
+        mpz_mul(next->val.get_mpz_t(), next->val.get_mpz_t(), rhs);
+        data = next;
+        type = GmpInt;
+    }
+
+    //Square-and-multiply in 128 bits, false if the result does not fit
+    static bool widePow(WideWord base, uint32_t exp, WideWord& ans){
+        WideWord result = 1;
+        for(;;){
+            if((exp & 1) && __builtin_mul_overflow(result, base, &result)) return false;
+            exp >>= 1;
+            if(exp == 0) break;
+            if(__builtin_mul_overflow(base, base, &base)) return false;
+        }
+        ans = result;
+        return true;
+    }
+
+    //Mixed pairs of a WideInt with a rational or GMP tier run on a GMP copy of the wide operand
+    template<bool reduce, typename Op>
+    void throughBig(const NumType& other, Op op){
+        if(type == WideInt) widenToBig();
+        if(other.type == WideInt) op(*this, other.wideToBig());
+        else op(*this, other);
+        if(reduce && type == GmpInt) bigIntReduce();
+    }
+
+    //Sign of (this - other) for a WideInt against any tier
+    int compareWide(const NumType& other) const{
+        const WideWord lhs = asWide();
+        switch(other.type){
+            case WordInt:
+            case WideInt:{
+                const WideWord rhs = other.wideOperand();
+                return (lhs > rhs) - (lhs < rhs);
+            }
+            case WordRat:{
+                //A product past 127 bits outweighs any word numerator
+                WideWord scaled;
+                if(__builtin_mul_overflow(lhs, static_cast<WideWord>(other.asWordRat().den), &scaled))
+                    return threeWay<WideWord>(lhs, 0);
+                return threeWay<WideWord>(scaled, other.asWordRat().num);
+            }
+            case GmpInt:{
+                if(mpz_sizeinbase(other.asBigInt().get_mpz_t(), 2) > wide_bits) return -mpz_sgn(other.asBigInt().get_mpz_t());
+                ScratchInt z;
+                setWide(z, lhs);
+                return threeWay(mpz_cmp(z, other.asBigInt().get_mpz_t()), 0);
+            }
+            case GmpRat:{
+                ScratchInt z;
+                setWide(z, lhs);
+                return -threeWay(mpq_cmp_z(other.asBigRat().get_mpq_t(), z), 0);
+            }
+            case Dyadic:
+                return -other.compareDyadic(*this);
+            case Decimal:
+                return -other.compareDecimal(*this);
+        }
+        assert(false);
+        return 0;
+    }
+
     template<bool reduce = true>
     void operator*=(const NumType& other){
+        NUMTYPE_OP_HOOK('*', other);
         switch(typePair(type, other.type)){
             case typePair(WordInt, WordInt):
                 data = reinterpret_cast<void*>(asWordInt() * other.asWordInt());
@@ -289,11 +1812,7 @@ struct NumType{
                 int32_t lhs = asWordInt();
                 rat64_t rhs = other.asWordRat();
                 if(rat64_t::multiply(lhs, rhs, ans)){
-                    mpq_class* result = new mpq_class(rhs.num, rhs.den);
-                    result->operator*=(lhs);
-                    data = result;
-                    type = GmpRat;
-                    if(reduce) bigRatReduce();
+                    setWordProduct<reduce>(lhs, 1, rhs.num, rhs.den);
                 }else if(ans.den == 1){
                     data = reinterpret_cast<void*>(ans.num);
                 }else{
@@ -302,234 +1821,1210 @@ struct NumType{
                 }
                 break;
             }
-            case typePair(WordInt, GmpInt):{
-                if(data == 0) break;
-                data = new mpz_class(other.asBigInt()*(int32_t)asWordInt());
-                type = GmpInt;
+            case typePair(WordInt, GmpInt):{
+                if(data == 0) break;
+                const int64_t lhs = asWordInt();
+                const mpz_class& rhs = other.asBigInt();
+                SharedBigInt* next = sizedBigInt(32 + bitLength(rhs));
+                mpz_mul_si(next->val.get_mpz_t(), rhs.get_mpz_t(), lhs);
+                data = next;
+                type = GmpInt;
+                break;
+            }
+            case typePair(WordInt, GmpRat):{
+                if(data == 0) break;
+                const int64_t lhs = asWordInt();
+                const mpq_class& rhs = other.asBigRat();
+                const unsigned long gcd = mpz_gcd_ui(nullptr, rhs.get_den_mpz_t(), std::abs(lhs));
+                SharedBigRat* next = sizedBigRat(32 + bitLength(rhs.get_num()), bitLength(rhs.get_den()));
+                mpz_mul_si(mpq_numref(next->val.get_mpq_t()), rhs.get_num_mpz_t(), lhs/static_cast<long>(gcd));
+                mpz_divexact_ui(mpq_denref(next->val.get_mpq_t()), rhs.get_den_mpz_t(), gcd);
+                data = next;
+                type = GmpRat;
+                if(reduce) bigRatReduce<false>();
+                break;
+            }
+            case typePair(WordRat, WordInt):{
+                rat64_t ans;
+                rat64_t lhs = asWordRat();
+                int32_t rhs = other.asWordInt();
+                if(rat64_t::multiply(lhs, rhs, ans)){
+                    setWordProduct<reduce>(lhs.num, lhs.den, rhs, 1);
+                }else if(ans.den == 1){
+                    data = reinterpret_cast<void*>(ans.num);
+                    type = WordInt;
+                }else{
+                    data = ans;
+                }
+                break;
+            }
+            case typePair(WordRat, WordRat):{
+                rat64_t ans;
+                rat64_t lhs = asWordRat();
+                rat64_t rhs = other.asWordRat();
+                if(rat64_t::multiply(lhs, rhs, ans)){
+                    setWordProduct<reduce>(lhs.num, lhs.den, rhs.num, rhs.den);
+                }else if(ans.den == 1){
+                    data = reinterpret_cast<void*>(ans.num);
+                    type = WordInt;
+                }else{
+                    data = ans;
+                }
+                break;
+            }
+            case typePair(WordRat, GmpInt):{
+                const rat64_t lhs = asWordRat();
+                const mpz_class& rhs = other.asBigInt();
+                if(lhs.num == 0){
+                    setZero();
+                    break;
+                }
+                const unsigned long gcd = mpz_gcd_ui(nullptr, rhs.get_mpz_t(), lhs.den);
+                if(lhs.den == gcd){
+                    SharedBigInt* next = sizedBigInt(32 + bitLength(rhs));
+                    mpz_divexact_ui(next->val.get_mpz_t(), rhs.get_mpz_t(), gcd);
+                    mpz_mul_si(next->val.get_mpz_t(), next->val.get_mpz_t(), lhs.num);
+                    data = next;
+                    type = GmpInt;
+                    if(reduce) bigIntReduce();
+                }else{
+                    SharedBigRat* next = sizedBigRat(32 + bitLength(rhs), 32);
+                    mpz_ptr num = mpq_numref(next->val.get_mpq_t());
+                    mpz_divexact_ui(num, rhs.get_mpz_t(), gcd);
+                    mpz_mul_si(num, num, lhs.num);
+                    mpz_set_ui(mpq_denref(next->val.get_mpq_t()), lhs.den/gcd);
+                    data = next;
+                    type = GmpRat;
+                    if(reduce) bigRatReduce<false>();
+                }
+                break;
+            }
+            case typePair(WordRat, GmpRat):{
+                const rat64_t lhs = asWordRat();
+                const mpq_class& rhs = other.asBigRat();
+                if(lhs.num == 0){
+                    setZero();
+                    break;
+                }
+                const unsigned long gcd1 = mpz_gcd_ui(nullptr, rhs.get_den_mpz_t(), rat64_t::safeAbs(lhs.num));
+                const unsigned long gcd2 = mpz_gcd_ui(nullptr, rhs.get_num_mpz_t(), lhs.den);
+                SharedBigRat* next = sizedBigRat(32 + bitLength(rhs.get_num()), 32 + bitLength(rhs.get_den()));
+                mpz_ptr num = mpq_numref(next->val.get_mpq_t());
+                mpz_ptr den = mpq_denref(next->val.get_mpq_t());
+                mpz_divexact_ui(num, rhs.get_num_mpz_t(), gcd2);
+                mpz_mul_si(num, num, lhs.num/static_cast<long>(gcd1));
+                mpz_divexact_ui(den, rhs.get_den_mpz_t(), gcd1);
+                mpz_mul_ui(den, den, lhs.den/gcd2);
+                data = next;
+                type = GmpRat;
+                if(reduce) bigRatReduce<false>();
+                break;
+            }
+            case typePair(GmpInt, WordInt):
+                if(other.data == 0){
+                    setZero();
+                }else{
+                    mpz_class& z = mutableBigInt();
+                    growLimbs(z.get_mpz_t(), mpz_size(z.get_mpz_t()) + 1);
+                    mpz_mul_si(z.get_mpz_t(), z.get_mpz_t(), other.asWordInt());
+                }
+                break;
+            case typePair(GmpInt, WordRat):{
+                const rat64_t rhs = other.asWordRat();
+                if(rhs.num == 0){
+                    setZero();
+                    break;
+                }
+                const unsigned long gcd = mpz_gcd_ui(nullptr, asBigInt().get_mpz_t(), rhs.den);
+                mpz_class& z = mutableBigInt();
+                mpz_divexact_ui(z.get_mpz_t(), z.get_mpz_t(), gcd);
+                mpz_mul_si(z.get_mpz_t(), z.get_mpz_t(), rhs.num);
+                if(rhs.den == gcd){
+                    if(reduce) bigIntReduce();
+                }else{
+                    mpq_class& q = promoteBigIntToBigRat();
+                    mpz_set_ui(q.get_den_mpz_t(), rhs.den/gcd);
+                    if(reduce) bigRatReduce<false>();
+                }
+                break;
+            }
+            case typePair(GmpInt, GmpInt):{
+                const mp_size_t limbs = mpz_size(asBigInt().get_mpz_t()) + mpz_size(other.asBigInt().get_mpz_t());
+                mpz_class& z = mutableBigInt();
+                growLimbs(z.get_mpz_t(), limbs);
+                z *= other.asBigInt();
                 break;
             }
-            case typePair(WordInt, GmpRat):{
-                if(data == 0) break;
-                data = new mpq_class(other.asBigRat()*(int32_t)asWordInt());
-                type = GmpRat;
-                if(reduce) bigRatReduce();
+            case typePair(GmpInt, GmpRat):{
+                const mpq_class& rhs = other.asBigRat();
+                ScratchInt gcd;
+                mpz_gcd(gcd, asBigInt().get_mpz_t(), rhs.get_den_mpz_t());
+                mpz_class& z = mutableBigInt();
+                mpz_divexact(z.get_mpz_t(), z.get_mpz_t(), gcd);
+                mpz_mul(z.get_mpz_t(), z.get_mpz_t(), rhs.get_num_mpz_t());
+                if(mpz_cmp(rhs.get_den_mpz_t(), gcd) == 0){
+                    if(reduce) bigIntReduce();
+                }else{
+                    mpq_class& q = promoteBigIntToBigRat();
+                    mpz_divexact(q.get_den_mpz_t(), rhs.get_den_mpz_t(), gcd);
+                    if(reduce) bigRatReduce<false>();
+                }
                 break;
             }
-            case typePair(WordRat, WordInt):{
-                rat64_t ans;
-                rat64_t lhs = asWordRat();
-                int32_t rhs = other.asWordInt();
-                if(rat64_t::multiply(lhs, rhs, ans)){
-                    mpq_class* result = new mpq_class(lhs.num, lhs.den);
-                    result->operator*=(rhs);
-                    data = result;
-                    type = GmpRat;
-                    if(reduce) bigRatReduce();
-                }else if(ans.den == 1){
-                    data = reinterpret_cast<void*>(ans.num);
-                    type = WordInt;
-                }else{
-                    data = ans;
+            case typePair(GmpRat, WordInt):{
+                const int64_t rhs = other.asWordInt();
+                if(rhs == 0){
+                    setZero();
+                    break;
                 }
+                mpq_class& q = mutableBigRat();
+                const unsigned long gcd = mpz_gcd_ui(nullptr, q.get_den_mpz_t(), std::abs(rhs));
+                mpz_divexact_ui(q.get_den_mpz_t(), q.get_den_mpz_t(), gcd);
+                growLimbs(q.get_num_mpz_t(), mpz_size(q.get_num_mpz_t()) + 1);
+                mpz_mul_si(q.get_num_mpz_t(), q.get_num_mpz_t(), rhs/static_cast<long>(gcd));
+                if(reduce) bigRatReduce<false>();
                 break;
             }
-            case typePair(WordRat, WordRat):{
-                rat64_t ans;
-                rat64_t lhs = asWordRat();
-                rat64_t rhs = other.asWordRat();
-                if(rat64_t::multiply(lhs, rhs, ans)){
-                    mpq_class* result = new mpq_class(lhs.num, lhs.den);
-                    result->operator*=(rhs.num);
-                    result->operator/=(rhs.den);
-                    data = result;
-                    type = GmpRat;
-                    if(reduce) bigRatReduce();
-                }else if(ans.den == 1){
-                    data = reinterpret_cast<void*>(ans.num);
-                    type = WordInt;
+            case typePair(GmpRat, WordRat):{
+                const rat64_t rhs = other.asWordRat();
+                if(rhs.num == 0){
+                    setZero();
+                    break;
+                }
+                mpq_class& q = mutableBigRat();
+                const unsigned long gcd1 = mpz_gcd_ui(nullptr, q.get_num_mpz_t(), rhs.den);
+                const unsigned long gcd2 = mpz_gcd_ui(nullptr, q.get_den_mpz_t(), rat64_t::safeAbs(rhs.num));
+                mpz_divexact_ui(q.get_num_mpz_t(), q.get_num_mpz_t(), gcd1);
+                growLimbs(q.get_num_mpz_t(), mpz_size(q.get_num_mpz_t()) + 1);
+                mpz_mul_si(q.get_num_mpz_t(), q.get_num_mpz_t(), rhs.num/static_cast<long>(gcd2));
+                mpz_divexact_ui(q.get_den_mpz_t(), q.get_den_mpz_t(), gcd2);
+                growLimbs(q.get_den_mpz_t(), mpz_size(q.get_den_mpz_t()) + 1);
+                mpz_mul_ui(q.get_den_mpz_t(), q.get_den_mpz_t(), rhs.den/gcd1);
+                if(reduce) bigRatReduce<false>();
+                break;
+            }
+            case typePair(GmpRat, GmpInt):{
+                mpq_class& q = mutableBigRat();
+                ScratchInt factor;
+                mpz_gcd(factor, q.get_den_mpz_t(), other.asBigInt().get_mpz_t());
+                mpz_divexact(q.get_den_mpz_t(), q.get_den_mpz_t(), factor);
+                mpz_divexact(factor, other.asBigInt().get_mpz_t(), factor);
+                mpz_mul(q.get_num_mpz_t(), q.get_num_mpz_t(), factor);
+                if(reduce) bigRatReduce<false>();
+                break;
+            }
+            case typePair(GmpRat, GmpRat):
+                mutableBigRat() *= other.asBigRat();
+                if(reduce) bigRatReduce<false>();
+                break;
+            case typePair(WordInt, WideInt):
+            case typePair(WideInt, WordInt):
+            case typePair(WideInt, WideInt):
+                setWideProduct(wideOperand(), other.wideOperand());
+                break;
+            case typePair(WideInt, WordRat):
+            case typePair(WideInt, GmpInt):
+            case typePair(WideInt, GmpRat):
+            case typePair(WordRat, WideInt):
+            case typePair(GmpInt, WideInt):
+            case typePair(GmpRat, WideInt):
+                throughBig<reduce>(other, [](NumType& lhs, const NumType& rhs){ lhs.operator*=<reduce>(rhs); });
+                break;
+            case typePair(Dyadic, WordInt):
+            case typePair(Dyadic, WordRat):
+            case typePair(Dyadic, WideInt):
+            case typePair(Dyadic, Dyadic):
+            case typePair(WordInt, Dyadic):
+            case typePair(WordRat, Dyadic):
+            case typePair(WideInt, Dyadic):
+                if(setDyadicProduct(other)) break;
+                [[fallthrough]];
+            case typePair(Dyadic, GmpInt):
+            case typePair(Dyadic, GmpRat):
+            case typePair(GmpInt, Dyadic):
+            case typePair(GmpRat, Dyadic):
+                if(setBigDyadic<true>(other)) break;
+                throughRat<reduce>(other, [](NumType& lhs, const NumType& rhs){ lhs.operator*=<reduce>(rhs); });
+                break;
+            case typePair(Decimal, WordInt):
+            case typePair(Decimal, WordRat):
+            case typePair(Decimal, WideInt):
+            case typePair(Decimal, Dyadic):
+            case typePair(Decimal, Decimal):
+            case typePair(WordInt, Decimal):
+            case typePair(WordRat, Decimal):
+            case typePair(WideInt, Decimal):
+            case typePair(Dyadic, Decimal):
+                if(setDecimalProduct(other)) break;
+                [[fallthrough]];
+            case typePair(Decimal, GmpInt):
+            case typePair(Decimal, GmpRat):
+            case typePair(GmpInt, Decimal):
+            case typePair(GmpRat, Decimal):
+                throughRat<reduce>(other, [](NumType& lhs, const NumType& rhs){ lhs.operator*=<reduce>(rhs); });
+                break;
+            default: assert(false);
+        }
+    }
+
+    template<bool reduce = true>
+    NumType operator*(const NumType& other) const&{
+        NumType ans(*this);
+        ans.operator*=<reduce>(other);
+        return ans;
+    }
+
+    template<bool reduce = true>
+    NumType operator*(const NumType& other) &&{
+        operator*=<reduce>(other);
+        return std::move(*this);
+    }
+
+    friend NumType operator*(const NumType& lhs, NumType&& rhs){
+        if(!rhs.isGmp()) return lhs * static_cast<const NumType&>(rhs);
+        rhs *= lhs;
+        return std::move(rhs);
+    }
+
+    friend NumType operator*(NumType&& lhs, NumType&& rhs){
+        if(rhs.isGmp() && !lhs.isGmp()) return static_cast<const NumType&>(lhs) * std::move(rhs);
+        lhs *= rhs;
+        return std::move(lhs);
+    }
+
+    NumType reciprocal() const{
+        switch (type) {
+            case WordInt:{
+                int64_t z = asWordInt();
+                assert(z != 0);
+                if(z == 1 || z == -1) return NumType(static_cast<int32_t>(z));
+                return (z>=0) ? NumType(1,z) : NumType(-1,-z);
+            }
+            case WordRat:{
+                rat64_t q = asWordRat();
+                if(q.num == 1 || q.num == -1){
+                    return fromWide(q.num * static_cast<WideWord>(q.den));
+                }else if(q.den < std::numeric_limits<int32_t>::max()){
+                    return (q.num>=0) ? NumType(q.den, q.num) : NumType(-(int32_t)q.den, -q.num);
                 }else{
-                    data = ans;
+                    mpq_class recip(q.den, q.num);
+                    recip.canonicalize();
+                    return recip;
+                }
+            }
+            case GmpInt:{
+                mpq_class recip(1, asBigInt());
+                recip.canonicalize();
+                return recip;
+            }
+            case GmpRat:{
+                mpq_class recip;
+                mpq_inv(recip.get_mpq_t(), asBigRat().get_mpq_t());
+                NumType ans(std::move(recip));
+                ans.bigRatReduce<false>();
+                return ans;
+            }
+            case WideInt:{
+                ScratchRat recip;
+                mpz_set_ui(mpq_numref(recip.q), 1);
+                setWide(mpq_denref(recip.q), asWide());
+                mpq_canonicalize(recip);
+                return fromScratch(recip.q);
+            }
+            case Dyadic:{
+                //2^e/m is reduced because m is odd
+                ScratchRat recip;
+                mpz_set_ui(mpq_numref(recip.q), 0);
+                mpz_setbit(mpq_numref(recip.q), dyadicExponent());
+                setInt64(mpq_denref(recip.q), dyadicMantissa());
+                quotientSign(recip.q);
+                return fromScratch(recip.q);
+            }
+            case Decimal:{
+                WideWord num, den;
+                decimalFraction(decimalMantissa(), decimalScale(), num, den);
+                NumType ans;
+                ans.storeWideFraction(num < 0 ? -den : den, num < 0 ? -num : num);
+                return ans;
+            }
+        }
+    }
+
+    //Replaces a word tier value with (a/b)/(c/d). Falls back to the product a/b * d/c when the word divide overflows.
+    template<bool reduce = true>
+    void setWordQuotient(const rat64_t& lhs, const rat64_t& rhs){
+        rat64_t ans;
+        if(!rat64_t::divide(lhs, rhs, ans)) setWordResult(ans);
+        else setWordProduct<reduce>(lhs.num, lhs.den,
+                                    rhs.num < 0 ? -static_cast<int64_t>(rhs.den) : static_cast<int64_t>(rhs.den),
+                                    rat64_t::safeAbs(rhs.num));
+    }
+
+    static UnsignedWideWord wideGcd(UnsignedWideWord a, UnsignedWideWord b) noexcept{
+        while(b != 0){
+            const UnsignedWideWord r = a % b;
+            a = b;
+            b = r;
+        }
+        return a;
+    }
+
+    //The quotient of two integers in the word or wide tiers
+    void setWideQuotient(WideWord a, WideWord b){
+        assert(b != 0);
+        if(b < 0){
+            a = -a;
+            b = -b;
+        }
+        const WideWord gcd = static_cast<WideWord>(wideGcd(a < 0 ? -static_cast<UnsignedWideWord>(a) : a, b));
+        storeWideFraction(a / gcd, b / gcd);
+    }
+
+    //Stores a reduced fraction a/b with b > 0 in its canonical tier
+    void storeWideFraction(WideWord a, WideWord b){
+        assert(b > 0);
+        if(b == 1){
+            storeWide(a);
+        }else if(a <= std::numeric_limits<int32_t>::max() && a > std::numeric_limits<int32_t>::min() &&
+                 b <= std::numeric_limits<uint32_t>::max()){
+            if(type == WideInt) WideSlab::release(wideSlot());
+            rat64_t ans;
+            ans.num = static_cast<int32_t>(a);
+            ans.den = static_cast<uint32_t>(b);
+            data = ans;
+            type = WordRat;
+        }else{
+            releaseBig();
+            SharedBigRat* next = sizedBigRat(wideBitLength(a), wideBitLength(b));
+            setWide(mpq_numref(next->val.get_mpq_t()), a);
+            setWide(mpq_denref(next->val.get_mpq_t()), b);
+            data = next;
+            type = GmpRat;
+        }
+    }
+
+    //Moves the sign of a quotient onto its numerator
+    static void quotientSign(mpq_ptr q){
+        if(mpz_sgn(mpq_denref(q)) < 0){
+            mpz_neg(mpq_numref(q), mpq_numref(q));
+            mpz_neg(mpq_denref(q), mpq_denref(q));
+        }
+    }
+
+    //Division cross-reduces the operands like multiplication, without building the reciprocal of the divisor
+    template<bool reduce = true>
+    void operator/=(const NumType& other){
+        NUMTYPE_OP_HOOK('/', other);
+        switch(typePair(type, other.type)){
+            case typePair(WordInt, WordInt):{
+                int64_t a = asWordInt();
+                int64_t b = other.asWordInt();
+                assert(b != 0);
+                if(b < 0){
+                    a = -a;
+                    b = -b;
                 }
+                //Word integers exclude INT32_MIN, so the reduced quotient always fits a word. It is stored
+                //field by field, as the two argument constructor would take the gcd a second time.
+                const int64_t gcd = std::gcd(a, b);
+                rat64_t ans;
+                ans.num = static_cast<int32_t>(a/gcd);
+                ans.den = static_cast<uint32_t>(b/gcd);
+                setWordResult(ans);
+                break;
+            }
+            case typePair(WordInt, WordRat):
+                setWordQuotient<reduce>(rat64_t(static_cast<int32_t>(asWordInt())), other.asWordRat());
+                break;
+            case typePair(WordRat, WordInt):
+                assert(other.data != 0);
+                setWordQuotient<reduce>(asWordRat(), rat64_t(static_cast<int32_t>(other.asWordInt())));
+                break;
+            case typePair(WordRat, WordRat):
+                setWordQuotient<reduce>(asWordRat(), other.asWordRat());
+                break;
+            case typePair(WordInt, GmpInt):{
+                const int64_t lhs = asWordInt();
+                const mpz_class& rhs = other.asBigInt();
+                assert(sgn(rhs) != 0);
+                if(lhs == 0) break;
+                const unsigned long gcd = mpz_gcd_ui(nullptr, rhs.get_mpz_t(), std::abs(lhs));
+                SharedBigRat* next = sizedBigRat(32, bitLength(rhs));
+                setInt64(mpq_numref(next->val.get_mpq_t()), lhs/static_cast<long>(gcd));
+                mpz_divexact_ui(mpq_denref(next->val.get_mpq_t()), rhs.get_mpz_t(), gcd);
+                quotientSign(next->val.get_mpq_t());
+                data = next;
+                type = GmpRat;
+                if(reduce) bigRatReduce<false>();
+                break;
+            }
+            case typePair(WordInt, GmpRat):{
+                const int64_t lhs = asWordInt();
+                const mpq_class& rhs = other.asBigRat();
+                assert(sgn(rhs) != 0);
+                if(lhs == 0) break;
+                const unsigned long gcd = mpz_gcd_ui(nullptr, rhs.get_num_mpz_t(), std::abs(lhs));
+                SharedBigRat* next = sizedBigRat(32 + bitLength(rhs.get_den()), bitLength(rhs.get_num()));
+                mpz_mul_si(mpq_numref(next->val.get_mpq_t()), rhs.get_den_mpz_t(), lhs/static_cast<long>(gcd));
+                mpz_divexact_ui(mpq_denref(next->val.get_mpq_t()), rhs.get_num_mpz_t(), gcd);
+                quotientSign(next->val.get_mpq_t());
+                data = next;
+                type = GmpRat;
+                if(reduce) bigRatReduce<false>();
                 break;
             }
             case typePair(WordRat, GmpInt):{
-                mpq_class* next = new mpq_class(other.asBigInt());
-                next->operator*=(asWordRat().num);
-                next->operator/=(asWordRat().den);
+                const rat64_t lhs = asWordRat();
+                const mpz_class& rhs = other.asBigInt();
+                assert(sgn(rhs) != 0);
+                if(lhs.num == 0){
+                    setZero();
+                    break;
+                }
+                const unsigned long gcd = mpz_gcd_ui(nullptr, rhs.get_mpz_t(), rat64_t::safeAbs(lhs.num));
+                SharedBigRat* next = sizedBigRat(32, 32 + bitLength(rhs));
+                mpz_ptr den = mpq_denref(next->val.get_mpq_t());
+                mpz_set_si(mpq_numref(next->val.get_mpq_t()), lhs.num/static_cast<long>(gcd));
+                mpz_divexact_ui(den, rhs.get_mpz_t(), gcd);
+                mpz_mul_ui(den, den, lhs.den);
+                quotientSign(next->val.get_mpq_t());
                 data = next;
                 type = GmpRat;
-                if(reduce) bigRatReduce();
+                if(reduce) bigRatReduce<false>();
                 break;
             }
             case typePair(WordRat, GmpRat):{
-                mpq_class* next = new mpq_class(other.asBigRat());
-                next->operator*=(asWordRat().num);
-                next->operator/=(asWordRat().den);
+                const rat64_t lhs = asWordRat();
+                const mpq_class& rhs = other.asBigRat();
+                assert(sgn(rhs) != 0);
+                if(lhs.num == 0){
+                    setZero();
+                    break;
+                }
+                const unsigned long gcd1 = mpz_gcd_ui(nullptr, rhs.get_num_mpz_t(), rat64_t::safeAbs(lhs.num));
+                const unsigned long gcd2 = mpz_gcd_ui(nullptr, rhs.get_den_mpz_t(), lhs.den);
+                SharedBigRat* next = sizedBigRat(32 + bitLength(rhs.get_den()), 32 + bitLength(rhs.get_num()));
+                mpz_ptr num = mpq_numref(next->val.get_mpq_t());
+                mpz_ptr den = mpq_denref(next->val.get_mpq_t());
+                mpz_divexact_ui(num, rhs.get_den_mpz_t(), gcd2);
+                mpz_mul_si(num, num, lhs.num/static_cast<long>(gcd1));
+                mpz_divexact_ui(den, rhs.get_num_mpz_t(), gcd1);
+                mpz_mul_ui(den, den, lhs.den/gcd2);
+                quotientSign(next->val.get_mpq_t());
                 data = next;
                 type = GmpRat;
-                if(reduce) bigRatReduce();
+                if(reduce) bigRatReduce<false>();
                 break;
             }
-            case typePair(GmpInt, WordInt):
-                if(other.data == 0){
-                    delete reinterpret_cast<mpz_class*>(data);
-                    data = 0;
-                    type = WordInt;
+            case typePair(GmpInt, WordInt):{
+                const int64_t rhs = other.asWordInt();
+                assert(rhs != 0);
+                const unsigned long gcd = mpz_gcd_ui(nullptr, asBigInt().get_mpz_t(), std::abs(rhs));
+                mpz_class& z = mutableBigInt();
+                mpz_divexact_ui(z.get_mpz_t(), z.get_mpz_t(), gcd);
+                if(rhs < 0) mpz_neg(z.get_mpz_t(), z.get_mpz_t());
+                if(static_cast<unsigned long>(std::abs(rhs)) == gcd){
+                    if(reduce) bigIntReduce();
                 }else{
-                    asBigInt() *= (int32_t)other.asWordInt();
+                    mpq_class& q = promoteBigIntToBigRat();
+                    mpz_set_ui(q.get_den_mpz_t(), std::abs(rhs)/gcd);
+                    if(reduce) bigRatReduce<false>();
                 }
                 break;
+            }
             case typePair(GmpInt, WordRat):{
-                mpq_class* next = new mpq_class(asBigInt());
-                delete reinterpret_cast<mpz_class*>(data);
-                next->operator*=(other.asWordRat().num);
-                next->operator/=(other.asWordRat().den);
-                data = next;
-                type = GmpRat;
-                if(reduce) bigRatReduce();
+                const rat64_t rhs = other.asWordRat();
+                assert(rhs.num != 0);
+                const unsigned long magnitude = rat64_t::safeAbs(rhs.num);
+                const unsigned long gcd = mpz_gcd_ui(nullptr, asBigInt().get_mpz_t(), magnitude);
+                mpz_class& z = mutableBigInt();
+                mpz_divexact_ui(z.get_mpz_t(), z.get_mpz_t(), gcd);
+                mpz_mul_si(z.get_mpz_t(), z.get_mpz_t(), rhs.num < 0 ? -static_cast<long>(rhs.den) : static_cast<long>(rhs.den));
+                if(magnitude == gcd){
+                    if(reduce) bigIntReduce();
+                }else{
+                    mpq_class& q = promoteBigIntToBigRat();
+                    mpz_set_ui(q.get_den_mpz_t(), magnitude/gcd);
+                    if(reduce) bigRatReduce<false>();
+                }
                 break;
             }
-            case typePair(GmpInt, GmpInt):
-                asBigInt() *= other.asBigInt();
+            case typePair(GmpInt, GmpInt):{
+                //The divisor may share this payload, so its reduced value is taken before any writes
+                assert(sgn(other.asBigInt()) != 0);
+                ScratchInt gcd, den;
+                mpz_gcd(gcd, asBigInt().get_mpz_t(), other.asBigInt().get_mpz_t());
+                if(mpz_sgn(other.asBigInt().get_mpz_t()) < 0) mpz_neg(gcd, gcd);
+                mpz_divexact(den, other.asBigInt().get_mpz_t(), gcd);
+                mpz_class& z = mutableBigInt();
+                mpz_divexact(z.get_mpz_t(), z.get_mpz_t(), gcd);
+                if(mpz_cmp_ui(den.z, 1) == 0){
+                    if(reduce) bigIntReduce();
+                }else{
+                    mpq_class& q = promoteBigIntToBigRat();
+                    mpz_swap(q.get_den_mpz_t(), den);
+                    if(reduce) bigRatReduce<false>();
+                }
                 break;
+            }
             case typePair(GmpInt, GmpRat):{
-                mpq_class* result = new mpq_class(asBigInt() * other.asBigRat());
-                delete reinterpret_cast<mpz_class*>(data);
-                data = result;
-                type = GmpRat;
-                if(reduce) bigRatReduce();
+                const mpq_class& rhs = other.asBigRat();
+                assert(sgn(rhs) != 0);
+                ScratchInt gcd;
+                mpz_gcd(gcd, asBigInt().get_mpz_t(), rhs.get_num_mpz_t());
+                if(mpz_sgn(rhs.get_num_mpz_t()) < 0) mpz_neg(gcd, gcd);
+                mpz_class& z = mutableBigInt();
+                mpz_divexact(z.get_mpz_t(), z.get_mpz_t(), gcd);
+                mpz_mul(z.get_mpz_t(), z.get_mpz_t(), rhs.get_den_mpz_t());
+                if(mpz_cmp(rhs.get_num_mpz_t(), gcd) == 0){
+                    if(reduce) bigIntReduce();
+                }else{
+                    mpq_class& q = promoteBigIntToBigRat();
+                    mpz_divexact(q.get_den_mpz_t(), rhs.get_num_mpz_t(), gcd);
+                    if(reduce) bigRatReduce<false>();
+                }
                 break;
             }
-            case typePair(GmpRat, WordInt):
-                asBigRat() *= (int32_t)other.asWordInt();
-                if(reduce) bigRatReduce();
+            case typePair(GmpRat, WordInt):{
+                const int64_t rhs = other.asWordInt();
+                assert(rhs != 0);
+                mpq_class& q = mutableBigRat();
+                const unsigned long gcd = mpz_gcd_ui(nullptr, q.get_num_mpz_t(), std::abs(rhs));
+                mpz_divexact_ui(q.get_num_mpz_t(), q.get_num_mpz_t(), gcd);
+                if(rhs < 0) mpz_neg(q.get_num_mpz_t(), q.get_num_mpz_t());
+                mpz_mul_ui(q.get_den_mpz_t(), q.get_den_mpz_t(), std::abs(rhs)/gcd);
+                if(reduce) bigRatReduce<false>();
                 break;
-            case typePair(GmpRat, WordRat):
-                asBigRat() *= other.asWordRat().num;
-                asBigRat() /= other.asWordRat().den;
-                if(reduce) bigRatReduce();
+            }
+            case typePair(GmpRat, WordRat):{
+                const rat64_t rhs = other.asWordRat();
+                assert(rhs.num != 0);
+                mpq_class& q = mutableBigRat();
+                const unsigned long gcd1 = mpz_gcd_ui(nullptr, q.get_num_mpz_t(), rat64_t::safeAbs(rhs.num));
+                const unsigned long gcd2 = mpz_gcd_ui(nullptr, q.get_den_mpz_t(), rhs.den);
+                mpz_divexact_ui(q.get_num_mpz_t(), q.get_num_mpz_t(), gcd1);
+                mpz_mul_si(q.get_num_mpz_t(), q.get_num_mpz_t(),
+                           (rhs.num < 0 ? -static_cast<long>(rhs.den) : static_cast<long>(rhs.den))/static_cast<long>(gcd2));
+                mpz_divexact_ui(q.get_den_mpz_t(), q.get_den_mpz_t(), gcd2);
+                mpz_mul_ui(q.get_den_mpz_t(), q.get_den_mpz_t(), rat64_t::safeAbs(rhs.num)/gcd1);
+                if(reduce) bigRatReduce<false>();
                 break;
-            case typePair(GmpRat, GmpInt):
-                asBigRat() *= other.asBigInt();
-                if(reduce) bigRatReduce();
+            }
+            case typePair(GmpRat, GmpInt):{
+                assert(sgn(other.asBigInt()) != 0);
+                mpq_class& q = mutableBigRat();
+                ScratchInt factor;
+                mpz_gcd(factor, q.get_num_mpz_t(), other.asBigInt().get_mpz_t());
+                if(mpz_sgn(other.asBigInt().get_mpz_t()) < 0) mpz_neg(factor, factor);
+                mpz_divexact(q.get_num_mpz_t(), q.get_num_mpz_t(), factor);
+                mpz_divexact(factor, other.asBigInt().get_mpz_t(), factor);
+                mpz_mul(q.get_den_mpz_t(), q.get_den_mpz_t(), factor);
+                if(reduce) bigRatReduce<false>();
                 break;
+            }
             case typePair(GmpRat, GmpRat):
-                asBigRat() *= other.asBigRat();
-                if(reduce) bigRatReduce();
+                assert(sgn(other.asBigRat()) != 0);
+                mpq_div(mutableBigRat().get_mpq_t(), asBigRat().get_mpq_t(), other.asBigRat().get_mpq_t());
+                if(reduce) bigRatReduce<false>();
+                break;
+            case typePair(WordInt, WideInt):
+            case typePair(WideInt, WordInt):
+            case typePair(WideInt, WideInt):
+                setWideQuotient(wideOperand(), other.wideOperand());
+                break;
+            case typePair(WideInt, WordRat):
+            case typePair(WideInt, GmpInt):
+            case typePair(WideInt, GmpRat):
+            case typePair(WordRat, WideInt):
+            case typePair(GmpInt, WideInt):
+            case typePair(GmpRat, WideInt):
+                throughBig<reduce>(other, [](NumType& lhs, const NumType& rhs){ lhs.operator/=<reduce>(rhs); });
+                break;
+            case typePair(Dyadic, WordInt):
+            case typePair(Dyadic, WordRat):
+            case typePair(Dyadic, WideInt):
+            case typePair(Dyadic, Dyadic):
+            case typePair(WordInt, Dyadic):
+            case typePair(WordRat, Dyadic):
+            case typePair(WideInt, Dyadic):
+                if(setDyadicQuotient(other)) break;
+                [[fallthrough]];
+            case typePair(Dyadic, GmpInt):
+            case typePair(Dyadic, GmpRat):
+            case typePair(GmpInt, Dyadic):
+            case typePair(GmpRat, Dyadic):
+                throughRat<reduce>(other, [](NumType& lhs, const NumType& rhs){ lhs.operator/=<reduce>(rhs); });
+                break;
+            case typePair(Decimal, WordInt):
+            case typePair(Decimal, WordRat):
+            case typePair(Decimal, WideInt):
+            case typePair(Decimal, Dyadic):
+            case typePair(Decimal, Decimal):
+            case typePair(WordInt, Decimal):
+            case typePair(WordRat, Decimal):
+            case typePair(WideInt, Decimal):
+            case typePair(Dyadic, Decimal):
+                if(setDecimalQuotient(other)) break;
+                [[fallthrough]];
+            case typePair(Decimal, GmpInt):
+            case typePair(Decimal, GmpRat):
+            case typePair(GmpInt, Decimal):
+            case typePair(GmpRat, Decimal):
+                throughRat<reduce>(other, [](NumType& lhs, const NumType& rhs){ lhs.operator/=<reduce>(rhs); });
+                break;
+            default: assert(false);
+        }
+    }
+
+    void invert(){
+        switch (type) {
+            case WordInt:
+            case WordRat:
+            case WideInt:
+            case Dyadic:
+            case Decimal:
+                *this = reciprocal();
+                break;
+            case GmpInt:{
+                //Hand the limbs over to the denominator instead of copying them
+                SharedBigRat* q = new SharedBigRat();
+                mpz_swap(mpq_denref(q->val.get_mpq_t()), mutableBigInt().get_mpz_t());
+                mpz_set_ui(mpq_numref(q->val.get_mpq_t()), 1);
+                mpq_canonicalize(q->val.get_mpq_t());
+                bigIntPayload()->release();
+                data = q;
+                type = GmpRat;
+                break;
+            }
+            case GmpRat:{
+                mpq_class& q = mutableBigRat();
+                mpq_inv(q.get_mpq_t(), q.get_mpq_t());
+                bigRatReduce<false>();
                 break;
+            }
+        }
+    }
+
+    template<bool reduce = true>
+    NumType operator/(const NumType& other) const&{
+        NumType ans(*this);
+        ans.operator/=<reduce>(other);
+        return ans;
+    }
+
+    template<bool reduce = true>
+    NumType operator/(const NumType& other) &&{
+        operator/=<reduce>(other);
+        return std::move(*this);
+    }
+
+    friend NumType operator/(const NumType& lhs, NumType&& rhs){
+        if(!rhs.isGmp()) return lhs / static_cast<const NumType&>(rhs);
+        rhs.invert();
+        rhs *= lhs;
+        return std::move(rhs);
+    }
+
+    friend NumType operator/(NumType&& lhs, NumType&& rhs){
+        if(rhs.isGmp() && !lhs.isGmp()) return static_cast<const NumType&>(lhs) / std::move(rhs);
+        lhs /= rhs;
+        return std::move(lhs);
+    }
+
+    void inPlaceIntegerDivide(const NumType& other){
+        switch (typePair(type, other.type)) {
+            case typePair(WordInt, WordInt):
+                assert(asWordInt() % other.asWordInt() == 0);
+                data = reinterpret_cast<void*>(asWordInt() / other.asWordInt());
+                return;
+            case typePair(GmpInt, WordInt):{
+                assert(asBigInt() % other.asWordInt() == 0);
+                mutableBigInt() /= other.asWordInt();
+                bigIntReduce();
+                return;
+            }
+            case typePair(GmpInt, GmpInt):{
+                assert(asBigInt() % other.asBigInt() == 0);
+                mutableBigInt() /= other.asBigInt();
+                bigIntReduce();
+                return;
+            }
+            case typePair(WordInt, WideInt):
+            case typePair(WideInt, WordInt):
+            case typePair(WideInt, WideInt):
+                assert(wideOperand() % other.wideOperand() == 0);
+                storeWide(wideOperand() / other.wideOperand());
+                return;
+            case typePair(WideInt, GmpInt):
+                widenToBig();
+                inPlaceIntegerDivide(other);
+                return;
+            case typePair(GmpInt, WideInt):
+                inPlaceIntegerDivide(other.wideToBig());
+                return;
+            default: assert(false);
+        }
+    }
+
+    NumType integerDivide(const NumType& other) const{
+        NumType ans(*this);
+        ans.inPlaceIntegerDivide(other);
+        return ans;
+    }
+
+    void inPlaceIntegerDivide(int32_t other){
+        switch (type) {
+            case WordInt:
+                assert(asWordInt() % other == 0);
+                data = reinterpret_cast<void*>(asWordInt() / other);
+                return;
+            case GmpInt:{
+                assert(asBigInt() % other == 0);
+                mutableBigInt() /= other;
+                bigIntReduce();
+                return;
+            }
+            case WideInt:
+                assert(asWide() % other == 0);
+                storeWide(asWide() / other);
+                return;
             default: assert(false);
         }
     }
 
-    template<bool reduce = true>
-    NumType operator*(const NumType& other) const{
-        NumType ans(*this);
-        ans.operator*=<reduce>(other);
-        return ans;
+    NumType integerDivide(int32_t other) const{
+        NumType ans(*this);
+        ans.inPlaceIntegerDivide(other);
+        return ans;
+    }
+
+    static NumType fromDivisor(const rat64_t::Divisor& divisor){
+        const WideWord p = divisor.num.divisor;
+        NumType ans;
+        ans.storeWideFraction(divisor.negative ? -p : p, divisor.den.divisor);
+        return ans;
+    }
+
+    //Divides every value by one precomputed divisor. Word tier values divide with the cached factors and
+    //reciprocals of the divisor, anything wider or a quotient which overflows takes the usual operator/=.
+    static void divide(NumType* values, size_t n, const rat64_t::Divisor& divisor){
+        const NumType fallback = fromDivisor(divisor);
+        for(size_t i = 0; i < n; i++){
+            NumType& val = values[i];
+            if(val.type == WordInt || val.type == WordRat){
+                rat64_t ans;
+                if(!rat64_t::divide(val.wordOperand(), divisor, ans)){
+                    val.setWordResult(ans);
+                    continue;
+                }
+            }
+            val /= fallback;
+        }
+    }
+
+    static void divide(std::vector<NumType>& values, const rat64_t::Divisor& divisor){
+        divide(values.data(), values.size(), divisor);
+    }
+
+    //inPlaceIntegerDivide of every value by one precomputed integer divisor
+    static void integerDivide(NumType* values, size_t n, const rat64_t::Divisor& divisor){
+        assert(divisor.den.divisor == 1);
+        const NumType fallback = fromDivisor(divisor);
+        for(size_t i = 0; i < n; i++){
+            NumType& val = values[i];
+            if(val.type == WordInt){
+                const int64_t z = val.asWordInt();
+                const uint32_t magnitude = static_cast<uint32_t>(z < 0 ? -z : z);
+                assert(divisor.num.divides(magnitude));
+                const int64_t q = divisor.num.quotient(magnitude);
+                val.data = reinterpret_cast<void*>((z < 0) != divisor.negative ? -q : q);
+            }else{
+                val.inPlaceIntegerDivide(fallback);
+            }
+        }
+    }
+
+    static void integerDivide(std::vector<NumType>& values, const rat64_t::Divisor& divisor){
+        integerDivide(values.data(), values.size(), divisor);
+    }
+
+    //How a quotient is rounded to an integer. The remainder is always n - q*d for the rounded q.
+    enum Rounding{
+        Floor,
+        Ceil,
+        Trunc,
+        HalfEven,
+    };
+
+    //One hardware division of n by d, then a correction of the truncated quotient
+    template<Rounding mode, typename Int>
+    static Int roundedQuotient(Int n, Int d, Int& r) noexcept{
+        Int q = n / d;
+        r = n % d;
+        if(r == 0 || mode == Trunc) return q;
+        const bool same_sign = (r < 0) == (d < 0);
+        if(mode == Ceil){
+            if(same_sign){
+                q++;
+                r -= d;
+            }
+            return q;
+        }
+        if(!same_sign){
+            q--;
+            r += d;
+        }
+        if(mode == HalfEven){
+            //r now has the sign of d, so compare |r| to |d|/2 without doubling r
+            const Int abs_r = r < 0 ? -r : r;
+            const Int abs_d = d < 0 ? -d : d;
+            if(abs_r > abs_d - abs_r || (abs_r == abs_d - abs_r && (q & 1))){
+                q++;
+                r -= d;
+            }
+        }
+        return q;
+    }
+
+    template<Rounding mode>
+    static void roundedQuotient(mpz_ptr q, mpz_ptr r, mpz_srcptr n, mpz_srcptr d){
+        switch (mode) {
+            case Floor: mpz_fdiv_qr(q, r, n, d); return;
+            case Ceil: mpz_cdiv_qr(q, r, n, d); return;
+            case Trunc: mpz_tdiv_qr(q, r, n, d); return;
+            case HalfEven:{
+                mpz_fdiv_qr(q, r, n, d);
+                ScratchInt twice;
+                mpz_mul_2exp(twice, r, 1);
+                const int cmp = mpz_cmpabs(twice, d);
+                if(cmp > 0 || (cmp == 0 && mpz_odd_p(q))){
+                    mpz_add_ui(q, q, 1);
+                    mpz_sub(r, r, d);
+                }
+                return;
+            }
+        }
     }
 
-    NumType reciprocal() const{
+    //A word fraction n/d with d > 0 in its canonical tier
+    static NumType fromWordFraction(int64_t n, uint64_t d){
+        const uint64_t gcd = std::gcd(rat64_t::wordAbs(n), d);
+        n /= static_cast<int64_t>(gcd);
+        d /= gcd;
+        if(d == 1) return fromWide(n);
+        if(fitsWordInt(n) && d <= std::numeric_limits<uint32_t>::max()){
+            rat64_t ans;
+            ans.num = static_cast<int32_t>(n);
+            ans.den = static_cast<uint32_t>(d);
+            return NumType(ans);
+        }
+        ScratchRat q;
+        setInt64(mpq_numref(q.q), n);
+        setUint64(mpq_denref(q.q), d);
+        return fromScratch(q.q);
+    }
+
+    //GMP views of the numerator and denominator. Word and wide values are copied into the scratch register,
+    //and the denominator of an integer is null.
+    void fractionView(mpq_ptr scratch, mpz_srcptr& num, mpz_srcptr& den) const{
+        den = nullptr;
         switch (type) {
-            case WordInt:{
-                int64_t z = asWordInt();
-                return (z>=0) ? NumType(1,z) : NumType(-1,-z);
-            }
-            case WordRat:{
-                rat64_t q = asWordRat();
-                if(q.num == 1){
-                    return (q.den < std::numeric_limits<int32_t>::max()) ?
-                            NumType(q.den) :
-                            NumType(mpz_class(q.den));
-                }else if(q.den < std::numeric_limits<int32_t>::max()){
-                    return (q.num>=0) ? NumType(q.den, q.num) : NumType(-(int32_t)q.den, -q.num);
-                }else{
-                    return mpq_class(q.den,q.num);
-                }
+            case WordInt:
+                setInt64(mpq_numref(scratch), asWordInt());
+                num = mpq_numref(scratch);
+                return;
+            case WordRat:
+                setInt64(mpq_numref(scratch), asWordRat().num);
+                mpz_set_ui(mpq_denref(scratch), asWordRat().den);
+                num = mpq_numref(scratch);
+                den = mpq_denref(scratch);
+                return;
+            case WideInt:
+                setWide(mpq_numref(scratch), asWide());
+                num = mpq_numref(scratch);
+                return;
+            case GmpInt:
+                num = asBigInt().get_mpz_t();
+                return;
+            case GmpRat:
+                num = asBigRat().get_num_mpz_t();
+                den = asBigRat().get_den_mpz_t();
+                return;
+            case Dyadic:
+                setInt64(mpq_numref(scratch), dyadicMantissa());
+                mpz_set_ui(mpq_denref(scratch), 0);
+                mpz_setbit(mpq_denref(scratch), dyadicExponent());
+                num = mpq_numref(scratch);
+                den = mpq_denref(scratch);
+                return;
+            case Decimal:{
+                WideWord n, d;
+                decimalFraction(decimalMantissa(), decimalScale(), n, d);
+                setWide(mpq_numref(scratch), n);
+                setWide(mpq_denref(scratch), d);
+                num = mpq_numref(scratch);
+                den = mpq_denref(scratch);
+                return;
             }
-            case GmpInt: return mpq_class(1, asBigInt());
-            case GmpRat: return asBigRat().get_num()==1 ?
-                         mpz_class(asBigRat().get_den()) :
-                         mpq_class(asBigRat().get_den(), asBigRat().get_num());
         }
     }
 
-    template<bool reduce = true>
-    void operator/=(const NumType& other){
-        switch (other.type) {
-            case WordInt:{
-                int64_t z = other.asWordInt();
-                operator*=( z>=0 ? NumType(1,z) : NumType(-1,-z) );
-                break;
+    //Computes q = round(this/other) and r = this - q*other in one division. Either output may be null.
+    //For a/b and c/d the integer division is of a*d by b*c, and the remainder is over b*d.
+    template<Rounding mode>
+    void roundedDivide(const NumType& other, NumType* quotient, NumType* remainder) const{
+        const bool lhs_word = type == WordInt || type == WordRat;
+        const bool rhs_word = other.type == WordInt || other.type == WordRat;
+        if(lhs_word && rhs_word){
+            const rat64_t lhs = type == WordInt ? rat64_t(static_cast<int32_t>(asWordInt())) : asWordRat();
+            const rat64_t rhs = other.type == WordInt ? rat64_t(static_cast<int32_t>(other.asWordInt())) : other.asWordRat();
+            assert(rhs.num != 0);
+            int64_t r;
+            const int64_t q = roundedQuotient<mode>(static_cast<int64_t>(lhs.num) * rhs.den,
+                                                    static_cast<int64_t>(rhs.num) * lhs.den, r);
+            if(quotient) *quotient = fromWide(q);
+            if(remainder) *remainder = fromWordFraction(r, static_cast<uint64_t>(lhs.den) * rhs.den);
+            return;
+        }
+        if((type == WordInt || type == WideInt) && (other.type == WordInt || other.type == WideInt)){
+            WideWord r;
+            const WideWord q = roundedQuotient<mode>(wideOperand(), other.wideOperand(), r);
+            if(quotient) *quotient = fromWide(q);
+            if(remainder) *remainder = fromWide(r);
+            return;
+        }
+
+        ScratchRat lhs_scratch, rhs_scratch;
+        mpz_srcptr lhs_num, lhs_den, rhs_num, rhs_den;
+        fractionView(lhs_scratch, lhs_num, lhs_den);
+        other.fractionView(rhs_scratch, rhs_num, rhs_den);
+        assert(mpz_sgn(rhs_num) != 0);
+        ScratchInt scaled_num, scaled_den, q, r;
+        mpz_srcptr n = lhs_num;
+        mpz_srcptr d = rhs_num;
+        if(rhs_den){
+            mpz_mul(scaled_num, lhs_num, rhs_den);
+            n = scaled_num;
+        }
+        if(lhs_den){
+            mpz_mul(scaled_den, lhs_den, rhs_num);
+            d = scaled_den;
+        }
+        roundedQuotient<mode>(q, r, n, d);
+        if(remainder){
+            if(!lhs_den && !rhs_den){
+                *remainder = fromScratch(r.z);
+            }else{
+                ScratchRat rem;
+                mpz_swap(mpq_numref(rem.q), r);
+                if(lhs_den && rhs_den) mpz_mul(mpq_denref(rem.q), lhs_den, rhs_den);
+                else mpz_set(mpq_denref(rem.q), lhs_den ? lhs_den : rhs_den);
+                mpq_canonicalize(rem.q);
+                *remainder = fromScratch(rem.q);
             }
+        }
+        if(quotient) *quotient = fromScratch(q.z);
+    }
+
+    //Floored division, so the remainder has the sign of the divisor
+    void divmod(const NumType& other, NumType& quotient, NumType& remainder) const{
+        roundedDivide<Floor>(other, &quotient, &remainder);
+    }
+
+    template<Rounding mode>
+    NumType rounded() const{
+        switch (type) {
+            case WordInt:
+            case WideInt:
+            case GmpInt:
+                return *this;
             case WordRat:{
-                rat64_t q = other.asWordRat();
-                operator*=(mpq_class(q.den, q.num));
-                break;
+                const rat64_t q = asWordRat();
+                int64_t r;
+                return fromWide(roundedQuotient<mode>(static_cast<int64_t>(q.num), static_cast<int64_t>(q.den), r));
             }
-            case GmpInt:
-                operator*=(mpq_class(1,other.asBigInt()));
-                break;
             case GmpRat:{
-                mpq_class recip = 1/other.asBigRat();
-                operator*=(recip);
-                break;
+                ScratchInt q, r;
+                roundedQuotient<mode>(q, r, asBigRat().get_num_mpz_t(), asBigRat().get_den_mpz_t());
+                return fromScratch(q.z);
+            }
+            case Dyadic:{
+                //Past 2^62 the magnitude is below 2^-7, which rounds the same as over 2^62
+                int64_t r;
+                return fromWide(roundedQuotient<mode>(dyadicMantissa(), int64_t(1) << std::min(dyadicExponent(), 62u), r));
+            }
+            case Decimal:{
+                int64_t r;
+                return fromWide(roundedQuotient<mode>(decimalMantissa(), static_cast<int64_t>(powers_of_ten[decimalScale()]), r));
             }
         }
+        assert(false);
+        return NumType();
     }
 
-    template<bool reduce = true>
-    NumType operator/(const NumType& other) const{
-        return operator*(other.reciprocal());
+    NumType floor() const{
+        return rounded<Floor>();
     }
 
-    void inPlaceIntegerDivide(const NumType& other){
-        switch (typePair(type, other.type)) {
-            case typePair(WordInt, WordInt):
-                assert(asWordInt() % other.asWordInt() == 0);
-                data = reinterpret_cast<void*>(asWordInt() / other.asWordInt());
-                return;
-            case typePair(GmpInt, WordInt):{
-                assert(asBigInt() % other.asWordInt() == 0);
-                asBigInt() /= other.asWordInt();
-                bigIntReduce();
+    NumType ceil() const{
+        return rounded<Ceil>();
+    }
+
+    NumType trunc() const{
+        return rounded<Trunc>();
+    }
+
+    //Rounds halves to the nearest even integer
+    NumType round() const{
+        return rounded<HalfEven>();
+    }
+
+    //An exact sum of products which is reduced once, when the result is taken.
+    //Word and wide terms accumulate as a reduced 128 bit fraction. Other terms, and the 128 bit
+    //fraction whenever the next term would overflow it, go to a GMP fraction kept over the lcm of
+    //the term denominators.
+    struct ProductSum{
+        WideWord num = 0;
+        WideWord den = 1;
+        bool big = false;
+        ScratchInt big_num, big_den, term_num, term_den, gcd, cofactor;
+        ScratchRat lhs_view, rhs_view;
+
+        void add(const NumType& a, const NumType& b){
+            const bool a_word = a.type == WordInt || a.type == WordRat;
+            const bool b_word = b.type == WordInt || b.type == WordRat;
+            if(a_word && b_word){
+                int64_t p = 0;
+                uint64_t q = 0;
+                rat64_t::product(a.wordOperand(), b.wordOperand(), p, q);
+                addWide(p, q);
                 return;
             }
-            case typePair(GmpInt, GmpInt):{
-                assert(asBigInt() % other.asBigInt() == 0);
-                asBigInt() /= other.asBigInt();
-                bigIntReduce();
+
+            const bool a_int = a.type == WordInt || a.type == WideInt;
+            const bool b_int = b.type == WordInt || b.type == WideInt;
+            WideWord product = 0;
+            if(a_int && b_int && !__builtin_mul_overflow(a.wideOperand(), b.wideOperand(), &product)){
+                addWide(product, 1);
                 return;
             }
-            default: assert(false);
+
+            mpz_srcptr a_num, a_den, b_num, b_den;
+            a.fractionView(lhs_view.q, a_num, a_den);
+            b.fractionView(rhs_view.q, b_num, b_den);
+            mpz_mul(term_num.z, a_num, b_num);
+            if(a_den && b_den){
+                mpz_mul(term_den.z, a_den, b_den);
+                addBig(term_num.z, term_den.z);
+            }else{
+                addBig(term_num.z, a_den ? a_den : b_den);
+            }
         }
-    }
 
-    NumType integerDivide(const NumType& other) const{
-        NumType ans(*this);
-        ans.inPlaceIntegerDivide(other);
-        return ans;
-    }
+        void add(const NumType& c){
+            switch (c.type) {
+                case WordInt:
+                case WordRat:{
+                    const rat64_t q = c.wordOperand();
+                    addWide(q.num, q.den);
+                    return;
+                }
+                case WideInt:
+                    addWide(c.asWide(), 1);
+                    return;
+                default:{
+                    mpz_srcptr c_num, c_den;
+                    c.fractionView(lhs_view.q, c_num, c_den);
+                    addBig(c_num, c_den);
+                }
+            }
+        }
 
-    void inPlaceIntegerDivide(int32_t other){
-        switch (type) {
-            case WordInt:
-                assert(asWordInt() % other == 0);
-                data = reinterpret_cast<void*>(asWordInt() / other);
-                return;
-            case GmpInt:{
-                assert(asBigInt() % other == 0);
-                asBigInt() /= other;
-                bigIntReduce();
+        void addWide(WideWord p, uint64_t q){
+            if(!rat64_t::accumulate(num, den, p, q)) return;
+            flush();
+            const bool overflow = rat64_t::accumulate(num, den, p, q);
+            assert(!overflow);
+            (void)overflow;
+        }
+
+        //Moves the 128 bit fraction onto the GMP fraction
+        void flush(){
+            setWide(term_num.z, num);
+            if(den == 1){
+                addBig(term_num.z, nullptr);
+            }else{
+                setWide(term_den.z, den);
+                addBig(term_num.z, term_den.z);
+            }
+            num = 0;
+            den = 1;
+        }
+
+        //big_num/big_den += n/d, where a null d is 1
+        void addBig(mpz_srcptr n, mpz_srcptr d){
+            if(!big){
+                mpz_set_ui(big_num.z, 0);
+                mpz_set_ui(big_den.z, 1);
+                big = true;
+            }
+            if(d == nullptr){
+                if(mpz_cmp_ui(big_den.z, 1) == 0) mpz_add(big_num.z, big_num.z, n);
+                else mpz_addmul(big_num.z, n, big_den.z);
                 return;
             }
-            default: assert(false);
+            mpz_gcd(gcd.z, big_den.z, d);
+            mpz_divexact(cofactor.z, big_den.z, gcd.z);
+            mpz_divexact(gcd.z, d, gcd.z);
+            mpz_mul(big_num.z, big_num.z, gcd.z);
+            mpz_addmul(big_num.z, n, cofactor.z);
+            mpz_mul(big_den.z, big_den.z, gcd.z);
+        }
+
+        NumType result(){
+            NumType ans;
+            if(!big){
+                ans.storeWideFraction(num, den);
+                return ans;
+            }
+            flush();
+            ScratchRat sum;
+            mpz_swap(mpq_numref(sum.q), big_num.z);
+            mpz_swap(mpq_denref(sum.q), big_den.z);
+            mpq_canonicalize(sum.q);
+            return fromScratch(sum.q);
         }
+    };
+
+    //a*b + c with a single reduction, promoting to GMP only when the result needs it
+    static NumType fma(const NumType& a, const NumType& b, const NumType& c){
+        const bool a_word = a.type == WordInt || a.type == WordRat;
+        const bool b_word = b.type == WordInt || b.type == WordRat;
+        const bool c_word = c.type == WordInt || c.type == WordRat;
+        if(a_word && b_word && c_word){
+            WideWord num = 0;
+            WideWord den = 0;
+            rat64_t::fma(a.wordOperand(), b.wordOperand(), c.wordOperand(), num, den);
+            NumType ans;
+            ans.storeWideFraction(num, den);
+            return ans;
+        }
+        ProductSum sum;
+        sum.add(c);
+        sum.add(a, b);
+        return sum.result();
     }
 
-    NumType integerDivide(int32_t other) const{
-        NumType ans(*this);
-        ans.inPlaceIntegerDivide(other);
-        return ans;
+    //The sum of a[i]*b[i] with a single reduction
+    static NumType dot(const NumType* a, const NumType* b, size_t n){
+        ProductSum sum;
+        for(size_t i = 0; i < n; i++) sum.add(a[i], b[i]);
+        return sum.result();
+    }
+
+    static NumType dot(const std::vector<NumType>& a, const std::vector<NumType>& b){
+        assert(a.size() == b.size());
+        return dot(a.data(), b.data(), a.size());
     }
 
     void inPlaceRemainderlessDivide(const NumType& other){
@@ -540,12 +3035,12 @@ struct NumType{
                 return;
             case typePair(GmpInt, WordInt):
                 assert(asBigInt() % other.asWordInt() == 0);
-                asBigInt() /= other.asWordInt();
+                mutableBigInt() /= other.asWordInt();
                 bigIntReduce();
                 return;
             case typePair(GmpInt, GmpInt):
                 assert(asBigInt() % other.asBigInt() == 0);
-                asBigInt() /= other.asBigInt();
+                mutableBigInt() /= other.asBigInt();
                 bigIntReduce();
                 return;
             case typePair(WordRat, WordInt):{
@@ -567,34 +3062,57 @@ struct NumType{
             }
             case typePair(GmpRat, WordInt):
                 assert(asBigRat().get_num() % other.asWordInt() == 0);
-                asBigRat().get_num() /= other.asWordInt();
+                mutableBigRat().get_num() /= other.asWordInt();
                 bigRatReduce<false>();
                 return;
             case typePair(GmpRat, WordRat):
                 assert(asBigRat().get_num() % other.asWordRat().num == 0);
                 assert(asBigRat().get_den() % other.asWordRat().den == 0);
-                asBigRat().get_num() /= other.asWordRat().num;
-                asBigRat().get_den() /= other.asWordRat().den;
+                mutableBigRat().get_num() /= other.asWordRat().num;
+                mutableBigRat().get_den() /= other.asWordRat().den;
                 bigRatReduce<false>();
                 return;
             case typePair(GmpRat, GmpInt):
                 assert(asBigRat().get_num() % other.asBigInt() == 0);
-                asBigRat().get_num() /= other.asBigInt();
+                mutableBigRat().get_num() /= other.asBigInt();
                 bigRatReduce<false>();
                 return;
             case typePair(GmpRat, GmpRat):
                 assert(asBigRat().get_num() % other.asBigRat().get_num() == 0);
                 assert(asBigRat().get_den() % other.asBigRat().get_den() == 0);
-                asBigRat().get_num() /= other.asBigRat().get_num();
-                asBigRat().get_den() /= other.asBigRat().get_den();
+                mutableBigRat().get_num() /= other.asBigRat().get_num();
+                mutableBigRat().get_den() /= other.asBigRat().get_den();
                 bigRatReduce<false>();
                 return;
+            case typePair(WordInt, WideInt):
+            case typePair(WideInt, WordInt):
+            case typePair(WideInt, WideInt):
+                assert(wideOperand() % other.wideOperand() == 0);
+                storeWide(wideOperand() / other.wideOperand());
+                return;
+            case typePair(WideInt, GmpInt):
+                widenToBig();
+                inPlaceRemainderlessDivide(other);
+                return;
+            case typePair(GmpInt, WideInt):
+            case typePair(GmpRat, WideInt):
+                inPlaceRemainderlessDivide(other.wideToBig());
+                return;
+            case typePair(Dyadic, WordInt):
+            case typePair(Dyadic, WordRat):
+            case typePair(Dyadic, Dyadic):
+            case typePair(Decimal, WordInt):
+            case typePair(Decimal, WordRat):
+            case typePair(Decimal, Decimal):
+                operator/=(other);
+                return;
             default: assert(false);
         }
     }
 
     template<bool reduce = true>
     void operator+=(const NumType& other){
+        NUMTYPE_OP_HOOK('+', other);
         switch(typePair(type, other.type)){
             case typePair(WordInt, WordInt):
                 data = reinterpret_cast<void*>(asWordInt() + other.asWordInt());
@@ -605,11 +3123,7 @@ struct NumType{
                 int32_t lhs = asWordInt();
                 rat64_t rhs = other.asWordRat();
                 if(rat64_t::add(lhs, rhs, ans)){
-                    mpq_class* result = new mpq_class(rhs.num, rhs.den);
-                    result->operator+=(lhs);
-                    data = result;
-                    type = GmpRat;
-                    if(reduce) bigRatReduce();
+                    setWordSum<reduce>(lhs, 1, rhs.num, rhs.den);
                 }else if(ans.den == 1){
                     data = reinterpret_cast<void*>(ans.num);
                 }else{
@@ -619,15 +3133,27 @@ struct NumType{
                 break;
             }
             case typePair(WordInt, GmpInt):{
-                data = new mpz_class(other.asBigInt()+(int32_t)asWordInt());
+                const int64_t lhs = asWordInt();
+                const mpz_class& rhs = other.asBigInt();
+                SharedBigInt* next = sizedBigInt(1 + std::max<mp_bitcnt_t>(32, bitLength(rhs)));
+                addSigned(next->val.get_mpz_t(), rhs.get_mpz_t(), lhs);
+                data = next;
                 type = GmpInt;
                 if(reduce) bigIntReduce();
                 break;
             }
             case typePair(WordInt, GmpRat):{
-                data = new mpq_class(other.asBigRat()+(int32_t)asWordInt());
+                const int64_t lhs = asWordInt();
+                const mpq_class& rhs = other.asBigRat();
+                const mp_bitcnt_t den_bits = bitLength(rhs.get_den());
+                SharedBigRat* next = sizedBigRat(1 + std::max(bitLength(rhs.get_num()), 32 + den_bits), den_bits);
+                mpz_ptr num = mpq_numref(next->val.get_mpq_t());
+                mpz_set(num, rhs.get_num_mpz_t());
+                addMulSigned(num, rhs.get_den_mpz_t(), lhs);
+                mpz_set(mpq_denref(next->val.get_mpq_t()), rhs.get_den_mpz_t());
+                data = next;
                 type = GmpRat;
-                if(reduce) bigRatReduce();
+                if(reduce) bigRatReduce<false>();
                 break;
             }
             case typePair(WordRat, WordInt):{
@@ -635,274 +3161,809 @@ struct NumType{
                 rat64_t lhs = asWordRat();
                 int32_t rhs = other.asWordInt();
                 if(rat64_t::add(lhs, rhs, ans)){
-                    mpq_class* result = new mpq_class(lhs.num, lhs.den);
-                    result->operator+=(rhs);
-                    data = result;
-                    type = GmpRat;
-                    if(reduce) bigRatReduce();
+                    setWordSum<reduce>(lhs.num, lhs.den, rhs, 1);
+                }else if(ans.den == 1){
+                    data = reinterpret_cast<void*>(ans.num);
+                    type = WordInt;
+                }else{
+                    data = ans;
+                }
+                break;
+            }
+            case typePair(WordRat, WordRat):{
+                rat64_t ans;
+                rat64_t lhs = asWordRat();
+                rat64_t rhs = other.asWordRat();
+                if(rat64_t::add(lhs, rhs, ans)){
+                    setWordSum<reduce>(lhs.num, lhs.den, rhs.num, rhs.den);
                 }else if(ans.den == 1){
                     data = reinterpret_cast<void*>(ans.num);
                     type = WordInt;
                 }else{
                     data = ans;
                 }
-                break;
+                break;
+            }
+            case typePair(WordRat, GmpInt):{
+                //a/b + z = (z*b + a)/b, which is canonical because a/b is
+                const rat64_t lhs = asWordRat();
+                const mpz_class& rhs = other.asBigInt();
+                SharedBigRat* next = sizedBigRat(33 + bitLength(rhs), 32);
+                mpz_ptr num = mpq_numref(next->val.get_mpq_t());
+                mpz_mul_ui(num, rhs.get_mpz_t(), lhs.den);
+                addSigned(num, num, lhs.num);
+                mpz_set_ui(mpq_denref(next->val.get_mpq_t()), lhs.den);
+                data = next;
+                type = GmpRat;
+                if(reduce) bigRatReduce<false>();
+                break;
+            }
+            case typePair(WordRat, GmpRat):{
+                const rat64_t lhs = asWordRat();
+                const mpq_class& rhs = other.asBigRat();
+                const mp_bitcnt_t den_bits = 32 + bitLength(rhs.get_den());
+                SharedBigRat* next = sizedBigRat(1 + std::max(32 + bitLength(rhs.get_num()), den_bits), den_bits);
+                mpz_ptr num = mpq_numref(next->val.get_mpq_t());
+                mpz_ptr den = mpq_denref(next->val.get_mpq_t());
+                mpz_mul_ui(num, rhs.get_num_mpz_t(), lhs.den);
+                addMulSigned(num, rhs.get_den_mpz_t(), lhs.num);
+                mpz_mul_ui(den, rhs.get_den_mpz_t(), lhs.den);
+                mpq_canonicalize(next->val.get_mpq_t());
+                data = next;
+                type = GmpRat;
+                if(reduce) bigRatReduce<false>();
+                break;
+            }
+            case typePair(GmpInt, WordInt):{
+                mpz_class& z = mutableBigInt();
+                growLimbs(z.get_mpz_t(), mpz_size(z.get_mpz_t()) + 1);
+                addSigned(z.get_mpz_t(), z.get_mpz_t(), other.asWordInt());
+                if(reduce) bigIntReduce();
+                break;
+            }
+            case typePair(GmpInt, WordRat):{
+                const rat64_t rhs = other.asWordRat();
+                mpq_class& q = promoteBigIntToBigRat();
+                mpz_mul_ui(q.get_num_mpz_t(), q.get_num_mpz_t(), rhs.den);
+                addSigned(q.get_num_mpz_t(), q.get_num_mpz_t(), rhs.num);
+                mpz_set_ui(q.get_den_mpz_t(), rhs.den);
+                if(reduce) bigRatReduce<false>();
+                break;
+            }
+            case typePair(GmpInt, GmpInt):{
+                const mp_size_t limbs = std::max(mpz_size(asBigInt().get_mpz_t()), mpz_size(other.asBigInt().get_mpz_t())) + 1;
+                mpz_class& z = mutableBigInt();
+                growLimbs(z.get_mpz_t(), limbs);
+                z += other.asBigInt();
+                if(reduce) bigIntReduce();
+                break;
+            }
+            case typePair(GmpInt, GmpRat):{
+                const mpq_class& rhs = other.asBigRat();
+                mpq_class& q = promoteBigIntToBigRat();
+                mpz_mul(q.get_num_mpz_t(), q.get_num_mpz_t(), rhs.get_den_mpz_t());
+                mpz_add(q.get_num_mpz_t(), q.get_num_mpz_t(), rhs.get_num_mpz_t());
+                mpz_set(q.get_den_mpz_t(), rhs.get_den_mpz_t());
+                if(reduce) bigRatReduce<false>();
+                break;
+            }
+            case typePair(GmpRat, WordInt):{
+                mpq_class& q = mutableBigRat();
+                addMulSigned(q.get_num_mpz_t(), q.get_den_mpz_t(), other.asWordInt());
+                if(reduce) bigRatReduce<false>();
+                break;
+            }
+            case typePair(GmpRat, WordRat):{
+                const rat64_t rhs = other.asWordRat();
+                mpq_class& q = mutableBigRat();
+                mpz_mul_ui(q.get_num_mpz_t(), q.get_num_mpz_t(), rhs.den);
+                addMulSigned(q.get_num_mpz_t(), q.get_den_mpz_t(), rhs.num);
+                mpz_mul_ui(q.get_den_mpz_t(), q.get_den_mpz_t(), rhs.den);
+                mpq_canonicalize(q.get_mpq_t());
+                if(reduce) bigRatReduce<false>();
+                break;
+            }
+            case typePair(GmpRat, GmpInt):{
+                mpq_class& q = mutableBigRat();
+                mpz_addmul(q.get_num_mpz_t(), q.get_den_mpz_t(), other.asBigInt().get_mpz_t());
+                if(reduce) bigRatReduce<false>();
+                break;
+            }
+            case typePair(GmpRat, GmpRat):
+                mutableBigRat() += other.asBigRat();
+                if(reduce) bigRatReduce<false>();
+                break;
+            case typePair(WordInt, WideInt):
+            case typePair(WideInt, WordInt):
+            case typePair(WideInt, WideInt):
+                setWideSum(wideOperand(), other.wideOperand());
+                break;
+            case typePair(WideInt, WordRat):
+            case typePair(WideInt, GmpInt):
+            case typePair(WideInt, GmpRat):
+            case typePair(WordRat, WideInt):
+            case typePair(GmpInt, WideInt):
+            case typePair(GmpRat, WideInt):
+                throughBig<reduce>(other, [](NumType& lhs, const NumType& rhs){ lhs.operator+=<reduce>(rhs); });
+                break;
+            case typePair(Dyadic, WordInt):
+            case typePair(Dyadic, WordRat):
+            case typePair(Dyadic, WideInt):
+            case typePair(Dyadic, Dyadic):
+            case typePair(WordInt, Dyadic):
+            case typePair(WordRat, Dyadic):
+            case typePair(WideInt, Dyadic):
+                if(setDyadicSum(other)) break;
+                [[fallthrough]];
+            case typePair(Dyadic, GmpInt):
+            case typePair(Dyadic, GmpRat):
+            case typePair(GmpInt, Dyadic):
+            case typePair(GmpRat, Dyadic):
+                if(setBigDyadic<false>(other)) break;
+                throughRat<reduce>(other, [](NumType& lhs, const NumType& rhs){ lhs.operator+=<reduce>(rhs); });
+                break;
+            case typePair(Decimal, WordInt):
+            case typePair(Decimal, WordRat):
+            case typePair(Decimal, WideInt):
+            case typePair(Decimal, Dyadic):
+            case typePair(Decimal, Decimal):
+            case typePair(WordInt, Decimal):
+            case typePair(WordRat, Decimal):
+            case typePair(WideInt, Decimal):
+            case typePair(Dyadic, Decimal):
+                if(setDecimalSum(other)) break;
+                [[fallthrough]];
+            case typePair(Decimal, GmpInt):
+            case typePair(Decimal, GmpRat):
+            case typePair(GmpInt, Decimal):
+            case typePair(GmpRat, Decimal):
+                throughRat<reduce>(other, [](NumType& lhs, const NumType& rhs){ lhs.operator+=<reduce>(rhs); });
+                break;
+            default: assert(false);
+        }
+    }
+
+    template<bool reduce = true>
+    NumType operator+(const NumType& other) const&{
+        NumType ans(*this);
+        ans.operator+=<reduce>(other);
+        return ans;
+    }
+
+    template<bool reduce = true>
+    NumType operator+(const NumType& other) &&{
+        operator+=<reduce>(other);
+        return std::move(*this);
+    }
+
+    friend NumType operator+(const NumType& lhs, NumType&& rhs){
+        if(!rhs.isGmp()) return lhs + static_cast<const NumType&>(rhs);
+        rhs += lhs;
+        return std::move(rhs);
+    }
+
+    friend NumType operator+(NumType&& lhs, NumType&& rhs){
+        if(rhs.isGmp() && !lhs.isGmp()) return static_cast<const NumType&>(lhs) + std::move(rhs);
+        lhs += rhs;
+        return std::move(lhs);
+    }
+
+    friend NumType operator+(int32_t lhs, const NumType& rhs){
+        return rhs + lhs;
+    }
+
+    friend NumType operator+(int32_t lhs, NumType&& rhs){
+        rhs += lhs;
+        return std::move(rhs);
+    }
+
+    friend NumType operator-(int32_t lhs, const NumType& rhs){
+        return -rhs + lhs;
+    }
+
+    friend NumType operator-(int32_t lhs, NumType&& rhs){
+        rhs.negate();
+        rhs += lhs;
+        return std::move(rhs);
+    }
+
+    template<bool reduce = true>
+    void operator-=(const NumType& other){
+        NUMTYPE_OP_HOOK('-', other);
+        operator+=<reduce>(other.operator-<reduce>());
+    }
+
+    template<bool reduce = true>
+    void operator-=(NumType&& other){
+        NUMTYPE_OP_HOOK('-', other);
+        other.negate();
+        operator+=<reduce>(other);
+    }
+
+    //Tier hints for hot loops whose operands are almost always known word tiers.
+    //When both operands have the hinted tiers and the word kernel does not overflow, the result is
+    //computed in straight-line code that inlines into the caller. Anything else, including a wrong
+    //hint, takes an out-of-line cold path through the general operator, so results are identical.
+    template<Type tier>
+    static constexpr bool isWordTier() noexcept{
+        return tier == WordInt || tier == WordRat;
+    }
+
+    static bool fitsWordInt(int64_t z) noexcept{
+        return z <= std::numeric_limits<int32_t>::max() && z > std::numeric_limits<int32_t>::min();
+    }
+
+    //A word result of a hinted kernel. Integral fractions are stored as WordInt.
+    void setWordResult(const rat64_t& r) noexcept{
+        assert(!isGmp());
+        if(r.den == 1){
+            data = reinterpret_cast<void*>(static_cast<int64_t>(r.num));
+            type = WordInt;
+        }else{
+            data = r;
+            type = WordRat;
+        }
+    }
+
+    template<bool reduce>
+    NUMTYPE_COLD void multiplyCold(const NumType& other){
+        operator*=<reduce>(other);
+    }
+
+    template<bool reduce>
+    NUMTYPE_COLD void addCold(const NumType& other){
+        operator+=<reduce>(other);
+    }
+
+    template<bool reduce>
+    NUMTYPE_COLD void subtractCold(const NumType& other){
+        operator-=<reduce>(other);
+    }
+
+    template<Type lhs_tier, Type rhs_tier = lhs_tier, bool reduce = true>
+    void multiplyHinted(const NumType& other){
+        static_assert(isWordTier<lhs_tier>() && isWordTier<rhs_tier>(), "Only word tiers can be hinted");
+        NUMTYPE_OP_HOOK('*', other);
+        if(NUMTYPE_LIKELY(type == lhs_tier && other.type == rhs_tier)){
+            if constexpr(lhs_tier == WordInt && rhs_tier == WordInt){
+                const int64_t ans = asWordInt() * other.asWordInt();
+                if(NUMTYPE_LIKELY(fitsWordInt(ans))){
+                    data = reinterpret_cast<void*>(ans);
+                    return;
+                }
+            }else{
+                rat64_t ans;
+                bool overflow;
+                if constexpr(lhs_tier == WordInt)
+                    overflow = rat64_t::multiply(other.asWordRat(), static_cast<int32_t>(asWordInt()), ans);
+                else if constexpr(rhs_tier == WordInt)
+                    overflow = rat64_t::multiply(asWordRat(), static_cast<int32_t>(other.asWordInt()), ans);
+                else
+                    overflow = rat64_t::multiply(asWordRat(), other.asWordRat(), ans);
+                if(NUMTYPE_LIKELY(!overflow)){
+                    setWordResult(ans);
+                    return;
+                }
+            }
+        }
+        multiplyCold<reduce>(other);
+    }
+
+    template<Type lhs_tier, Type rhs_tier = lhs_tier, bool reduce = true>
+    void addHinted(const NumType& other){
+        static_assert(isWordTier<lhs_tier>() && isWordTier<rhs_tier>(), "Only word tiers can be hinted");
+        NUMTYPE_OP_HOOK('+', other);
+        if(NUMTYPE_LIKELY(type == lhs_tier && other.type == rhs_tier)){
+            if constexpr(lhs_tier == WordInt && rhs_tier == WordInt){
+                const int64_t ans = asWordInt() + other.asWordInt();
+                if(NUMTYPE_LIKELY(fitsWordInt(ans))){
+                    data = reinterpret_cast<void*>(ans);
+                    return;
+                }
+            }else{
+                rat64_t ans;
+                bool overflow;
+                if constexpr(lhs_tier == WordInt)
+                    overflow = rat64_t::add(other.asWordRat(), static_cast<int32_t>(asWordInt()), ans);
+                else if constexpr(rhs_tier == WordInt)
+                    overflow = rat64_t::add(asWordRat(), static_cast<int32_t>(other.asWordInt()), ans);
+                else
+                    overflow = rat64_t::add(asWordRat(), other.asWordRat(), ans);
+                if(NUMTYPE_LIKELY(!overflow)){
+                    setWordResult(ans);
+                    return;
+                }
             }
-            case typePair(WordRat, WordRat):{
+        }
+        addCold<reduce>(other);
+    }
+
+    template<Type lhs_tier, Type rhs_tier = lhs_tier, bool reduce = true>
+    void subtractHinted(const NumType& other){
+        static_assert(isWordTier<lhs_tier>() && isWordTier<rhs_tier>(), "Only word tiers can be hinted");
+        NUMTYPE_OP_HOOK('-', other);
+        if(NUMTYPE_LIKELY(type == lhs_tier && other.type == rhs_tier)){
+            //Word values exclude INT32_MIN, so negating an operand cannot overflow
+            if constexpr(lhs_tier == WordInt && rhs_tier == WordInt){
+                const int64_t ans = asWordInt() - other.asWordInt();
+                if(NUMTYPE_LIKELY(fitsWordInt(ans))){
+                    data = reinterpret_cast<void*>(ans);
+                    return;
+                }
+            }else{
                 rat64_t ans;
-                rat64_t lhs = asWordRat();
-                rat64_t rhs = other.asWordRat();
-                if(rat64_t::add(lhs, rhs, ans)){
-                    mpq_class* result = new mpq_class(lhs.num, lhs.den);
-                    result->operator+=(mpq_class(rhs.num, rhs.den));
-                    data = result;
-                    type = GmpRat;
-                    if(reduce) bigRatReduce();
-                }else if(ans.den == 1){
-                    data = reinterpret_cast<void*>(ans.num);
-                    type = WordInt;
-                }else{
-                    data = ans;
+                bool overflow;
+                if constexpr(lhs_tier == WordInt)
+                    overflow = rat64_t::add(-other.asWordRat(), static_cast<int32_t>(asWordInt()), ans);
+                else if constexpr(rhs_tier == WordInt)
+                    overflow = rat64_t::add(asWordRat(), static_cast<int32_t>(-other.asWordInt()), ans);
+                else
+                    overflow = rat64_t::subtract(asWordRat(), other.asWordRat(), ans);
+                if(NUMTYPE_LIKELY(!overflow)){
+                    setWordResult(ans);
+                    return;
                 }
-                break;
             }
-            case typePair(WordRat, GmpInt):{
-                mpq_class* next = new mpq_class(asWordRat().num, asWordRat().den);
-                next->operator+=(other.asBigInt());
-                data = next;
-                type = GmpRat;
-                if(reduce) bigRatReduce();
+        }
+        subtractCold<reduce>(other);
+    }
+
+    template<bool reduce = true>
+    NumType operator-(const NumType& other) const&{
+        NumType ans(*this);
+        ans.operator-=<reduce>(other);
+        return ans;
+    }
+
+    template<bool reduce = true>
+    NumType operator-(const NumType& other) &&{
+        operator-=<reduce>(other);
+        return std::move(*this);
+    }
+
+    friend NumType operator-(const NumType& lhs, NumType&& rhs){
+        if(!rhs.isGmp()) return lhs - static_cast<const NumType&>(rhs);
+        rhs.negate();
+        rhs += lhs;
+        return std::move(rhs);
+    }
+
+    friend NumType operator-(NumType&& lhs, NumType&& rhs){
+        if(rhs.isGmp() && !lhs.isGmp()) return static_cast<const NumType&>(lhs) - std::move(rhs);
+        lhs -= std::move(rhs);
+        return std::move(lhs);
+    }
+
+    //Truncated remainder, this - trunc(this/other)*other, which has the sign of this
+    template<bool reduce = true>
+    void operator%=(const NumType& other){
+        NUMTYPE_OP_HOOK('%', other);
+        switch(typePair(type, other.type)){
+            case typePair(WordInt, WordInt):
+                data = reinterpret_cast<void*>(asWordInt() % other.asWordInt());
                 break;
-            }
-            case typePair(WordRat, GmpRat):{
-                mpq_class* next = new mpq_class(other.asBigRat());
-                next->operator+=(mpq_class(asWordRat().num, asWordRat().den));
-                data = next;
-                type = GmpRat;
-                if(reduce) bigRatReduce();
+            case typePair(WordInt, GmpInt):
+            case typePair(WordRat, GmpInt):
                 break;
-            }
             case typePair(GmpInt, WordInt):
-                asBigInt() += (int32_t)other.asWordInt();
-                if(reduce) bigIntReduce();
-                break;
-            case typePair(GmpInt, WordRat):{
-                mpq_class* next = new mpq_class(other.asWordRat().num, other.asWordRat().den);
-                next->operator+=(asBigInt());
-                delete reinterpret_cast<mpz_class*>(data);
-                data = next;
-                type = WordRat;
-                if(reduce) bigRatReduce();
+                mutableBigInt() %= (int32_t)other.asWordInt();
+                bigIntReduce();
                 break;
-            }
             case typePair(GmpInt, GmpInt):
-                asBigInt() += other.asBigInt();
-                if(reduce) bigIntReduce();
-                break;
-            case typePair(GmpInt, GmpRat):{
-                mpq_class* result = new mpq_class(asBigInt() + other.asBigRat());
-                delete reinterpret_cast<mpz_class*>(data);
-                data = result;
-                type = GmpRat;
-                if(reduce) bigRatReduce();
+                mutableBigInt() %= other.asBigInt();
+                bigIntReduce();
                 break;
-            }
+            case typePair(WordInt, WordRat):
+            case typePair(WordInt, GmpRat):
+            case typePair(WordRat, WordInt):
+            case typePair(WordRat, WordRat):
+            case typePair(WordRat, GmpRat):
+            case typePair(GmpInt, WordRat):
+            case typePair(GmpInt, GmpRat):
             case typePair(GmpRat, WordInt):
-                asBigRat() += (int32_t)other.asWordInt();
-                if(reduce) bigRatReduce();
-                break;
             case typePair(GmpRat, WordRat):
-                asBigRat() += mpq_class(other.asWordRat().num, other.asWordRat().den);
-                if(reduce) bigRatReduce();
-                break;
             case typePair(GmpRat, GmpInt):
-                asBigRat() += other.asBigInt();
-                if(reduce) bigRatReduce();
-                break;
             case typePair(GmpRat, GmpRat):
-                asBigRat() += other.asBigRat();
-                if(reduce) bigRatReduce();
+                roundedDivide<Trunc>(other, nullptr, this);
+                break;
+            case typePair(WordInt, WideInt):
+            case typePair(WideInt, WordInt):
+            case typePair(WideInt, WideInt):
+                storeWide(wideOperand() % other.wideOperand());
+                break;
+            case typePair(WideInt, WordRat):
+            case typePair(WideInt, GmpInt):
+            case typePair(WideInt, GmpRat):
+            case typePair(WordRat, WideInt):
+            case typePair(GmpInt, WideInt):
+            case typePair(GmpRat, WideInt):
+                throughBig<reduce>(other, [](NumType& lhs, const NumType& rhs){ lhs.operator%=<reduce>(rhs); });
+                break;
+            case typePair(Dyadic, WordInt):
+            case typePair(Dyadic, WordRat):
+            case typePair(Dyadic, GmpInt):
+            case typePair(Dyadic, GmpRat):
+            case typePair(Dyadic, WideInt):
+            case typePair(Dyadic, Dyadic):
+            case typePair(WordInt, Dyadic):
+            case typePair(WordRat, Dyadic):
+            case typePair(GmpInt, Dyadic):
+            case typePair(GmpRat, Dyadic):
+            case typePair(WideInt, Dyadic):
+            case typePair(Decimal, WordInt):
+            case typePair(Decimal, WordRat):
+            case typePair(Decimal, GmpInt):
+            case typePair(Decimal, GmpRat):
+            case typePair(Decimal, WideInt):
+            case typePair(Decimal, Dyadic):
+            case typePair(Decimal, Decimal):
+            case typePair(WordInt, Decimal):
+            case typePair(WordRat, Decimal):
+            case typePair(GmpInt, Decimal):
+            case typePair(GmpRat, Decimal):
+            case typePair(WideInt, Decimal):
+            case typePair(Dyadic, Decimal):
+                throughRat<reduce>(other, [](NumType& lhs, const NumType& rhs){ lhs.operator%=<reduce>(rhs); });
                 break;
             default: assert(false);
         }
     }
 
     template<bool reduce = true>
-    NumType operator+(const NumType& other) const{
+    NumType operator%(const NumType& other) const&{
         NumType ans(*this);
-        ans.operator+=<reduce>(other);
+        ans.operator%=<reduce>(other);
         return ans;
     }
 
-    friend NumType operator+(int32_t lhs, const NumType& rhs){
-        return rhs + lhs;
+    template<bool reduce = true>
+    NumType operator%(const NumType& other) &&{
+        operator%=<reduce>(other);
+        return std::move(*this);
     }
 
-    friend NumType operator-(int32_t lhs, const NumType& rhs){
-        return -rhs + lhs;
+    friend NumType operator%(const NumType& lhs, NumType&& rhs){
+        //The remainder is only computed in the divisor's buffer for integers,
+        //since a rational remainder needs the dividend's denominator
+        if(lhs.type != GmpInt || rhs.type != GmpInt) return lhs % static_cast<const NumType&>(rhs);
+        mpz_class& z = rhs.mutableBigInt();
+        mpz_tdiv_r(z.get_mpz_t(), lhs.asBigInt().get_mpz_t(), z.get_mpz_t());
+        rhs.bigIntReduce();
+        return std::move(rhs);
     }
 
-    template<bool reduce = true>
-    void operator-=(const NumType& other){
-        operator+=<reduce>(other.operator-<reduce>());
+    friend NumType operator%(NumType&& lhs, NumType&& rhs){
+        if(rhs.type == GmpInt && lhs.type == GmpInt && !lhs.bigIntPayload()->unique())
+            return static_cast<const NumType&>(lhs) % std::move(rhs);
+        lhs %= rhs;
+        return std::move(lhs);
     }
 
-    template<bool reduce = true>
-    NumType operator-(const NumType& other) const{
-        NumType ans(*this);
-        ans.operator-=<reduce>(other);
-        return ans;
+    static unsigned long primitiveMagnitude(WideWord z) noexcept{
+        return static_cast<unsigned long>(z < 0 ? -z : z);
+    }
+
+    //Operands in the WordInt range take the same 64 bit kernels as a WordInt operand
+    static bool isWordOperand(WideWord z) noexcept{
+        return z <= std::numeric_limits<int32_t>::max() && z > std::numeric_limits<int32_t>::min();
     }
 
+    //Arithmetic with an int64_t or uint64_t operand dispatches on the tier of this value alone.
+    //Word and wide results are formed in 128 bits, GMP payloads are updated with the _ui calls,
+    //and the packed tiers reuse their kernels through a WideInt operand.
     template<bool reduce = true>
-    void operator%=(const NumType& other){
-        switch(typePair(type, other.type)){
-            case typePair(WordInt, WordInt):
-                data = reinterpret_cast<void*>(asWordInt() % other.asWordInt());
+    void addInteger(WideWord z){
+        NUMTYPE_OP_HOOK('+', z);
+        switch (type) {
+            case WordInt:
+                if(isWordOperand(z)){
+                    data = reinterpret_cast<void*>(asWordInt() + static_cast<int64_t>(z));
+                    wordIntClamp();
+                }else{
+                    storeWide(asWordInt() + z);
+                }
                 break;
-            case typePair(WordInt, WordRat):{
-                rat64_t ans = other.asWordRat();
-                ans.num = (asWordInt()*ans.num) % ans.den;
-                data = ans;
-                type = WordRat;
-                wordRatReduce();
+            case WordRat:{
+                const rat64_t q = asWordRat();
+                rat64_t ans;
+                if(!isWordOperand(z)) storeWideFraction(q.num + z * q.den, q.den);
+                else if(rat64_t::add(q, static_cast<int32_t>(z), ans)) setWordSum<reduce>(q.num, q.den, static_cast<int64_t>(z), 1);
+                else setWordResult(ans);
                 break;
             }
-            case typePair(WordInt, GmpInt):
-                break;
-            case typePair(WordInt, GmpRat):{
-                mpq_class* ans = new mpq_class(other.asBigRat());
-                ans->get_num() = (asWordInt()*ans->get_num()) % ans->get_den();
-                data = ans;
-                type = GmpRat;
-                bigRatReduce();
+            case WideInt:{
+                WideWord sum;
+                if(!__builtin_add_overflow(asWide(), z, &sum)){
+                    storeWide(sum);
+                    break;
+                }
+                widenToBig();
+            }
+            [[fallthrough]];
+            case GmpInt:{
+                mpz_ptr a = mutableBigInt().get_mpz_t();
+                growLimbs(a, mpz_size(a) + 1);
+                if(z < 0) mpz_sub_ui(a, a, primitiveMagnitude(z));
+                else mpz_add_ui(a, a, primitiveMagnitude(z));
+                if(reduce) bigIntReduce();
                 break;
             }
-            case typePair(WordRat, WordInt):{
-                data = asWordRat() % other.asWordInt();
+            case GmpRat:{
+                mpq_class& q = mutableBigRat();
+                if(z < 0) mpz_submul_ui(q.get_num_mpz_t(), q.get_den_mpz_t(), primitiveMagnitude(z));
+                else mpz_addmul_ui(q.get_num_mpz_t(), q.get_den_mpz_t(), primitiveMagnitude(z));
+                if(reduce) bigRatReduce<false>();
                 break;
             }
-            case typePair(WordRat, WordRat):{
-                rat64_t lhs = asWordRat();
-                rat64_t rhs = other.asWordRat();
-                int64_t den = lhs.den*rhs.den;
-                int64_t num = lhs.num*rhs.den % (lhs.den*rhs.num);
-                auto gcd = std::gcd(std::abs(num),den);
-                num /= gcd;
-                den /= gcd;
-
-                assert(num <= std::numeric_limits<int32_t>::max() &&
-                       num > std::numeric_limits<int32_t>::min()); //num can't increase
+            case Dyadic:
+            case Decimal:
+                operator+=<reduce>(fromWide(z));
+                break;
+        }
+    }
 
-                if(den == 1){
-                    data = reinterpret_cast<void*>(num);
-                    type = WordInt;
-                }else if(den <= std::numeric_limits<uint32_t>::max() &&
-                         num <= std::numeric_limits<int32_t>::max() &&
-                         num > std::numeric_limits<int32_t>::min()){
-                    data = rat64_t(num,den);
+    template<bool reduce = true>
+    void multiplyInteger(WideWord z){
+        NUMTYPE_OP_HOOK('*', z);
+        if(z == 0){
+            setZero();
+            return;
+        }
+        switch (type) {
+            case WordInt:
+                if(isWordOperand(z)){
+                    data = reinterpret_cast<void*>(asWordInt() * static_cast<int64_t>(z));
+                    wordIntClamp();
                 }else{
-                    data = new mpq_class(num, toBigInt(den));
-                    type = GmpRat;
+                    storeWide(asWordInt() * z);
+                }
+                break;
+            case WordRat:{
+                const rat64_t q = asWordRat();
+                rat64_t ans;
+                if(isWordOperand(z)){
+                    if(rat64_t::multiply(q, static_cast<int32_t>(z), ans)) setWordProduct<reduce>(q.num, q.den, static_cast<int64_t>(z), 1);
+                    else setWordResult(ans);
+                    break;
                 }
+                const uint64_t gcd = std::gcd<uint64_t>(q.den, primitiveMagnitude(z));
+                storeWideFraction(q.num * (z / static_cast<WideWord>(gcd)), q.den / gcd);
                 break;
             }
-            case typePair(WordRat, GmpInt):
+            case WideInt:{
+                WideWord product;
+                if(!__builtin_mul_overflow(asWide(), z, &product)){
+                    storeWide(product);
+                    break;
+                }
+                widenToBig();
+            }
+            [[fallthrough]];
+            case GmpInt:{
+                mpz_ptr a = mutableBigInt().get_mpz_t();
+                growLimbs(a, mpz_size(a) + 1);
+                mpz_mul_ui(a, a, primitiveMagnitude(z));
+                if(z < 0) mpz_neg(a, a);
                 break;
-            case typePair(WordRat, GmpRat):{
-                rat64_t lhs = asWordRat();
-                mpq_class& rhs = other.asBigRat();
-                mpq_class* ans = new mpq_class(lhs.num*rhs.get_den() % (lhs.den * rhs.get_num()),
-                                               rhs.get_den()*lhs.den);
-                data = ans;
-                type = GmpRat;
-                bigRatReduce();
+            }
+            case GmpRat:{
+                const unsigned long magnitude = primitiveMagnitude(z);
+                const unsigned long gcd = mpz_gcd_ui(nullptr, asBigRat().get_den_mpz_t(), magnitude);
+                mpq_class& q = mutableBigRat();
+                mpz_divexact_ui(q.get_den_mpz_t(), q.get_den_mpz_t(), gcd);
+                mpz_mul_ui(q.get_num_mpz_t(), q.get_num_mpz_t(), magnitude/gcd);
+                if(z < 0) mpz_neg(q.get_num_mpz_t(), q.get_num_mpz_t());
+                if(reduce) bigRatReduce<false>();
                 break;
             }
-            case typePair(GmpInt, WordInt):
-                asBigInt() %= (int32_t)other.asWordInt();
-                bigIntReduce();
+            case Dyadic:
+            case Decimal:
+                operator*=<reduce>(fromWide(z));
                 break;
-            case typePair(GmpInt, WordRat):{
-                mpz_class lhs = asBigInt();
-                rat64_t rhs = other.asWordRat();
-                mpq_class* ans = new mpq_class(lhs*rhs.den % rhs.num, rhs.den);
-                data = ans;
-                type = GmpRat;
-                bigRatReduce();
+        }
+    }
+
+    template<bool reduce = true>
+    void divideInteger(WideWord z){
+        NUMTYPE_OP_HOOK('/', z);
+        assert(z != 0);
+        switch (type) {
+            case WordInt:
+                if(isWordOperand(z)){
+                    int64_t a = asWordInt();
+                    int64_t b = static_cast<int64_t>(z);
+                    if(b < 0){
+                        a = -a;
+                        b = -b;
+                    }
+                    //As in operator/=, the reduced quotient is stored field by field so the gcd is taken once
+                    const int64_t gcd = std::gcd(a, b);
+                    rat64_t ans;
+                    ans.num = static_cast<int32_t>(a/gcd);
+                    ans.den = static_cast<uint32_t>(b/gcd);
+                    setWordResult(ans);
+                    break;
+                }
+                [[fallthrough]];
+            case WideInt:
+                setWideQuotient(wideOperand(), z);
                 break;
-            }
-            case typePair(GmpInt, GmpInt):
-                asBigInt() %= other.asBigInt();
-                bigIntReduce();
+            case WordRat:{
+                const rat64_t q = asWordRat();
+                if(isWordOperand(z)){
+                    setWordQuotient<reduce>(q, rat64_t(static_cast<int32_t>(z)));
+                    break;
+                }
+                const uint64_t magnitude = primitiveMagnitude(z);
+                const uint64_t gcd = std::gcd<uint64_t>(rat64_t::safeAbs(q.num), magnitude);
+                const WideWord num = q.num / static_cast<int64_t>(gcd);
+                storeWideFraction(z < 0 ? -num : num, static_cast<WideWord>(q.den) * (magnitude / gcd));
                 break;
-            case typePair(GmpInt, GmpRat):{
-                mpz_class lhs = asBigInt();
-                mpq_class& rhs = other.asBigRat();
-                mpq_class* ans = new mpq_class(lhs*rhs.get_den() % rhs.get_num(), rhs.get_den());
-                data = ans;
-                type = GmpRat;
-                bigRatReduce();
+            }
+            case GmpInt:{
+                const unsigned long magnitude = primitiveMagnitude(z);
+                const unsigned long gcd = mpz_gcd_ui(nullptr, asBigInt().get_mpz_t(), magnitude);
+                mpz_ptr a = mutableBigInt().get_mpz_t();
+                mpz_divexact_ui(a, a, gcd);
+                if(z < 0) mpz_neg(a, a);
+                if(magnitude == gcd){
+                    if(reduce) bigIntReduce();
+                }else{
+                    mpq_class& q = promoteBigIntToBigRat();
+                    mpz_set_ui(q.get_den_mpz_t(), magnitude/gcd);
+                    if(reduce) bigRatReduce<false>();
+                }
                 break;
             }
-            case typePair(GmpRat, WordInt):{
-                mpq_class& r = asBigRat();
-                r.get_num() %= (r.get_den() * other.asWordInt());
-                bigRatReduce();
+            case GmpRat:{
+                const unsigned long magnitude = primitiveMagnitude(z);
+                const unsigned long gcd = mpz_gcd_ui(nullptr, asBigRat().get_num_mpz_t(), magnitude);
+                mpq_class& q = mutableBigRat();
+                mpz_divexact_ui(q.get_num_mpz_t(), q.get_num_mpz_t(), gcd);
+                mpz_mul_ui(q.get_den_mpz_t(), q.get_den_mpz_t(), magnitude/gcd);
+                if(z < 0) mpz_neg(q.get_num_mpz_t(), q.get_num_mpz_t());
+                if(reduce) bigRatReduce<false>();
                 break;
             }
-            case typePair(GmpRat, WordRat):{
-                mpq_class& lhs = asBigRat();
-                rat64_t rhs = other.asWordRat();
-                lhs.get_den() *= rhs.den;
-                lhs.get_num() = lhs.get_num()*rhs.den % (lhs.get_den()*rhs.num);
-                bigRatReduce();
+            case Dyadic:
+            case Decimal:
+                operator/=<reduce>(fromWide(z));
+                break;
+        }
+    }
+
+    //Truncated remainder. For a fraction n/d the remainder is (n mod d*|z|)/d, which stays reduced.
+    template<bool reduce = true>
+    void remainderInteger(WideWord z){
+        NUMTYPE_OP_HOOK('%', z);
+        assert(z != 0);
+        switch (type) {
+            case WordInt:
+                //A divisor past 2^63 leaves any WordInt unchanged
+                if(z <= std::numeric_limits<int64_t>::max())
+                    data = reinterpret_cast<void*>(asWordInt() % static_cast<int64_t>(z));
+                break;
+            case WideInt:
+                storeWide(asWide() % z);
+                break;
+            case WordRat:{
+                const rat64_t q = asWordRat();
+                storeWideFraction(q.num % (static_cast<WideWord>(q.den) * primitiveMagnitude(z)), q.den);
                 break;
             }
-            case typePair(GmpRat, GmpInt):{
-                mpq_class& r = asBigRat();
-                r.get_num() %= (r.get_den() * other.asBigInt());
-                bigRatReduce();
+            case GmpInt:{
+                mpz_srcptr a = asBigInt().get_mpz_t();
+                const WideWord magnitude = mpz_tdiv_ui(a, primitiveMagnitude(z));
+                const WideWord remainder = mpz_sgn(a) < 0 ? -magnitude : magnitude;
+                bigIntPayload()->release();
+                type = WordInt;
+                storeWide(remainder);
                 break;
             }
-            case typePair(GmpRat, GmpRat):{
-                mpq_class& lhs = asBigRat();
-                mpq_class& rhs = other.asBigRat();
-                lhs.get_den() *= rhs.get_den();
-                lhs.get_num() = lhs.get_num()*rhs.get_den() % (lhs.get_den()*rhs.get_num());
-                bigRatReduce();
+            case GmpRat:{
+                ScratchInt period;
+                mpz_mul_ui(period, asBigRat().get_den_mpz_t(), primitiveMagnitude(z));
+                mpz_ptr num = mutableBigRat().get_num_mpz_t();
+                mpz_tdiv_r(num, num, period);
+                if(reduce) bigRatReduce<false>();
                 break;
             }
-            default: assert(false);
+            case Dyadic:
+            case Decimal:
+                operator%=<reduce>(fromWide(z));
+                break;
         }
     }
 
+    template<bool reduce = true, typename T, IfPrimitive<T> = 0>
+    void operator+=(T other){
+        addInteger<reduce>(other);
+    }
+
+    template<bool reduce = true, typename T, IfPrimitive<T> = 0>
+    void operator-=(T other){
+        addInteger<reduce>(-static_cast<WideWord>(other));
+    }
+
+    template<bool reduce = true, typename T, IfPrimitive<T> = 0>
+    void operator*=(T other){
+        multiplyInteger<reduce>(other);
+    }
+
+    template<bool reduce = true, typename T, IfPrimitive<T> = 0>
+    void operator/=(T other){
+        divideInteger<reduce>(other);
+    }
+
+    template<bool reduce = true, typename T, IfPrimitive<T> = 0>
+    void operator%=(T other){
+        remainderInteger<reduce>(other);
+    }
+
+    //A word fraction operand is already a NumType without any allocation, so only integers take the kernels above
     template<bool reduce = true>
-    NumType operator%(const NumType& other) const{
-        NumType ans(*this);
-        ans.operator%=<reduce>(other);
-        return ans;
+    void operator+=(const rat64_t& other){
+        if(other.den == 1) addInteger<reduce>(other.num);
+        else operator+=<reduce>(NumType(other));
+    }
+
+    template<bool reduce = true>
+    void operator-=(const rat64_t& other){
+        if(other.den == 1) addInteger<reduce>(-static_cast<WideWord>(other.num));
+        else operator-=<reduce>(NumType(other));
+    }
+
+    template<bool reduce = true>
+    void operator*=(const rat64_t& other){
+        if(other.den == 1) multiplyInteger<reduce>(other.num);
+        else operator*=<reduce>(NumType(other));
+    }
+
+    template<bool reduce = true>
+    void operator/=(const rat64_t& other){
+        if(other.den == 1) divideInteger<reduce>(other.num);
+        else operator/=<reduce>(NumType(other));
     }
 
+    template<bool reduce = true>
+    void operator%=(const rat64_t& other){
+        if(other.den == 1) remainderInteger<reduce>(other.num);
+        else operator%=<reduce>(NumType(other));
+    }
+
+    //Big factorials go to mpz_fac_ui, which already uses the prime-swing algorithm
     static NumType factorial(int32_t z){
-        if(z > 12){
-            mpz_class ans = mpz_class::factorial(z);
-            return NumType(ans);
-        }else{
-            int32_t fact = 1;
-            while(z > 1) fact *= z--;
-            return fact;
+        assert(z >= 0);
+        if(z < int32_t(WordCombinatorics::num_factorials))
+            return WordCombinatorics::tables.factorial[z];
+        if(z <= 33){ //34! needs 128 bits
+            WideWord fact = WordCombinatorics::tables.factorial[WordCombinatorics::num_factorials-1];
+            for(int32_t i = WordCombinatorics::num_factorials; i <= z; i++) fact *= i;
+            return fromWide(fact);
         }
+
+        //log2(z!) < z*log2(z)
+        NumType ans;
+        SharedBigInt* payload = newBigInt(mp_bitcnt_t(z) * rat64_t::bitLength(z));
+        mpz_fac_ui(payload->val.get_mpz_t(), z);
+        ans.data = payload;
+        ans.type = GmpInt;
+        return ans;
     }
 
     NumType factorial() const{
         assert(type != WordRat);
         assert(type != GmpRat);
+        assert(type != Dyadic);
+        assert(type != Decimal);
         assert((type != WordInt || asWordInt() >= 0));
-        assert(asBigInt() >= 0);
+        assert((type != GmpInt || asBigInt() >= 0));
+        assert((type != WideInt || asWide() >= 0));
 
         if(type == WordInt){
             return factorial(asWordInt());
+        }else if(type == WideInt){
+            return wideToBig().factorial();
         }else{
             mpz_class ans = mpz_class::factorial(asBigInt());
             return NumType(ans);
@@ -911,26 +3972,83 @@ struct NumType{
 
     static NumType binomialCoeff(uint32_t n, uint32_t k){
         assert(n >= k);
-        if(n > 33 && k > 1){ //Overflow is not possible for n <= 33. Could line-fit a better bound.
-            mpz_t rop;
-            mpz_init(rop);
-            mpz_bin_uiui(rop, n, k);
-            if(mpz_fits_sint_p(rop)) return mpz_get_si(rop);
-            else return mpz_class(rop);
-        }else{
-            uint64_t c = n;
-            for(uint64_t i = 2; i <= k; i++){
+        k = std::min(k, n-k);
+        if(n < WordCombinatorics::pascal_rows){
+            return WordCombinatorics::tables.pascal[WordCombinatorics::rowStart(n) + k];
+        }else if(k < WordCombinatorics::num_bounds && n <= WordCombinatorics::tables.max_n[k]){
+            //Each partial product is C(n,i)*i, which stays well inside 64 bits
+            uint64_t c = 1;
+            for(uint64_t i = 1; i <= k; i++){
                 c *= n+1-i;
                 c /= i;
             }
+            return int32_t(c);
+        }else{
+            return bigBinomialCoeff(n, k);
+        }
+    }
+
+    //C(n,k) is known not to fit a word here, and k <= n/2
+    static NumType computeBigBinomial(uint32_t n, uint32_t k){
+        NumType ans;
+        SharedBigInt* payload = newBigInt(1 + std::min<mp_bitcnt_t>(n, k * rat64_t::bitLength(n)));
+        mpz_bin_uiui(payload->val.get_mpz_t(), n, k);
+        ans.data = payload;
+        ans.type = GmpInt;
+        ans.bigIntReduce();
+        return ans;
+    }
+
+    //Big coefficients are memoized in a small direct-mapped cache per thread. Returning a hit only
+    //bumps a reference count. Neighbours along a Pascal row land in adjacent slots, so walking a row
+    //derives each entry from the last with one multiply and one exact divide.
+    //Define NUMTYPE_BINOMIAL_CACHE_SIZE as 0 to disable the cache.
+    static NumType bigBinomialCoeff(uint32_t n, uint32_t k){
+#if NUMTYPE_BINOMIAL_CACHE_SIZE > 0
+        struct Entry{
+            uint32_t n = 0; //Row 0 is never big, so n == 0 marks an empty slot
+            uint32_t k = 0;
+            NumType value;
+        };
+        thread_local Entry cache[NUMTYPE_BINOMIAL_CACHE_SIZE];
+        auto slot = [](uint32_t n, uint32_t k){ return (uint64_t(n) * 0x9E3779B1u + k) % NUMTYPE_BINOMIAL_CACHE_SIZE; };
+
+        Entry& entry = cache[slot(n, k)];
+        if(entry.n == n && entry.k == k) return entry.value;
 
-            return c;
+        const Entry& left = cache[slot(n, k-1)];
+        NumType ans;
+        if(left.n == n && left.k == k-1 && left.value.type == GmpInt){
+            //C(n,k) = C(n,k-1) * (n-k+1) / k
+            const mpz_class& prev = left.value.asBigInt();
+            SharedBigInt* payload = newBigInt(bitLength(prev) + rat64_t::bitLength(n-k+1));
+            mpz_mul_ui(payload->val.get_mpz_t(), prev.get_mpz_t(), n-k+1);
+            mpz_divexact_ui(payload->val.get_mpz_t(), payload->val.get_mpz_t(), k);
+            ans.data = payload;
+            ans.type = GmpInt;
+            ans.bigIntReduce();
+        }else{
+            ans = computeBigBinomial(n, k);
         }
+
+        entry.n = n;
+        entry.k = k;
+        entry.value = ans;
+        return ans;
+#else
+        return computeBigBinomial(n, k);
+#endif
     }
 };
 
 namespace std {
-    NumType abs(const NumType& val){
+    template<> struct hash<NumType>{
+        size_t operator()(const NumType& val) const{
+            return static_cast<size_t>(val.hash());
+        }
+    };
+
+    inline NumType abs(const NumType& val){
         switch (val.type) {
             case WordInt: return NumType(std::abs(val.asWordInt()));
             case WordRat: return NumType(std::abs(val.asWordRat()));
@@ -939,57 +4057,121 @@ namespace std {
                 return NumType(ab);
             }
             case GmpRat: return NumType(abs(val.asBigRat()));
+            case WideInt: return NumType::fromWide(val.asWide() < 0 ? -val.asWide() : val.asWide());
+            case Dyadic: return NumType::dyadic(std::abs(val.dyadicMantissa()), val.dyadicExponent());
+            case Decimal: return NumType::decimal(std::abs(val.decimalMantissa()), val.decimalScale());
         }
 
         assert(false);
     }
 
-    NumType pow(const NumType& num, const uint32_t& power){
+    inline NumType floor(const NumType& val){
+        return val.floor();
+    }
+
+    inline NumType ceil(const NumType& val){
+        return val.ceil();
+    }
+
+    inline NumType trunc(const NumType& val){
+        return val.trunc();
+    }
+
+    inline NumType round(const NumType& val){
+        return val.round();
+    }
+
+    inline NumType pow(const NumType& num, const uint32_t& power){
         assert(num != 0);
         if(power == 0) return 1;
         switch (num.type) {
             case GmpInt:{
-                mpz_t rop;
-                mpz_init(rop);
-                mpz_pow_ui(rop, num.asBigInt().get_mpz_t(), power);
-                return mpz_class(rop);
+                //Powers of a big integer are big, so compute straight into the result
+                const mpz_class& z = num.asBigInt();
+                NumType ans;
+                SharedBigInt* payload = NumType::newBigInt(power * NumType::bitLength(z));
+                mpz_pow_ui(payload->val.get_mpz_t(), z.get_mpz_t(), power);
+                ans.data = payload;
+                ans.type = GmpInt;
+                return ans;
             }
             case GmpRat:{
-                mpz_t rop_num;
-                mpz_init(rop_num);
-                mpz_pow_ui(rop_num, num.asBigRat().get_num_mpz_t(), power);
-                mpz_t rop_den;
-                mpz_init(rop_den);
-                mpz_pow_ui(rop_den, num.asBigRat().get_den_mpz_t(), power);
-                return mpq_class(mpz_class(rop_num), mpz_class(rop_den));
+                const mpq_class& q = num.asBigRat();
+                NumType ans;
+                SharedBigRat* payload = NumType::newBigRat(power * NumType::bitLength(q.get_num()),
+                                                           power * NumType::bitLength(q.get_den()));
+                mpz_pow_ui(payload->val.get_num_mpz_t(), q.get_num_mpz_t(), power);
+                mpz_pow_ui(payload->val.get_den_mpz_t(), q.get_den_mpz_t(), power);
+                ans.data = payload;
+                ans.type = GmpRat;
+                ans.bigRatReduce<false>();
+                return ans;
             }
             case WordInt:{
-                int32_t z = num.asWordInt();
-                if(power * std::log(z) < std::log(std::numeric_limits<int32_t>::max())){
-                    return std::pow(z, power);
-                }else{
-                    mpz_t rop;
-                    mpz_init(rop);
-                    mpz_ui_pow_ui(rop, std::abs(z), power);
-                    if(power%2 && z < 0) mpz_neg(rop, rop);
-                    return mpz_class(rop);
-                }
+                const int32_t z = num.asWordInt();
+                const rat64_t::UnsignedHalfWord magnitude = rat64_t::safeAbs(z);
+                const bool negative = z < 0 && power%2;
+                rat64_t::UnsignedWord word_ans;
+                if(!rat64_t::powWithOverflowCheck(magnitude, power, std::numeric_limits<int32_t>::max(), word_ans))
+                    return NumType(static_cast<int32_t>(negative ? -static_cast<int64_t>(word_ans) : word_ans));
+
+                WideWord wide_ans;
+                if(NumType::widePow(z, power, wide_ans)) return NumType::fromWide(wide_ans);
+
+                //The result can't fit two limbs, so go straight to GMP
+                NumType ans;
+                SharedBigInt* payload = NumType::newBigInt(power * rat64_t::bitLength(magnitude));
+                mpz_ui_pow_ui(payload->val.get_mpz_t(), magnitude, power);
+                if(negative) mpz_neg(payload->val.get_mpz_t(), payload->val.get_mpz_t());
+                ans.data = payload;
+                ans.type = GmpInt;
+                return ans;
             }
             case WordRat:{
                 rat64_t q = num.asWordRat();
-                rat64_t ans;
-                if(rat64_t::power(q, power, ans)){
-                    mpz_t rop_num;
-                    mpz_init(rop_num);
-                    mpz_ui_pow_ui(rop_num, std::abs(q.num), power);
-                    if(power%2 && q.num < 0) mpz_neg(rop_num, rop_num);
-                    mpz_t rop_den;
-                    mpz_init(rop_den);
-                    mpz_ui_pow_ui(rop_den, q.den, power);
-                    return mpq_class(mpz_class(rop_num), mpz_class(rop_den));
-                }else{
+                rat64_t word_ans;
+                if(!rat64_t::power(q, power, word_ans)){
+                    NumType ans(word_ans);
+                    ans.wordRatReduce();
+                    return ans;
+                }
+
+                const rat64_t::UnsignedHalfWord magnitude = rat64_t::safeAbs(q.num);
+                NumType ans;
+                SharedBigRat* payload = NumType::newBigRat(power * rat64_t::bitLength(magnitude),
+                                                           power * rat64_t::bitLength(q.den));
+                mpz_ui_pow_ui(payload->val.get_num_mpz_t(), magnitude, power);
+                if(power%2 && q.num < 0) mpz_neg(payload->val.get_num_mpz_t(), payload->val.get_num_mpz_t());
+                mpz_ui_pow_ui(payload->val.get_den_mpz_t(), q.den, power);
+                ans.data = payload;
+                ans.type = GmpRat;
+                ans.bigRatReduce<false>();
+                return ans;
+            }
+            case WideInt:{
+                WideWord wide_ans;
+                if(NumType::widePow(num.asWide(), power, wide_ans)) return NumType::fromWide(wide_ans);
+                return pow(num.wideToBig(), power);
+            }
+            case Dyadic:{
+                const uint64_t exponent = uint64_t(num.dyadicExponent()) * power;
+                WideWord wide_ans;
+                if(exponent <= NumType::max_dyadic_exponent && NumType::widePow(num.dyadicMantissa(), power, wide_ans)){
+                    NumType ans;
+                    ans.storeDyadic(wide_ans, static_cast<uint32_t>(exponent));
                     return ans;
                 }
+                return pow(num.dyadicToRat(), power);
+            }
+            case Decimal:{
+                const uint64_t scale = uint64_t(num.decimalScale()) * power;
+                WideWord wide_ans;
+                if(scale <= 2*NumType::max_decimal_scale && NumType::widePow(num.decimalMantissa(), power, wide_ans)){
+                    NumType ans;
+                    ans.storeDecimal(wide_ans, static_cast<uint32_t>(scale));
+                    return ans;
+                }
+                return pow(num.decimalToRat(), power);
             }
         }
 
@@ -997,4 +4179,48 @@ namespace std {
     }
 }
 
+//The Rat64Context interface over NumType, which never overflows. A block written as a template over
+//its context runs on rat64_t values first and is rerun with this context only when that overflowed.
+//A zero divisor throws std::domain_error rather than setting a flag, as NumType has no value for it.
+struct NumTypeContext{
+    static constexpr bool overflow = false;
+    static constexpr bool divide_by_zero = false;
+
+    void clear() noexcept {}
+
+    NumType add(const NumType& lhs, const NumType& rhs) const{
+        return lhs + rhs;
+    }
+
+    NumType subtract(const NumType& lhs, const NumType& rhs) const{
+        return lhs - rhs;
+    }
+
+    NumType multiply(const NumType& lhs, const NumType& rhs) const{
+        return lhs * rhs;
+    }
+
+    NumType divide(const NumType& lhs, const NumType& rhs) const{
+        if(rhs == 0) throw std::domain_error("NumTypeContext division by zero");
+        return lhs / rhs;
+    }
+
+    NumType power(const NumType& lhs, uint32_t rhs) const{
+        if(lhs == 0) return rhs == 0 ? 1 : 0; //std::pow does not take a zero base
+        return std::pow(lhs, rhs);
+    }
+
+    NumType fma(const NumType& a, const NumType& b, const NumType& c) const{
+        return NumType::fma(a, b, c);
+    }
+};
+
+#ifdef NUMTYPE_TRACE
+#include "num_trace.h"
+#endif
+
+#ifdef NUMTYPE_STATS
+#include "num_stats.h"
+#endif
+
 #endif // BIG_NUMERIC_SUM_TYPE_H
@@ -0,0 +1,279 @@
+//Compares rat64_t and NumType with the other ways to hold a small rational: double, a naive
+//__int128 rational, mpq_class and boost::rational<int64_t> (when the header is available).
+//
+//Usage: compare_bench [rounds]
+//
+//Each operation runs elementwise over fixed operand arrays, so values do not grow from one
+//operation to the next, and the best of several runs is reported. Operands come from four
+//distributions of the numerator and denominator sizes:
+//  integers:      1 to 15 bit integers, whose products still fit a word
+//  small:         1 to 10 bits
+//  random:        1 to 31 bits, uniform in bit length
+//  near-overflow: 30 or 31 bits, so most rat64_t products and sums overflow
+//rat64_t reports the share of operations that overflowed, which NumType promotes to a wider tier.
+//Cycles are time stamp counter ticks, which may differ from core cycles under frequency scaling.
+//Build in release: the canonical form asserts in rat64_t cost more than the operations themselves.
+
+#include "big_numeric_sum_type.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if __has_include(<boost/rational.hpp>)
+#include <boost/rational.hpp>
+#define COMPARE_BENCH_BOOST
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t ticks() noexcept{ return __rdtsc(); }
+#else
+static uint64_t ticks() noexcept{ return 0; }
+#endif
+
+//Reduced after every operation with a Euclidean gcd, as a straightforward implementation would
+struct Int128Rational{
+    __int128 num = 0;
+    __int128 den = 1;
+
+    Int128Rational() = default;
+    Int128Rational(__int128 n, __int128 d) : num(n), den(d){
+        if(den < 0){
+            num = -num;
+            den = -den;
+        }
+        const __int128 g = gcd(num < 0 ? -num : num, den);
+        if(g > 1){
+            num /= g;
+            den /= g;
+        }
+    }
+
+    static __int128 gcd(__int128 a, __int128 b) noexcept{
+        while(b != 0){
+            const __int128 r = a % b;
+            a = b;
+            b = r;
+        }
+        return a;
+    }
+
+    Int128Rational operator+(const Int128Rational& rhs) const{ return {num*rhs.den + rhs.num*den, den*rhs.den}; }
+    Int128Rational operator*(const Int128Rational& rhs) const{ return {num*rhs.num, den*rhs.den}; }
+    Int128Rational operator/(const Int128Rational& rhs) const{ return {num*rhs.den, den*rhs.num}; }
+    bool operator<(const Int128Rational& rhs) const{ return num*rhs.den < rhs.num*den; }
+    double toDouble() const{ return static_cast<double>(num) / static_cast<double>(den); }
+};
+
+struct Distribution{
+    const char* name;
+    uint32_t min_bits;
+    uint32_t max_bits;
+    bool integers;
+};
+
+struct Operands{
+    std::vector<int32_t> num, other_num;
+    std::vector<uint32_t> den, other_den;
+};
+
+static uint32_t randomBits(std::mt19937_64& rng, uint32_t min_bits, uint32_t max_bits){
+    const uint32_t bits = min_bits + static_cast<uint32_t>(rng() % (max_bits - min_bits + 1));
+    const uint32_t top = uint32_t(1) << (bits - 1);
+    return top | (static_cast<uint32_t>(rng()) & (top - 1));
+}
+
+//Unreduced pairs, so canonicalization has work to do. The operation benchmarks reduce them first.
+static Operands makeOperands(const Distribution& dist, size_t n, uint64_t seed){
+    std::mt19937_64 rng(seed);
+    Operands ops;
+    for(size_t i = 0; i < n; i++){
+        for(auto* side : {&ops.num, &ops.other_num}){
+            const int32_t magnitude = static_cast<int32_t>(randomBits(rng, dist.min_bits, dist.max_bits));
+            side->push_back(rng() & 1 ? -magnitude : magnitude);
+        }
+        ops.den.push_back(dist.integers ? 1 : randomBits(rng, dist.min_bits, dist.max_bits));
+        ops.other_den.push_back(dist.integers ? 1 : randomBits(rng, dist.min_bits, dist.max_bits));
+    }
+    return ops;
+}
+
+struct Result{
+    double ns_per_op;
+    double ticks_per_op;
+};
+
+static size_t rounds = 200;
+static uint64_t sink = 0;
+
+//Makes the results stored through p observable, so the loop computing them is kept
+static void clobber(const void* p) noexcept{
+    asm volatile("" : : "r"(p) : "memory");
+}
+
+//The best of five runs, each `rounds` passes of `body` over n elements
+template<typename Body>
+static Result measure(size_t n, Body body){
+    Result best = {std::numeric_limits<double>::max(), 0};
+    for(int run = 0; run < 5; run++){
+        const uint64_t t0 = ticks();
+        const auto start = std::chrono::steady_clock::now();
+        for(size_t r = 0; r < rounds; r++) body();
+        const auto end = std::chrono::steady_clock::now();
+        const uint64_t t1 = ticks();
+        const double ops = static_cast<double>(n) * rounds;
+        const double ns = std::chrono::duration<double, std::nano>(end - start).count() / ops;
+        if(ns < best.ns_per_op) best = {ns, (t1 - t0) / ops};
+    }
+    return best;
+}
+
+static void report(const char* dist, const char* op, const char* type, const Result& result, const std::string& note = ""){
+    std::cout << std::left << std::setw(15) << dist << std::setw(14) << op << std::setw(24) << type << std::right
+              << std::fixed << std::setprecision(2) << std::setw(10) << result.ns_per_op;
+    if(result.ticks_per_op > 0) std::cout << std::setw(12) << result.ticks_per_op;
+    else std::cout << std::setw(12) << "-";
+    std::cout << std::setw(12) << std::setprecision(1) << 1e3 / result.ns_per_op << "  " << note << std::endl;
+}
+
+static std::string overflowNote(size_t overflows, size_t n){
+    if(overflows == 0) return "";
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << 100.0 * overflows / (n * rounds) << "% overflowed";
+    return out.str();
+}
+
+//Runs add, mul, div, compare and conversion to double for one type
+template<typename T, typename Make, typename Add, typename Mul, typename Div, typename Less, typename ToDouble>
+static void benchmarkType(const char* dist, const char* type, const Operands& ops,
+                          Make make, Add add, Mul mul, Div div, Less less, ToDouble to_double){
+    const size_t n = ops.num.size();
+    std::vector<T> a, b;
+    for(size_t i = 0; i < n; i++){
+        a.push_back(make(ops.num[i], ops.den[i]));
+        b.push_back(make(ops.other_num[i], ops.other_den[i]));
+    }
+    std::vector<T> out(n);
+
+    size_t overflows = 0;
+    Result result = measure(n, [&]{ for(size_t i = 0; i < n; i++) overflows += add(a[i], b[i], out[i]); clobber(out.data()); });
+    report(dist, "add", type, result, overflowNote(overflows / 5, n));
+    overflows = 0;
+    result = measure(n, [&]{ for(size_t i = 0; i < n; i++) overflows += mul(a[i], b[i], out[i]); clobber(out.data()); });
+    report(dist, "mul", type, result, overflowNote(overflows / 5, n));
+    overflows = 0;
+    result = measure(n, [&]{ for(size_t i = 0; i < n; i++) overflows += div(a[i], b[i], out[i]); clobber(out.data()); });
+    report(dist, "div", type, result, overflowNote(overflows / 5, n));
+    result = measure(n, [&]{ for(size_t i = 0; i < n; i++) sink += less(a[i], b[i]); });
+    report(dist, "compare", type, result);
+    double total = 0;
+    result = measure(n, [&]{ for(size_t i = 0; i < n; i++) total += to_double(a[i]); });
+    report(dist, "to double", type, result);
+    sink += static_cast<uint64_t>(total);
+}
+
+//Building a canonical value from an unreduced numerator and denominator
+template<typename T, typename Make>
+static void benchmarkCanonicalize(const char* dist, const char* type, const Operands& ops, Make make){
+    const size_t n = ops.num.size();
+    std::vector<int32_t> num(n);
+    std::vector<uint32_t> den(n);
+    for(size_t i = 0; i < n; i++){
+        //A shared factor where it fits, so there is something to cancel
+        const uint32_t room = std::numeric_limits<int32_t>::max() / std::max<uint32_t>(std::abs(ops.num[i]), ops.den[i]);
+        const uint32_t factor = room >= 15 ? 15 : 1;
+        num[i] = ops.num[i] * static_cast<int32_t>(factor);
+        den[i] = ops.den[i] * factor;
+    }
+    std::vector<T> out(n);
+    const Result result = measure(n, [&]{ for(size_t i = 0; i < n; i++) out[i] = make(num[i], den[i]); clobber(out.data()); });
+    report(dist, "canonicalize", type, result);
+}
+
+static void benchmarkDistribution(const Distribution& dist, size_t n){
+    const Operands ops = makeOperands(dist, n, 0x5eed + dist.max_bits + dist.integers);
+    const char* name = dist.name;
+
+    benchmarkType<double>(name, "double", ops,
+        [](int32_t n, uint32_t d){ return n / static_cast<double>(d); },
+        [](double a, double b, double& ans){ ans = a + b; return false; },
+        [](double a, double b, double& ans){ ans = a * b; return false; },
+        [](double a, double b, double& ans){ ans = a / b; return false; },
+        [](double a, double b){ return a < b; },
+        [](double a){ return a; });
+
+    benchmarkType<rat64_t>(name, "rat64_t", ops,
+        [](int32_t n, uint32_t d){ return rat64_t(n, d); },
+        [](const rat64_t& a, const rat64_t& b, rat64_t& ans){ return rat64_t::add(a, b, ans); },
+        [](const rat64_t& a, const rat64_t& b, rat64_t& ans){ return rat64_t::multiply(a, b, ans); },
+        [](const rat64_t& a, const rat64_t& b, rat64_t& ans){ return rat64_t::divide(a, b, ans); },
+        [](const rat64_t& a, const rat64_t& b){ return a < b; },
+        [](const rat64_t& a){ return static_cast<double>(a); });
+
+    benchmarkType<NumType>(name, "NumType", ops,
+        [](int32_t n, uint32_t d){ NumType ans(n, d); ans.reduce(); return ans; },
+        [](const NumType& a, const NumType& b, NumType& ans){ ans = a + b; return false; },
+        [](const NumType& a, const NumType& b, NumType& ans){ ans = a * b; return false; },
+        [](const NumType& a, const NumType& b, NumType& ans){ ans = a / b; return false; },
+        [](const NumType& a, const NumType& b){ return a < b; },
+        [](const NumType& a){ return a.toDouble(); });
+
+    benchmarkType<Int128Rational>(name, "__int128 rational", ops,
+        [](int32_t n, uint32_t d){ return Int128Rational(n, d); },
+        [](const Int128Rational& a, const Int128Rational& b, Int128Rational& ans){ ans = a + b; return false; },
+        [](const Int128Rational& a, const Int128Rational& b, Int128Rational& ans){ ans = a * b; return false; },
+        [](const Int128Rational& a, const Int128Rational& b, Int128Rational& ans){ ans = a / b; return false; },
+        [](const Int128Rational& a, const Int128Rational& b){ return a < b; },
+        [](const Int128Rational& a){ return a.toDouble(); });
+
+#ifdef COMPARE_BENCH_BOOST
+    typedef boost::rational<int64_t> BoostRational;
+    benchmarkType<BoostRational>(name, "boost::rational<int64_t>", ops,
+        [](int32_t n, uint32_t d){ return BoostRational(n, d); },
+        [](const BoostRational& a, const BoostRational& b, BoostRational& ans){ ans = a + b; return false; },
+        [](const BoostRational& a, const BoostRational& b, BoostRational& ans){ ans = a * b; return false; },
+        [](const BoostRational& a, const BoostRational& b, BoostRational& ans){ ans = a / b; return false; },
+        [](const BoostRational& a, const BoostRational& b){ return a < b; },
+        [](const BoostRational& a){ return boost::rational_cast<double>(a); });
+#endif
+
+    benchmarkType<mpq_class>(name, "mpq_class", ops,
+        [](int32_t n, uint32_t d){ mpq_class q(n, d); q.canonicalize(); return q; },
+        [](const mpq_class& a, const mpq_class& b, mpq_class& ans){ ans = a + b; return false; },
+        [](const mpq_class& a, const mpq_class& b, mpq_class& ans){ ans = a * b; return false; },
+        [](const mpq_class& a, const mpq_class& b, mpq_class& ans){ ans = a / b; return false; },
+        [](const mpq_class& a, const mpq_class& b){ return a < b; },
+        [](const mpq_class& a){ return a.get_d(); });
+
+    benchmarkCanonicalize<rat64_t>(name, "rat64_t", ops, [](int32_t n, uint32_t d){ return rat64_t(n, d); });
+    benchmarkCanonicalize<NumType>(name, "NumType", ops, [](int32_t n, uint32_t d){ NumType ans(n, d); ans.reduce(); return ans; });
+    benchmarkCanonicalize<Int128Rational>(name, "__int128 rational", ops, [](int32_t n, uint32_t d){ return Int128Rational(n, d); });
+#ifdef COMPARE_BENCH_BOOST
+    benchmarkCanonicalize<BoostRational>(name, "boost::rational<int64_t>", ops, [](int32_t n, uint32_t d){ return BoostRational(n, d); });
+#endif
+    benchmarkCanonicalize<mpq_class>(name, "mpq_class", ops, [](int32_t n, uint32_t d){ mpq_class q(n, d); q.canonicalize(); return q; });
+}
+
+int main(int argc, char** argv){
+    if(argc > 1) rounds = std::max(1, std::atoi(argv[1]));
+#ifndef NDEBUG
+    std::cout << "Assertions are enabled, so these timings are not representative of a release build" << std::endl;
+#endif
+    constexpr size_t n = 1024;
+
+    std::cout << std::left << std::setw(15) << "distribution" << std::setw(14) << "op" << std::setw(24) << "type" << std::right
+              << std::setw(10) << "ns/op" << std::setw(12) << "cycles/op" << std::setw(12) << "Mop/s" << std::endl;
+    for(const Distribution& dist : {Distribution{"integers", 1, 15, true}, Distribution{"small", 1, 10, false},
+                                    Distribution{"random", 1, 31, false}, Distribution{"near-overflow", 30, 31, false}})
+        benchmarkDistribution(dist, n);
+#ifndef COMPARE_BENCH_BOOST
+    std::cout << "boost/rational.hpp was not found, boost::rational was skipped" << std::endl;
+#endif
+
+    //Keeps the results from being optimized away
+    return sink == 1;
+}
@@ -0,0 +1,369 @@
+#ifndef LAZY_NUM_H
+#define LAZY_NUM_H
+
+//Rationals with deferred canonicalization.
+//
+//NumType reduces every result to lowest terms and the narrowest tier, paying for a gcd on each
+//operation. LazyNum keeps an unreduced numerator and denominator together with their bit lengths,
+//which bound the size of the next result before it is computed. Word values stay in 64 bit
+//registers until a product or sum could overflow. Only then is the gcd taken, and only if the
+//reduced value still cannot fit does it move to GMP. GMP values are reduced when their size has
+//doubled since the last reduction, so the gcd cost is amortized over long chains of operations.
+//Equality and ordering compare by cross multiplication, while hashing and output go through the
+//canonical NumType.
+
+#include "big_numeric_sum_type.h"
+
+#ifndef NUMTYPE_LAZY_NORMALIZE_BITS
+#define NUMTYPE_LAZY_NORMALIZE_BITS 256
+#endif
+
+struct LazyNum{
+    static constexpr int word_bits = 63; //Word magnitudes stay below 2^63, so products fit 128 bits
+
+    int64_t num = 0;
+    int64_t den = 1; //Always positive
+    int num_bits = 0; //Bit lengths of |num| and den, while the value is on words
+    int den_bits = 1;
+    bool big = false;
+    mpz_class big_num;
+    mpz_class big_den;
+    mp_bitcnt_t normalize_bits = NUMTYPE_LAZY_NORMALIZE_BITS;
+
+    LazyNum() = default;
+    //The GMP members are only copied while in use, so word values copy without allocating
+    LazyNum(const LazyNum& other)
+        : num(other.num), den(other.den), num_bits(other.num_bits), den_bits(other.den_bits), big(other.big),
+          normalize_bits(other.normalize_bits){
+        if(big){
+            big_num = other.big_num;
+            big_den = other.big_den;
+        }
+    }
+    LazyNum(LazyNum&& other) = default;
+    LazyNum& operator=(const LazyNum& other){
+        num = other.num;
+        den = other.den;
+        num_bits = other.num_bits;
+        den_bits = other.den_bits;
+        big = other.big;
+        normalize_bits = other.normalize_bits;
+        if(big){
+            big_num = other.big_num;
+            big_den = other.big_den;
+        }
+        return *this;
+    }
+    LazyNum& operator=(LazyNum&& other) = default;
+    LazyNum(int32_t val){
+        setWords(val, 1);
+    }
+    LazyNum(const NumType& val){
+        switch (val.type) {
+            case WordInt: setWords(val.asWordInt(), 1); break;
+            case WordRat: setWords(val.asWordRat().num, val.asWordRat().den); break;
+            case WideInt:
+                if(NumType::wideBitLength(val.asWide()) <= word_bits){
+                    setWords(static_cast<int64_t>(val.asWide()), 1);
+                }else{
+                    NumType::setWide(big_num.get_mpz_t(), val.asWide());
+                    big_den = 1;
+                    big = true;
+                }
+                break;
+            case GmpInt:
+                big_num = val.asBigInt();
+                big_den = 1;
+                big = true;
+                demote();
+                break;
+            case GmpRat:
+                big_num = val.asBigRat().get_num();
+                big_den = val.asBigRat().get_den();
+                big = true;
+                demote();
+                break;
+            case Dyadic:
+                *this = LazyNum(val.dyadicToRat());
+                break;
+            case Decimal:
+                *this = LazyNum(val.decimalToRat());
+                break;
+        }
+    }
+
+    bool isBig() const noexcept{
+        return big;
+    }
+
+    void setWords(int64_t n, int64_t d) noexcept{
+        assert(d > 0 && n != std::numeric_limits<int64_t>::min());
+        num = n;
+        den = d;
+        num_bits = rat64_t::bitLength(rat64_t::wordAbs(n));
+        den_bits = rat64_t::bitLength(static_cast<uint64_t>(d));
+        big = false;
+    }
+
+    void setWide(WideWord n, WideWord d){
+        if(NumType::wideBitLength(n) <= word_bits && NumType::wideBitLength(d) <= word_bits){
+            setWords(static_cast<int64_t>(n), static_cast<int64_t>(d));
+        }else{
+            NumType::setWide(big_num.get_mpz_t(), n);
+            NumType::setWide(big_den.get_mpz_t(), d);
+            big = true;
+        }
+    }
+
+    static void reduceWords(int64_t& n, int64_t& d) noexcept{
+        const int64_t gcd = static_cast<int64_t>(std::gcd(rat64_t::wordAbs(n), static_cast<uint64_t>(d)));
+        n /= gcd;
+        d /= gcd;
+    }
+
+    void promote(){
+        if(big) return;
+        NumType::setInt64(big_num.get_mpz_t(), num);
+        NumType::setInt64(big_den.get_mpz_t(), den);
+        big = true;
+    }
+
+    void demote() noexcept{
+        if(mpz_sizeinbase(big_num.get_mpz_t(), 2) <= word_bits && mpz_sizeinbase(big_den.get_mpz_t(), 2) <= word_bits)
+            setWords(static_cast<int64_t>(NumType::getWide(big_num.get_mpz_t())),
+                     static_cast<int64_t>(NumType::getWide(big_den.get_mpz_t())));
+    }
+
+    //Divides out the gcd, moving back to words if the reduced value fits
+    void normalize(){
+        if(!big){
+            const uint64_t gcd = std::gcd(rat64_t::wordAbs(num), static_cast<uint64_t>(den));
+            if(gcd > 1) setWords(num / static_cast<int64_t>(gcd), den / static_cast<int64_t>(gcd));
+            return;
+        }
+        ScratchInt gcd;
+        mpz_gcd(gcd, big_num.get_mpz_t(), big_den.get_mpz_t());
+        if(mpz_cmp_ui(gcd.z, 1) != 0){
+            mpz_divexact(big_num.get_mpz_t(), big_num.get_mpz_t(), gcd);
+            mpz_divexact(big_den.get_mpz_t(), big_den.get_mpz_t(), gcd);
+        }
+        const mp_bitcnt_t bits = mpz_sizeinbase(big_num.get_mpz_t(), 2) + mpz_sizeinbase(big_den.get_mpz_t(), 2);
+        normalize_bits = std::max<mp_bitcnt_t>(NUMTYPE_LAZY_NORMALIZE_BITS, 2*bits);
+        demote();
+    }
+
+    //GMP views of the numerator and denominator, filling a scratch register for word values
+    mpz_srcptr numView(mpz_ptr scratch) const{
+        if(big) return big_num.get_mpz_t();
+        NumType::setInt64(scratch, num);
+        return scratch;
+    }
+
+    mpz_srcptr denView(mpz_ptr scratch) const{
+        if(big) return big_den.get_mpz_t();
+        NumType::setInt64(scratch, den);
+        return scratch;
+    }
+
+    void afterBigOp(){
+        if(mpz_sizeinbase(big_num.get_mpz_t(), 2) + mpz_sizeinbase(big_den.get_mpz_t(), 2) > normalize_bits) normalize();
+    }
+
+    void operator*=(const LazyNum& other){
+        if(!big && !other.big){
+            if(num_bits + other.num_bits <= word_bits && den_bits + other.den_bits <= word_bits){
+                setWords(num * other.num, den * other.den);
+                return;
+            }
+
+            //The product could overflow, so reduce both factors and cancel across them first.
+            //The product of the results is in lowest terms, so it only moves to GMP if it must.
+            int64_t lhs_num = num, lhs_den = den, rhs_num = other.num, rhs_den = other.den;
+            reduceWords(lhs_num, lhs_den);
+            reduceWords(rhs_num, rhs_den);
+            reduceWords(lhs_num, rhs_den);
+            reduceWords(rhs_num, lhs_den);
+            setWide(static_cast<WideWord>(lhs_num) * rhs_num, static_cast<WideWord>(lhs_den) * rhs_den);
+            return;
+        }
+
+        promote();
+        ScratchInt scratch;
+        mpz_mul(big_num.get_mpz_t(), big_num.get_mpz_t(), other.numView(scratch));
+        mpz_mul(big_den.get_mpz_t(), big_den.get_mpz_t(), other.denView(scratch));
+        if(mpz_sgn(big_num.get_mpz_t()) == 0) big_den = 1;
+        afterBigOp();
+    }
+
+    void operator/=(const LazyNum& other){
+        operator*=(other.reciprocal());
+    }
+
+    void operator+=(const LazyNum& other){
+        addSigned<false>(other);
+    }
+
+    void operator-=(const LazyNum& other){
+        addSigned<true>(other);
+    }
+
+    template<bool subtract>
+    void addSigned(const LazyNum& other){
+        if(!big && !other.big){
+            int64_t rhs_num = subtract ? -other.num : other.num;
+            if(den == other.den){
+                if(std::max(num_bits, other.num_bits) + 1 <= word_bits){
+                    setWords(num + rhs_num, den);
+                    return;
+                }
+            }else if(std::max(num_bits + other.den_bits, other.num_bits + den_bits) + 1 <= word_bits &&
+                     den_bits + other.den_bits <= word_bits){
+                setWords(num * other.den + rhs_num * den, den * other.den);
+                return;
+            }
+
+            //The sum could overflow, so reduce both terms before computing it exactly in 128 bits
+            int64_t lhs_num = num, lhs_den = den, rhs_den = other.den;
+            reduceWords(lhs_num, lhs_den);
+            reduceWords(rhs_num, rhs_den);
+            setWide(static_cast<WideWord>(lhs_num) * rhs_den + static_cast<WideWord>(rhs_num) * lhs_den,
+                    static_cast<WideWord>(lhs_den) * rhs_den);
+            if(big) normalize();
+            return;
+        }
+
+        promote();
+        ScratchInt num_scratch, den_scratch;
+        mpz_srcptr rhs_num = other.numView(num_scratch);
+        mpz_srcptr rhs_den = other.denView(den_scratch);
+        if(mpz_cmp(big_den.get_mpz_t(), rhs_den) == 0){
+            if(subtract) mpz_sub(big_num.get_mpz_t(), big_num.get_mpz_t(), rhs_num);
+            else mpz_add(big_num.get_mpz_t(), big_num.get_mpz_t(), rhs_num);
+        }else{
+            ScratchInt cross;
+            mpz_mul(cross, rhs_num, big_den.get_mpz_t());
+            mpz_mul(big_num.get_mpz_t(), big_num.get_mpz_t(), rhs_den);
+            if(subtract) mpz_sub(big_num.get_mpz_t(), big_num.get_mpz_t(), cross);
+            else mpz_add(big_num.get_mpz_t(), big_num.get_mpz_t(), cross);
+            mpz_mul(big_den.get_mpz_t(), big_den.get_mpz_t(), rhs_den);
+        }
+        afterBigOp();
+    }
+
+    LazyNum operator-() const{
+        LazyNum ans(*this);
+        if(big) mpz_neg(ans.big_num.get_mpz_t(), ans.big_num.get_mpz_t());
+        else ans.num = -num;
+        return ans;
+    }
+
+    LazyNum reciprocal() const{
+        LazyNum ans(*this);
+        if(big){
+            assert(mpz_sgn(big_num.get_mpz_t()) != 0);
+            mpz_swap(ans.big_num.get_mpz_t(), ans.big_den.get_mpz_t());
+            if(mpz_sgn(ans.big_den.get_mpz_t()) < 0){
+                mpz_neg(ans.big_num.get_mpz_t(), ans.big_num.get_mpz_t());
+                mpz_neg(ans.big_den.get_mpz_t(), ans.big_den.get_mpz_t());
+            }
+        }else{
+            assert(num != 0);
+            if(num > 0) ans.setWords(den, num);
+            else ans.setWords(-den, -num);
+        }
+        return ans;
+    }
+
+    LazyNum operator*(const LazyNum& other) const{
+        LazyNum ans(*this);
+        ans *= other;
+        return ans;
+    }
+
+    LazyNum operator/(const LazyNum& other) const{
+        LazyNum ans(*this);
+        ans /= other;
+        return ans;
+    }
+
+    LazyNum operator+(const LazyNum& other) const{
+        LazyNum ans(*this);
+        ans += other;
+        return ans;
+    }
+
+    LazyNum operator-(const LazyNum& other) const{
+        LazyNum ans(*this);
+        ans -= other;
+        return ans;
+    }
+
+    //Denominators are positive, so the sign of a*d - c*b orders a/b and c/d without reducing either
+    int compare(const LazyNum& other) const{
+        if(!big && !other.big){
+            const WideWord lhs = static_cast<WideWord>(num) * other.den;
+            const WideWord rhs = static_cast<WideWord>(other.num) * den;
+            return (lhs > rhs) - (lhs < rhs);
+        }
+        ScratchInt scratch_a, scratch_b, lhs, rhs;
+        mpz_mul(lhs, numView(scratch_a), other.denView(scratch_b));
+        mpz_mul(rhs, other.numView(scratch_a), denView(scratch_b));
+        return mpz_cmp(lhs, rhs);
+    }
+
+    bool operator==(const LazyNum& other) const{
+        return compare(other) == 0;
+    }
+
+    bool operator!=(const LazyNum& other) const{
+        return compare(other) != 0;
+    }
+
+    bool operator<(const LazyNum& other) const{
+        return compare(other) < 0;
+    }
+
+    bool operator>(const LazyNum& other) const{
+        return compare(other) > 0;
+    }
+
+    bool operator<=(const LazyNum& other) const{
+        return compare(other) <= 0;
+    }
+
+    bool operator>=(const LazyNum& other) const{
+        return compare(other) >= 0;
+    }
+
+    //The canonical value in the narrowest tier
+    NumType toNumType() const{
+        if(!big){
+            const uint64_t gcd = std::gcd(rat64_t::wordAbs(num), static_cast<uint64_t>(den));
+            const int64_t n = num / static_cast<int64_t>(gcd);
+            const int64_t d = den / static_cast<int64_t>(gcd);
+            if(d == 1) return NumType::fromWide(n);
+            if(NumType::fitsWordInt(n) && d <= std::numeric_limits<uint32_t>::max())
+                return NumType(rat64_t(static_cast<int32_t>(n), static_cast<uint32_t>(d)));
+        }
+        ScratchInt scratch_num, scratch_den;
+        ScratchRat q;
+        mpz_set(mpq_numref(q.q), numView(scratch_num));
+        mpz_set(mpq_denref(q.q), denView(scratch_den));
+        mpq_canonicalize(q.q);
+        return NumType::fromScratch(q.q);
+    }
+
+    std::string toString() const{
+        return toNumType().toString();
+    }
+};
+
+namespace std {
+    template<> struct hash<LazyNum>{
+        size_t operator()(const LazyNum& val) const{
+            return std::hash<NumType>()(val.toNumType());
+        }
+    };
+}
+
+#endif // LAZY_NUM_H
@@ -1,8 +1,16 @@
 #include <chrono>
 #include <iostream>
+#include <vector>
 
 #include "rat64_t.h"
 #include "big_numeric_sum_type.h"
+#include "multi_modular.h"
+#include "num_vector.h"
+#include "lazy_num.h"
+#include "num_trace.h"
+#include "num_stats.h"
+#include <sstream>
+#include <unordered_set>
 
 constexpr size_t benchmark_iters = 500000;
 
@@ -76,6 +84,943 @@ void benchmarkGmp(){
     std::cout << duration.count() << "ms" << std::endl;
 }
 
+void benchmarkTierHints(){
+    NumType int_step = 3;
+    NumType rat_step(1,3);
+
+    std::cout << "SumType Integer Add/Mult: ";
+    auto start = std::chrono::high_resolution_clock::now();
+    NumType sink = 0;
+    for(size_t i = 0; i < benchmark_iters; i++){
+        NumType t = 1;
+        for(size_t i = 0; i < 19; i++){
+            t *= int_step;
+            t += int_step;
+        }
+        sink += t.type;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "Hinted Integer Add/Mult: ";
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < benchmark_iters; i++){
+        NumType t = 1;
+        for(size_t i = 0; i < 19; i++){
+            t.multiplyHinted<WordInt>(int_step);
+            t.addHinted<WordInt>(int_step);
+        }
+        sink.addHinted<WordInt>(NumType(t.type));
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "SumType Rational Add/Mult: ";
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < benchmark_iters; i++){
+        NumType t(1,2);
+        for(size_t i = 0; i < 12; i++){
+            t *= rat_step;
+            t += rat_step;
+        }
+        sink += t.type;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "Hinted Rational Add/Mult: ";
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < benchmark_iters; i++){
+        NumType t(1,2);
+        for(size_t i = 0; i < 12; i++){
+            t.multiplyHinted<WordRat>(rat_step);
+            t.addHinted<WordRat>(rat_step);
+        }
+        sink.addHinted<WordInt>(NumType(t.type));
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    if(sink == 0) std::cout << std::endl;
+}
+
+void benchmarkCopies(){
+    constexpr size_t copy_iters = 20000;
+    const mpz_class big_value = mpz_class(1) << 512;
+
+    std::cout << "SumType big value copies: ";
+    std::vector<NumType> nums(100, NumType(big_value));
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < copy_iters; i++){
+        std::vector<NumType> copy = nums;
+        nums[i % nums.size()] = copy[(i+1) % nums.size()];
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "mpz_class big value copies: ";
+    std::vector<mpz_class> mpzs(100, big_value);
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < copy_iters; i++){
+        std::vector<mpz_class> copy = mpzs;
+        mpzs[i % mpzs.size()] = copy[(i+1) % mpzs.size()];
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+}
+
+void benchmarkPower(){
+    const uint32_t ranges[][2] = {{2,8}, {9,31}, {32,256}};
+
+    for(const auto& range : ranges){
+        std::cout << "SumType pow, exponents " << range[0] << "-" << range[1] << ": ";
+        size_t words = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for(size_t i = 0; i < benchmark_iters/10; i++){
+            uint32_t power = range[0] + i % (range[1] - range[0] + 1);
+            words += std::pow(NumType(2 + static_cast<int32_t>(i%3)), power).type == WordInt;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+        std::cout << duration.count() << "ms (" << words << " in word range)" << std::endl;
+    }
+
+    std::cout << "rat64_t power, exponents 0-40: ";
+    size_t overflows = 0;
+    rat64_t ans;
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < benchmark_iters; i++)
+        overflows += rat64_t::power(rat64_t(-3, 2 + i%5), i%41, ans);
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms (" << overflows << " overflows)" << std::endl;
+}
+
+size_t gmp_allocations = 0;
+
+void* countingAllocate(size_t size){
+    gmp_allocations++;
+    return malloc(size);
+}
+
+void* countingReallocate(void* ptr, size_t, size_t size){
+    gmp_allocations++;
+    return realloc(ptr, size);
+}
+
+void countingFree(void* ptr, size_t){
+    free(ptr);
+}
+
+void benchmarkScratchAllocations(){
+    constexpr size_t scratch_iters = 100000;
+    mp_set_memory_functions(countingAllocate, countingReallocate, countingFree);
+
+    const NumType big(mpz_class(mpz_class(1) << 100));
+    const NumType big_rat(mpq_class(mpz_class(1) << 100, 3));
+    const NumType third(1,3);
+    size_t hits = NumType::binomialCoeff(47, 6).type + (third < big); //Warm up this thread's registers
+
+    std::cout << "Table binomialCoeff: ";
+    gmp_allocations = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < scratch_iters; i++)
+        hits += NumType::binomialCoeff(40 + i%8, 6).type;
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms, " << gmp_allocations << " GMP allocations" << std::endl;
+
+    std::cout << "Cached big binomialCoeff: ";
+    gmp_allocations = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < scratch_iters; i++)
+        hits += NumType::binomialCoeff(300, 100 + i%32).type;
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms, " << gmp_allocations << " GMP allocations" << std::endl;
+
+    std::cout << "Uncached big binomialCoeff: ";
+    gmp_allocations = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < scratch_iters; i++){
+        ScratchInt rop;
+        mpz_bin_uiui(rop, 300, 100 + i%32);
+        hits += NumType::fromScratch(rop).type;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms, " << gmp_allocations << " GMP allocations" << std::endl;
+
+    std::cout << "Scratch mixed comparisons: ";
+    gmp_allocations = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < scratch_iters; i++)
+        hits += (third < big) + (big < third) + (third < big_rat) + (big_rat < third);
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms, " << gmp_allocations << " GMP allocations" << std::endl;
+
+    std::cout << "Scratch pow: ";
+    gmp_allocations = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < scratch_iters; i++)
+        hits += std::pow(big, 3).type;
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms, " << gmp_allocations << " GMP allocations" << std::endl;
+
+    mp_set_memory_functions(nullptr, nullptr, nullptr);
+    if(hits == 0) std::cout << std::endl;
+}
+
+//Hinted operations must match the general operators whether or not the hint is right
+template<Type lhs_tier, Type rhs_tier>
+void checkTierHints(const std::vector<NumType>& values){
+    for(const NumType& a : values){
+        for(const NumType& b : values){
+            NumType expected = a;
+            expected *= b;
+            NumType hinted = a;
+            hinted.multiplyHinted<lhs_tier, rhs_tier>(b);
+            assert(hinted.type == expected.type && hinted.toString() == expected.toString());
+
+            expected = a;
+            expected += b;
+            hinted = a;
+            hinted.addHinted<lhs_tier, rhs_tier>(b);
+            assert(hinted.type == expected.type && hinted.toString() == expected.toString());
+
+            expected = a;
+            expected -= b;
+            hinted = a;
+            hinted.subtractHinted<lhs_tier, rhs_tier>(b);
+            assert(hinted.type == expected.type && hinted.toString() == expected.toString());
+        }
+    }
+}
+
+//Plain Gaussian elimination, the direct approach the multi-modular engine replaces
+mpq_class mpqDeterminant(std::vector<mpq_class> a, size_t n){
+    mpq_class det = 1;
+    for(size_t col = 0; col < n; col++){
+        size_t pivot = col;
+        while(pivot < n && a[pivot*n + col] == 0) pivot++;
+        if(pivot == n) return 0;
+        if(pivot != col){
+            for(size_t j = col; j < n; j++) std::swap(a[pivot*n + j], a[col*n + j]);
+            det = -det;
+        }
+        det *= a[col*n + col];
+        for(size_t i = col+1; i < n; i++){
+            mpq_class factor = a[i*n + col] / a[col*n + col];
+            for(size_t j = col+1; j < n; j++) a[i*n + j] -= factor * a[col*n + j];
+        }
+    }
+    return det;
+}
+
+//Deterministic small rationals num/den with |num| <= 99 and den in [1,9]
+std::vector<NumType> testMatrix(size_t n, uint32_t seed){
+    std::vector<NumType> m;
+    for(size_t i = 0; i < n*n; i++){
+        seed = seed*1103515245u + 12345u;
+        int32_t num = int32_t((seed >> 8) % 199) - 99;
+        uint32_t den = 1 + (seed >> 20) % 9;
+        m.push_back(NumType(mpq_class(num, den)));
+        m.back().reduce();
+    }
+    return m;
+}
+
+std::vector<mpq_class> toMpq(const std::vector<NumType>& m){
+    std::vector<mpq_class> ans;
+    for(const NumType& val : m) ans.push_back(mpq_class(val.toString()));
+    return ans;
+}
+
+void benchmarkMultiModular(){
+    constexpr size_t n = 40;
+    std::vector<NumType> m = testMatrix(n, 7);
+    std::vector<mpq_class> q = toMpq(m);
+
+    std::cout << "Direct mpq_class determinant (" << n << 'x' << n << "): ";
+    auto start = std::chrono::high_resolution_clock::now();
+    mpq_class direct = mpqDeterminant(q, n);
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "Multi-modular determinant (" << n << 'x' << n << "): ";
+    start = std::chrono::high_resolution_clock::now();
+    NumType modular = determinant(m, n);
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    if(modular.toString() != direct.get_str()) std::cout << "MISMATCH" << std::endl;
+}
+
+std::vector<NumType> testColumn(size_t n, uint32_t seed, size_t big_every){
+    std::vector<NumType> column;
+    for(size_t i = 0; i < n; i++){
+        seed = seed * 1103515245u + 12345u;
+        int32_t z = static_cast<int32_t>(seed >> 8) % 20000 - 10000;
+        if(big_every && i % big_every == big_every - 1){
+            NumType big = NumType(mpz_class(mpz_class(z) * mpz_class("100000000000000000000000000000000000000000")));
+            big.reduce();
+            column.push_back(big);
+        }else if(big_every && i % big_every == 1){
+            column.push_back(NumType(z, 7u));
+            column.back().reduce();
+        }else{
+            column.push_back(z);
+        }
+    }
+    return column;
+}
+
+void benchmarkNumVector(){
+    constexpr size_t n = 4096;
+    constexpr size_t reps = 500;
+    std::vector<NumType> a = testColumn(n, 1, 0);
+    std::vector<NumType> b = testColumn(n, 2, 0);
+    NumVector va(a);
+    const NumVector vb(b);
+    const NumType scale = 3;
+    NumType sink = 0;
+
+    std::cout << "std::vector<NumType> axpy and sum: ";
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t r = 0; r < reps; r++){
+        for(size_t i = 0; i < n; i++){
+            a[i] += b[i];
+            a[i] -= scale;
+        }
+        NumType total;
+        for(const NumType& val : a) total += val;
+        sink += total.type;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "NumVector axpy and sum: ";
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t r = 0; r < reps; r++){
+        va += vb;
+        va -= scale;
+        sink += va.sum().type;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "std::vector<NumType> compare to scalar: ";
+    const NumType bound(1,3);
+    start = std::chrono::high_resolution_clock::now();
+    size_t count = 0;
+    for(size_t r = 0; r < reps; r++)
+        for(const NumType& val : a) count += val < bound;
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "NumVector compare to scalar: ";
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t r = 0; r < reps; r++) count -= va.countLessThan(bound);
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    if(count != 0 || sink == 0 || va.toVector() != a) std::cout << "MISMATCH" << std::endl;
+}
+
+void benchmarkLazyNum(){
+    constexpr size_t chain = 64;
+    constexpr size_t reps = 20000;
+    std::vector<NumType> factors;
+    for(size_t i = 0; i < chain; i++){
+        factors.push_back(NumType(static_cast<int32_t>(i%7 + 2), static_cast<uint32_t>(i%5 + 3)));
+        factors.back().reduce();
+    }
+    std::vector<LazyNum> lazy_factors(factors.begin(), factors.end());
+    NumType sink = 0;
+
+    std::cout << "NumType product chain: ";
+    auto start = std::chrono::high_resolution_clock::now();
+    NumType eager_ans;
+    for(size_t r = 0; r < reps; r++){
+        NumType t = 1;
+        for(const NumType& f : factors) t *= f;
+        eager_ans = t;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "LazyNum product chain: ";
+    start = std::chrono::high_resolution_clock::now();
+    LazyNum lazy_ans;
+    for(size_t r = 0; r < reps; r++){
+        LazyNum t = 1;
+        for(const LazyNum& f : lazy_factors) t *= f;
+        lazy_ans = t;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+    if(lazy_ans.toNumType() != eager_ans) std::cout << "MISMATCH" << std::endl;
+
+    std::cout << "NumType harmonic sum: ";
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t r = 0; r < reps/100; r++){
+        NumType t = 0;
+        for(int32_t i = 1; i <= 300; i++) t += NumType(1, static_cast<uint32_t>(i));
+        eager_ans = t;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "LazyNum harmonic sum: ";
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t r = 0; r < reps/100; r++){
+        LazyNum t = 0;
+        for(int32_t i = 1; i <= 300; i++) t += LazyNum(NumType(1, static_cast<uint32_t>(i)));
+        lazy_ans = t;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+    if(lazy_ans.toNumType() != eager_ans) std::cout << "MISMATCH" << std::endl;
+}
+
+void benchmarkDivision(){
+    std::vector<NumType> values = {NumType(3,4), NumType(mpz_class("123456789012345678901234567890123456789012345")),
+                                   NumType(mpq_class("7/123456789012345678901234567890")),
+                                   NumType(mpq_class("-123456789012345678901234567890123456789/9")), NumType(-7),
+                                   std::pow(NumType(3),50)};
+    for(NumType& val : values) val.reduce();
+    constexpr size_t reps = benchmark_iters/10;
+    NumType sink = 0;
+
+    std::cout << "Reciprocal then multiply: ";
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t r = 0; r < reps; r++){
+        for(const NumType& lhs : values){
+            for(const NumType& rhs : values){
+                NumType t = lhs;
+                t *= rhs.reciprocal();
+                sink += t.type;
+            }
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "Direct division: ";
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t r = 0; r < reps; r++){
+        for(const NumType& lhs : values){
+            for(const NumType& rhs : values){
+                NumType t = lhs;
+                t /= rhs;
+                sink -= t.type;
+            }
+        }
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    if(sink != 0) std::cout << "MISMATCH" << std::endl;
+}
+
+void benchmarkDivmod(){
+    std::vector<NumType> values = {NumType(7,3), NumType(-100), NumType(mpq_class("-123456789012345678901234567890123/7")),
+                                   NumType(mpz_class("98765432109876543210987654321")), NumType(std::numeric_limits<int32_t>::max(), 5)};
+    for(NumType& val : values) val.reduce();
+    constexpr size_t reps = benchmark_iters/10;
+    NumType sink = 0;
+
+    std::cout << "Remainder then quotient: ";
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++){
+        for(const NumType& lhs : values){
+            for(const NumType& rhs : values){
+                const NumType r = lhs % rhs;
+                const NumType q = (lhs - r) / rhs;
+                sink += q.type + r.type;
+            }
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "Single pass divmod: ";
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++){
+        for(const NumType& lhs : values){
+            for(const NumType& rhs : values){
+                NumType q, r;
+                lhs.roundedDivide<NumType::Trunc>(rhs, &q, &r);
+                sink -= q.type + r.type;
+            }
+        }
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    if(sink != 0) std::cout << "MISMATCH" << std::endl;
+}
+
+void benchmarkStickyOverflow(){
+    std::vector<rat64_t> values;
+    for(int32_t i = 0; i < 4096; i++) values.push_back(rat64_t(i % 2 ? 37 - i % 97 : i % 101, 1 + i % 9));
+    values[1000] = rat64_t(2000000000, 3); //One block has to be rerun
+    constexpr size_t reps = benchmark_iters/2000;
+    constexpr size_t block_size = 64;
+    std::vector<NumType> results(values.size());
+
+    //p(x) = ((3x - 7/2)x + 5)x - 2/3 by Horner's rule
+    auto horner = [](auto& ctx, const auto& x){
+        using T = std::decay_t<decltype(x)>;
+        return ctx.subtract(ctx.multiply(ctx.add(ctx.multiply(ctx.subtract(ctx.multiply(T(3), x), T(7,2)), x), T(5)), x), T(2,3));
+    };
+
+    std::cout << "Checking every operation: ";
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t r = 0; r < reps; r++){
+        for(size_t i = 0; i < values.size(); i++){
+            const rat64_t x = values[i];
+            rat64_t t;
+            if(rat64_t::multiply(rat64_t(3), x, t) || rat64_t::subtract(t, rat64_t(7,2), t) ||
+               rat64_t::multiply(t, x, t) || rat64_t::add(t, rat64_t(5), t) ||
+               rat64_t::multiply(t, x, t) || rat64_t::subtract(t, rat64_t(2,3), t)){
+                NumTypeContext big;
+                results[i] = horner(big, NumType(x));
+            }else{
+                results[i] = t;
+            }
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+    const NumType checked_sum = std::accumulate(results.begin(), results.end(), NumType(0));
+
+    std::cout << "Sticky overflow blocks: ";
+    std::vector<rat64_t> words(block_size);
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t r = 0; r < reps; r++){
+        for(size_t begin = 0; begin < values.size(); begin += block_size){
+            const size_t end = std::min(begin + block_size, values.size());
+            Rat64Context ctx;
+            for(size_t i = begin; i < end; i++) words[i - begin] = horner(ctx, values[i]);
+            if(ctx.overflow){
+                NumTypeContext big;
+                for(size_t i = begin; i < end; i++) results[i] = horner(big, NumType(values[i]));
+            }else{
+                for(size_t i = begin; i < end; i++) results[i] = words[i - begin];
+            }
+        }
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    if(std::accumulate(results.begin(), results.end(), NumType(0)) != checked_sum) std::cout << "MISMATCH" << std::endl;
+}
+
+void benchmarkDyadic(){
+    std::cout << "Rational halving: ";
+    NumType sink = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < benchmark_iters; i++){
+        NumType t(1,2);
+        for(size_t i = 0; i < 31; i++)
+            t *= NumType(1,2);
+        sink += t;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "Dyadic halving: ";
+    const NumType half = NumType::dyadic(1, 1);
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < benchmark_iters; i++){
+        NumType t = half;
+        for(size_t i = 0; i < 31; i++)
+            t *= half;
+        sink -= t;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    //Doubles are binary fractions, so their sum needs large power of two denominators
+    std::vector<double> inputs;
+    for(int i = 1; i <= 1000; i++) inputs.push_back((i % 7 - 3) / static_cast<double>(1 << (i % 48 % 30)) + i * 0.001);
+    std::vector<NumType> rational_inputs, dyadic_inputs;
+    for(double val : inputs){
+        rational_inputs.push_back(NumType(mpq_class(val)));
+        rational_inputs.back().reduce();
+        dyadic_inputs.push_back(NumType::fromDouble(val));
+    }
+    constexpr size_t reps = benchmark_iters/500;
+
+    std::cout << "Rational sum of doubles: ";
+    NumType rational_sum = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++){
+        NumType sum = 0;
+        for(const NumType& val : rational_inputs) sum += val;
+        rational_sum = std::move(sum);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "Dyadic sum of doubles: ";
+    NumType dyadic_sum = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++){
+        NumType sum = 0;
+        for(const NumType& val : dyadic_inputs) sum += val;
+        dyadic_sum = std::move(sum);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    if(sink != 0 || rational_sum != dyadic_sum) std::cout << "MISMATCH" << std::endl;
+}
+
+void benchmarkDecimal(){
+    //Prices with 9 fractional digits, as read from a feed
+    std::vector<std::string> feed;
+    std::vector<NumType> rational_prices;
+    for(long i = 1; i <= 1000; i++){
+        const long nanos = (i * 1000000007) % 99999999999;
+        feed.push_back(std::to_string(nanos / 1000000000) + '.' + std::to_string(1000000000 + nanos % 1000000000).substr(1));
+        rational_prices.push_back(NumType(mpq_class(nanos, 1000000000ul)));
+        rational_prices.back().reduce();
+    }
+    constexpr size_t reps = benchmark_iters/500;
+
+    std::cout << "Rational sum of prices: ";
+    NumType rational_sum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++){
+        NumType sum = 0;
+        for(const NumType& val : rational_prices) sum += val;
+        rational_sum = std::move(sum);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "Decimal sum of prices: ";
+    std::vector<NumType> decimal_prices;
+    for(const std::string& text : feed) decimal_prices.push_back(NumType::parseDecimal(text));
+    NumType decimal_sum = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++){
+        NumType sum = 0;
+        for(const NumType& val : decimal_prices) sum += val;
+        decimal_sum = std::move(sum);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "Parse and format prices: ";
+    size_t sink = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++)
+        for(const std::string& text : feed) sink += NumType::parseDecimal(text).toDecimalString().size();
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    if(rational_sum != decimal_sum || sink == 0) std::cout << "MISMATCH" << std::endl;
+}
+
+void benchmarkInvariantDivisor(){
+    volatile uint32_t runtime_divisor = 360;
+    const uint32_t d = runtime_divisor;
+    std::vector<rat64_t> values;
+    for(int32_t i = 1; i <= 1000; i++) values.push_back(rat64_t(i % 3 ? i * 7919 : -i, 1 + i % 97));
+    std::vector<rat64_t> quotients(values.size());
+    constexpr size_t reps = benchmark_iters/100;
+
+    std::cout << "rat64_t divide by word: ";
+    int64_t sink = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++){
+        for(size_t j = 0; j < values.size(); j++) rat64_t::divide(values[j], d, quotients[j]);
+        sink += quotients[i % values.size()].num;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "rat64_t divide by invariant divisor: ";
+    const rat64_t::Divisor divisor(d);
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++){
+        rat64_t::divide(values.data(), divisor, quotients.data(), values.size());
+        sink -= quotients[i % values.size()].num;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::vector<NumType> nums(values.begin(), values.end());
+    std::vector<NumType> work;
+    const NumType scalar(static_cast<int32_t>(d));
+    std::cout << "NumType divide by scalar: ";
+    NumType num_sink = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps/10; i++){
+        work = nums;
+        for(NumType& val : work) val /= scalar;
+        num_sink += work[i % work.size()];
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "NumType divide by invariant divisor: ";
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps/10; i++){
+        work = nums;
+        NumType::divide(work, divisor);
+        num_sink -= work[i % work.size()];
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    if(sink != 0 || num_sink != 0) std::cout << "MISMATCH" << std::endl;
+}
+
+void benchmarkSort(){
+    std::vector<NumType> mixed, words;
+    for(long i = 1; i <= 20000; i++){
+        const long k = (i * 7919) % 200001 - 100000;
+        switch(i % 10){
+            case 0: case 1: case 2: mixed.push_back(NumType(static_cast<int32_t>(k))); break;
+            case 3: case 4: case 5: mixed.push_back(NumType(static_cast<int32_t>(k), 1 + i % 97)); break;
+            case 6: mixed.push_back(NumType(mpz_class(mpz_class(k) << 130))); break;
+            case 7: mixed.push_back(NumType(mpq_class(mpz_class(k) << 70, 3 + i % 5))); break;
+            case 8: mixed.push_back(NumType(mpq_class(mpz_class(k) << 8, (mpz_class(1) << 40) + i))); break;
+            default: mixed.push_back(NumType::fromWide(static_cast<WideWord>(k) * (WideWord(1) << 60))); break;
+        }
+        mixed.back().reduce();
+        words.push_back(NumType(static_cast<int32_t>(k), 1 + i % 97));
+        words.back().reduce();
+    }
+    constexpr size_t reps = benchmark_iters/50000;
+    mp_set_memory_functions(countingAllocate, countingReallocate, countingFree);
+    std::vector<NumType> work = mixed;
+    std::sort(work.begin(), work.end()); //Warm up this thread's registers
+
+    std::cout << "Sort mixed tiers: ";
+    gmp_allocations = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++){
+        std::vector<NumType> shuffled = mixed;
+        std::sort(shuffled.begin(), shuffled.end());
+        work.swap(shuffled);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms, " << gmp_allocations << " GMP allocations" << std::endl;
+
+    std::cout << "Sort word tiers: ";
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++){
+        std::vector<NumType> shuffled = words;
+        std::sort(shuffled.begin(), shuffled.end());
+        work.swap(shuffled);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+    mp_set_memory_functions(nullptr, nullptr, nullptr);
+
+    if(!std::is_sorted(work.begin(), work.end())) std::cout << "MISMATCH" << std::endl;
+}
+
+//Scalar broadcasts with the scalar as a NumType, the way `t *= 2` used to convert, and as a primitive
+void benchmarkPrimitiveOperands(){
+    std::vector<NumType> words, bigs;
+    for(int32_t i = 1; i <= 1000; i++){
+        words.push_back(NumType(i % 2 ? i : -i, 1 + i % 7));
+        words.back().reduce();
+        bigs.push_back(NumType(mpz_class((mpz_class(1) << 200) + i)));
+    }
+    constexpr size_t reps = benchmark_iters/500;
+    constexpr int64_t step = int64_t(1) << 40;
+    size_t below = 0;
+
+    auto run = [](const char* label, std::vector<NumType>& values, auto op){
+        std::cout << label;
+        auto start = std::chrono::high_resolution_clock::now();
+        for(size_t r = 0; r < reps; r++)
+            for(NumType& val : values) op(val);
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+        std::cout << duration.count() << "ms" << std::endl;
+    };
+
+    run("Word broadcast, NumType scalar: ", words, [](NumType& val){
+        val *= NumType(3);
+        val += NumType(7);
+        val -= NumType(7);
+        val /= NumType(3);
+    });
+    run("Word broadcast, int scalar: ", words, [](NumType& val){
+        val *= 3;
+        val += 7;
+        val -= 7;
+        val /= 3;
+    });
+    run("Word broadcast, int64_t scalar as NumType: ", words, [](NumType& val){
+        val += NumType::fromWide(step);
+        val -= NumType::fromWide(step);
+    });
+    run("Word broadcast, int64_t scalar: ", words, [](NumType& val){
+        val += step;
+        val -= step;
+    });
+    run("GMP broadcast, NumType scalar: ", bigs, [](NumType& val){
+        val *= NumType(3);
+        val += NumType(7);
+        val -= NumType(7);
+        val /= NumType(3);
+    });
+    run("GMP broadcast, int scalar: ", bigs, [](NumType& val){
+        val *= 3;
+        val += 7;
+        val -= 7;
+        val /= 3;
+    });
+    run("Word compare, NumType scalar: ", words, [&below](NumType& val){ below += val < NumType(1); });
+    run("Word compare, int scalar: ", words, [&below](NumType& val){ below -= val < 1; });
+    run("GMP compare, NumType scalar: ", bigs, [&below](NumType& val){ below += val > NumType(1); });
+    run("GMP compare, int scalar: ", bigs, [&below](NumType& val){ below -= val > 1; });
+
+    if(below != 0) std::cout << "MISMATCH" << std::endl;
+    for(int32_t i = 1; i <= 1000; i++){
+        NumType word(i % 2 ? i : -i, 1 + i % 7);
+        word.reduce();
+        if(words[i-1] != word || bigs[i-1] != NumType(mpz_class((mpz_class(1) << 200) + i))) std::cout << "MISMATCH" << std::endl;
+    }
+}
+
+//Values that grow in a loop, with and without reserving their final size
+void benchmarkGrowth(){
+    mp_set_memory_functions(countingAllocate, countingReallocate, countingFree);
+    NumType sink = 0;
+
+    auto run = [&sink](const char* label, mp_bitcnt_t reserve, auto body){
+        std::cout << label;
+        gmp_allocations = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for(size_t i = 0; i < benchmark_iters/250; i++){
+            NumType t = 1;
+            if(reserve) t.reserve(reserve);
+            body(t);
+            sink += t.type;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+        std::cout << duration.count() << "ms, " << gmp_allocations << " GMP allocations" << std::endl;
+    };
+
+    auto doubling = [](NumType& t){ for(int32_t j = 0; j < 256; j++) t *= 2; };
+    auto product = [](NumType& t){ for(int32_t j = 1; j <= 400; j++) t *= j; };
+    const NumType big = NumType::factorial(300);
+    auto sum = [&big](NumType& t){ for(int32_t j = 1; j <= 400; j++){ t += big; t += t; } };
+
+    run("Growth doubling: ", 0, doubling);
+    run("Growth doubling, reserved: ", 264, doubling);
+    run("Growth product 400!: ", 0, product);
+    run("Growth product 400!, reserved: ", 2900, product);
+    run("Growth doubling sum: ", 0, sum);
+    run("Growth doubling sum, reserved: ", 2500, sum);
+    mp_set_memory_functions(nullptr, nullptr, nullptr);
+
+    if(sink != static_cast<int32_t>(6 * GmpInt * (benchmark_iters/250))) std::cout << "MISMATCH" << std::endl;
+}
+
+void benchmarkFma(){
+    std::vector<NumType> a, b;
+    for(int32_t i = 1; i <= 1000; i++){
+        a.push_back(NumType(i % 3 ? i * 40009 : -i, 1 + i % 7));
+        b.push_back(NumType(i % 5 ? 1 - i * 30011 : i, 1 + i % 11));
+    }
+    for(NumType& val : a) val.reduce();
+    for(NumType& val : b) val.reduce();
+    constexpr size_t reps = benchmark_iters/1000;
+
+    std::cout << "Multiply then add: ";
+    NumType separate = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++){
+        NumType sum = 0;
+        for(size_t j = 0; j < a.size(); j++) sum += a[j] * b[j];
+        separate += sum;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "Dot product: ";
+    NumType fused = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++) fused += NumType::dot(a, b);
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    if(separate != fused) std::cout << "MISMATCH" << std::endl;
+
+    std::cout << "Multiply then add, word operands: ";
+    separate = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++){
+        for(size_t j = 1; j < a.size(); j++) separate += a[j-1] * b[j] + a[j];
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    std::cout << "Fused multiply-add, word operands: ";
+    fused = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < reps; i++){
+        for(size_t j = 1; j < a.size(); j++) fused += NumType::fma(a[j-1], b[j], a[j]);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+    std::cout << duration.count() << "ms" << std::endl;
+
+    if(separate != fused) std::cout << "MISMATCH" << std::endl;
+}
+
 #include <math.h>
 
 int main(){
@@ -143,6 +1088,20 @@ int main(){
     assert( !rat64_t::power( rat64_t({1,2}), 4, ans ) );
     assert( ans == rat64_t({1,16}) );
     assert( rat64_t::power( rat64_t({1,2}), 32, ans ) );
+    assert( rat64_t::power( rat64_t({1,2}), 256, ans ) );
+    assert( !rat64_t::power( rat64_t({-2,3}), 3, ans ) );
+    assert( ans == rat64_t({-8,27}) );
+    assert( !rat64_t::power( rat64_t({-2,3}), 0, ans ) );
+    assert( ans == rat64_t({1,1}) );
+    assert( !rat64_t::power( rat64_t({46340,1}), 2, ans ) );
+    assert( ans == rat64_t({2147395600,1}) );
+    assert( rat64_t::power( rat64_t({46341,1}), 2, ans ) );
+    assert( !rat64_t::power( rat64_t({1,65535}), 2, ans ) );
+    assert( ans == rat64_t({1,4294836225u}) );
+    assert( rat64_t::power( rat64_t({1,65536}), 2, ans ) );
+    assert( rat64_t::power( rat64_t({-2,1}), 31, ans ) );
+    assert( !rat64_t::power( rat64_t({-1,3}), 20, ans ) );
+    assert( ans == rat64_t({1,3486784401u}) );
 
     assert( rat64_t({1,4}) < rat64_t({1,3}) );
     assert( !(rat64_t({1,3}) < rat64_t({1,3})) );
@@ -170,8 +1129,8 @@ int main(){
     assert(t.asWordInt() == 6);
 
     t *= NumType(std::numeric_limits<int32_t>::max());
-    assert(t.type == GmpInt);
-    assert(t.asBigInt() == mpz_class(6)*mpz_class(std::numeric_limits<int32_t>::max()));
+    assert(t.type == WideInt);
+    assert(t.asWide() == 6*static_cast<WideWord>(std::numeric_limits<int32_t>::max()));
 
     t = NumType(1,2);
     t *= t;
@@ -239,10 +1198,95 @@ int main(){
     t = NumType(mpz_class("500000000")) * NumType(-100) + NumType(1)*NumType(mpz_class("-10000000000"));
     assert(t.toString() == "-60000000000");
 
+    NumType big = NumType(mpz_class("123456789012345678901234567890"));
+    NumType copy = big;
+    assert(copy.data == big.data);
+    copy *= 2;
+    assert(copy.data != big.data);
+    assert(big.toString() == "123456789012345678901234567890");
+    assert(copy.toString() == "246913578024691357802469135780");
+    copy = big;
+    copy = copy;
+    assert(copy.data == big.data);
+    assert(copy == big);
+    copy += NumType(1,2);
+    assert(copy.type == GmpRat);
+    assert(big.toString() == "123456789012345678901234567890");
+    assert(copy.toString() == "246913578024691357802469135781/2");
+
+    //Expiring GMP operands are reused as the result's storage
+    NumType expiring = NumType(mpz_class("10000000000000000000000000000000000000000"));
+    [[maybe_unused]] void* buffer = expiring.data;
+    t = std::move(expiring) * NumType(3) + NumType(1);
+    assert(t.data == buffer);
+    assert(t.toString() == "30000000000000000000000000000000000000001");
+    t = NumType(2) * (std::move(t) - NumType(1));
+    assert(t.data == buffer);
+    assert(t.toString() == "60000000000000000000000000000000000000000");
+    t = NumType(1) - std::move(t);
+    assert(t.data == buffer);
+    assert(t.toString() == "-59999999999999999999999999999999999999999");
+    const NumType dividend = NumType(mpz_class("70000000000000000000000000000000000000000"));
+    t = dividend % std::move(t);
+    assert(t.data == buffer);
+    assert(t.toString() == "10000000000000000000000000000000000000001");
+    t = NumType(1,2) / std::move(t);
+    assert(t.toString() == "1/20000000000000000000000000000000000000002");
+    t = NumType(5) / NumType(mpz_class("-10000000000"));
+    assert(t.toString() == "-1/2000000000");
+    t = big + big - big * NumType(2);
+    assert(t.type == WordInt);
+    assert(t.asWordInt() == 0);
+    t = 7 - NumType(mpz_class("10000000000"));
+    assert(t.toString() == "-9999999993");
+
+    //Mixed tier operations work in place on the existing GMP storage
+    t = NumType(mpz_class("100000000000000000000000000000000000000000"));
+    buffer = t.data;
+    t *= NumType(3,4);
+    assert(t.data == buffer);
+    assert(t.toString() == "75000000000000000000000000000000000000000");
+    t *= NumType(-7);
+    t += NumType(1);
+    assert(t.data == buffer);
+    assert(t.toString() == "-524999999999999999999999999999999999999999");
+    t += NumType(1,3);
+    assert(t.type == GmpRat);
+    assert(t.toString() == "-1574999999999999999999999999999999999999996/3");
+    buffer = t.data;
+    t *= NumType(6,7);
+    assert(t.data == buffer);
+    assert(t.toString() == "-3149999999999999999999999999999999999999992/7");
+    t += NumType(mpz_class("449999999999999999999999999999999999999998"));
+    assert(t.type == WordRat);
+    assert(t.asWordRat() == rat64_t({-6,7}));
+    t = NumType(mpz_class("100000000000"));
+    t *= NumType(mpq_class("1/300000000000"));
+    assert(t.type == WordRat);
+    assert(t.asWordRat() == rat64_t({1,3}));
+    t = NumType(mpq_class("1/300000000000")) * NumType(-600000000);
+    assert(t.type == WordRat);
+    assert(t.asWordRat() == rat64_t({-1,500}));
+    t = NumType(405936331,24) + NumType(201790273);
+    assert(t.toString() == "5248902883/24");
+    t = NumType(2) - NumType(-885272,1357146375);
+    assert(t.toString() == "2715178022/1357146375");
+    t = NumType(-5) / NumType(mpq_class("-20000000000/3"));
+    assert(t.toString() == "3/4000000000");
+
     t = NumType(-100);
     assert(std::pow(t,0).toString() == "1");
     assert(std::pow(t,1).toString() == "-100");
     assert(std::pow(t,2).toString() == "10000");
+    assert(std::pow(t,2).type == WordInt);
+    assert(std::pow(NumType(2),30).type == WordInt);
+    assert(std::pow(NumType(2),31).type == WideInt);
+    assert(std::pow(NumType(2),31).toString() == "2147483648");
+    assert(std::pow(NumType(-2),31).toString() == "-2147483648");
+    assert(std::pow(NumType(-3),19).asWordInt() == -1162261467);
+    assert(std::pow(NumType(-3),20).toString() == "3486784401");
+    assert(std::pow(NumType(3,2),40).toString() == "12157665459056928801/1099511627776");
+    assert(std::pow(NumType(-1,2),31).asWordRat() == rat64_t({-1,1u << 31}));
 
     t = NumType::binomialCoeff(5,2);
     assert(t.toString() == "10");
@@ -250,10 +1294,1311 @@ int main(){
     t = NumType::binomialCoeff(4+15-1, 4-1);
     assert(t.toString() == "816");
 
+    t = NumType::binomialCoeff(40, 6);
+    assert(t.type == WordInt);
+    assert(t.asWordInt() == 3838380);
+    t = NumType::binomialCoeff(100, 50);
+    assert(t.toString() == "100891344545564193334812497256");
+    t = std::pow(NumType(mpq_class("-10000000000/3")), 3);
+    assert(t.toString() == "-1000000000000000000000000000000/27");
+    t = std::pow(NumType(-3,7), 13);
+    assert(t.toString() == "-1594323/96889010407");
+
+    assert(NumType(1,3) < NumType(mpz_class("10000000000")));
+    assert(!(NumType(-1,3) < NumType(mpz_class("-10000000000"))));
+    assert(NumType(mpz_class("-10000000000")) < NumType(1,3));
+    assert(NumType(-1,3) < NumType(mpq_class("-1/4000000000")));
+    assert(!(NumType(mpq_class("-1/4000000000")) < NumType(-1,3)));
+    assert(NumType(mpq_class("-10000000000/3")) < NumType(-1,3));
+
+    //Scratch registers nested deeper than the pool fall back to their own storage
+    {
+        const NumType third = NumType(1,3);
+        const NumType huge = NumType(mpq_class("100000000000000000000000000001/7"));
+        NumType::ProductSum outer;
+        outer.add(huge, third);
+        {
+            NumType::ProductSum inner;
+            ScratchInt extra[4];
+            ScratchRat extra_rats[8];
+            for(ScratchInt& z : extra) mpz_set_ui(z.z, 5);
+            inner.add(huge, huge);
+            inner.add(third, huge);
+            assert(inner.result() == NumType(mpq_class(huge.asBigRat()*huge.asBigRat() + huge.asBigRat()/3)));
+            assert(NumType::dot({huge, third}, {third, huge}) == NumType(mpq_class(huge.asBigRat()*2/3)));
+            assert(NumType::fma(huge, huge, third) == NumType(mpq_class(huge.asBigRat()*huge.asBigRat() + mpq_class(1,3))));
+            assert(third < huge && NumType(mpz_class("-100000000000000000000")) < third);
+            for([[maybe_unused]] ScratchInt& z : extra) assert(mpz_cmp_ui(z.z, 5) == 0);
+        }
+        assert(GmpScratch::local().ints_used == 6 && GmpScratch::local().rats_used == 2);
+        assert(outer.result() == NumType(mpq_class(huge.asBigRat()/3)));
+    }
+    assert(GmpScratch::local().ints_used == 0 && GmpScratch::local().rats_used == 0);
+
+    //Exact word bounds for factorials and binomial coefficients
+    assert(NumType::factorial(0).asWordInt() == 1);
+    assert(NumType::factorial(12).asWordInt() == 479001600);
+    assert(NumType::factorial(13).toString() == "6227020800");
+    assert(NumType::factorial(25).toString() == "15511210043330985984000000");
+    assert(NumType(12).factorial().asWordInt() == 479001600);
+    assert(NumType::binomialCoeff(7, 0).asWordInt() == 1);
+    assert(NumType::binomialCoeff(7, 7).asWordInt() == 1);
+    assert(NumType::binomialCoeff(100, 98).asWordInt() == 4950);
+    t = NumType::binomialCoeff(33, 16);
+    assert(t.type == WordInt && t.asWordInt() == 1166803110);
+    assert(NumType::binomialCoeff(34, 17).toString() == "2333606220");
+    t = NumType::binomialCoeff(65536, 2);
+    assert(t.type == WordInt && t.asWordInt() == 2147450880);
+    t = NumType::binomialCoeff(65537, 2);
+    assert(t.type == WideInt && t.toString() == "2147516416");
+    assert(NumType::binomialCoeff(2345, 3).type == WordInt);
+    assert(NumType::binomialCoeff(2346, 3).toString() == "2149201880");
+    assert(NumType::binomialCoeff(4294967295u, 1).toString() == "4294967295");
+    assert(NumType::binomialCoeff(4294967295u, 4294967294u).toString() == "4294967295");
+    for(uint32_t n = 1; n < 130; n++){
+        for(uint32_t k = 0; k <= n; k++){
+            mpz_class expected;
+            mpz_bin_uiui(expected.get_mpz_t(), n, k);
+            t = NumType::binomialCoeff(n, k);
+            [[maybe_unused]] const mp_bitcnt_t bits = mpz_sizeinbase(expected.get_mpz_t(), 2);
+            assert(t.type == (bits < 32 ? WordInt : bits <= 127 ? WideInt : GmpInt));
+            assert(t.toString() == expected.get_str());
+        }
+    }
+
+    //Cached coefficients, both hits and entries walked along a Pascal row
+    assert(NumType::binomialCoeff(200, 100).toString() ==
+           "90548514656103281165404177077484163874504589675413336841320");
+    t = NumType::binomialCoeff(200, 100);
+    assert(t.toString() == "90548514656103281165404177077484163874504589675413336841320");
+    assert(NumType::binomialCoeff(200, 99).toString() ==
+           NumType::binomialCoeff(200, 101).toString());
+    assert(NumType::binomialCoeff(200, 101).toString() ==
+           "89651994709013149668717007007410063242083752153874590932000");
+
+    //Compile time rational arithmetic and literals
+    static_assert("6/8"_q == rat64_t(3, 4));
+    static_assert("-10/4"_q == rat64_t(-5, 2));
+    static_assert("4294967294/2"_q == 2147483647_q);
+    static_assert("-0/5"_q == rat64_t(0));
+    static_assert(std::abs("-1/3"_q) == "1/3"_q);
+    static_assert("1/3"_q < "1/2"_q && "-1/2"_q < "-1/3"_q);
+    static_assert([]{
+        rat64_t ans;
+        return !rat64_t::add("1/6"_q, "1/10"_q, ans) && ans == "4/15"_q;
+    }());
+    static_assert([]{
+        rat64_t ans;
+        return !rat64_t::multiply("2147483647/2"_q, "2"_q, ans) && ans == 2147483647_q;
+    }());
+    static_assert([]{
+        rat64_t ans;
+        return !rat64_t::power("-2/3"_q, 3, ans) && ans == "-8/27"_q;
+    }());
+    static_assert([]{
+        rat64_t ans;
+        return !rat64_t::divide("3/4"_q, "-9/8"_q, ans) && ans == "-2/3"_q && ans.den == 3;
+    }());
+    static_assert([]{
+        rat64_t ans;
+        return !rat64_t::divide("-6/5"_q, 4u, ans) && ans == "-3/10"_q;
+    }());
+    static_assert([]{
+        rat64_t ans;
+        return rat64_t::divide("2147483647/2"_q, "1/3"_q, ans);
+    }());
+    static_assert([]{
+        rat64_t ans;
+        return rat64_t::add(2147483647_q, 1_q, ans); //Overflow is reported, not UB
+    }());
+    static_assert([]{
+        rat64_t ans;
+        return !rat64_t::fma(2147483647_q, 2_q, -2147483647_q, ans) && ans == 2147483647_q; //The product overflows
+    }());
+    static_assert([]{
+        rat64_t ans;
+        return !rat64_t::fma("65536/3"_q, "32768/5"_q, "-1/15"_q, ans) && ans == "2147483647/15"_q &&
+               rat64_t::multiply("65536/3"_q, "32768/5"_q, ans) &&
+               rat64_t::fma("1/65536"_q, "1/65536"_q, "1/3"_q, ans);
+    }());
+    static_assert([]{
+        constexpr rat64_t a[] = {2147483647_q, 2147483647_q, "1/2"_q, "1/3"_q};
+        constexpr rat64_t b[] = {2147483647_q, -2147483647_q, "1/3"_q, "1/2"_q};
+        rat64_t ans;
+        return !rat64_t::dot(a, b, 4, ans) && ans == "1/3"_q;
+    }());
+    static_assert([]{
+        Rat64Context ctx;
+        const rat64_t x = ctx.add(ctx.multiply("1/2"_q, "2/3"_q), "2/3"_q);
+        return !ctx.overflow && x == 1_q;
+    }());
+    static_assert([]{
+        Rat64Context ctx;
+        rat64_t x = ctx.multiply(2147483647_q, 2_q);
+        x = ctx.add(x, 1_q); //Keeps going on the placeholder
+        x = ctx.subtract(x, "1/3"_q);
+        return ctx.overflow && x == "2/3"_q;
+    }());
+    static_assert([]{
+        Rat64Context ctx;
+        const rat64_t x = ctx.divide(1_q, 0_q);
+        const bool zero_divisor = ctx.divide_by_zero && !ctx.overflow && x == 0_q;
+        ctx.clear();
+        ctx.power("1/65536"_q, 2);
+        return zero_divisor && ctx.overflow && !ctx.divide_by_zero;
+    }());
+    static_assert(InvariantDivisor(360).gcd(84) == 12 && InvariantDivisor(360).quotient(4294967295u) == 11930464);
+    static_assert(InvariantDivisor(7).remainder(100) == 2 && InvariantDivisor(7).divides(98) && !InvariantDivisor(7).divides(99));
+    static_assert([]{
+        rat64_t ans;
+        return !rat64_t::divide("9/10"_q, rat64_t::Divisor("-3/4"_q), ans) && ans == "-6/5"_q &&
+               rat64_t::divide("1/65536"_q, rat64_t::Divisor(65537u), ans);
+    }());
+    static_assert(rat64_t::checkedAdd(rat64_t::checkedMultiply("1/2"_q, "2/3"_q), "2/3"_q) == 1_q);
+    static_assert(rat64_t::checkedSubtract("1/6"_q, "1/3"_q) == "-1/6"_q && rat64_t::checkedDivide("3/4"_q, "-9/8"_q) == "-2/3"_q);
+    static_assert(rat64_t::checkedPower("-2/3"_q, 3) == "-8/27"_q);
+    //constexpr rat64_t bad = "2147483648"_q; //Does not compile: out of range
+    //constexpr rat64_t sum = rat64_t::checkedAdd(2147483647_q, 1_q); //Does not compile: overflows
+
+    [[maybe_unused]] constexpr rat64_t coefficient = "-12/9"_q;
+    assert(coefficient.num == -4 && coefficient.den == 3);
+    assert(NumType(coefficient).toString() == "-4/3");
+    for(const char* literal : {"1/0", "1/", "x", "", "3/4/5", "2147483648", "1/4294967296", "99999999999999999999"}){
+        [[maybe_unused]] bool threw = false;
+        try{
+            operator""_q(literal, strlen(literal));
+        }catch(const std::exception&){
+            threw = true;
+        }
+        assert(threw);
+    }
+    const std::function<rat64_t()> overflows[] = {
+        []{ return rat64_t::checkedAdd(2147483647_q, 1_q); },
+        []{ return rat64_t::checkedSubtract(-2147483647_q, 1_q); },
+        []{ return rat64_t::checkedMultiply("65536/3"_q, "32768/5"_q); },
+        []{ return rat64_t::checkedDivide(1_q, 0_q); },
+        []{ return rat64_t::checkedDivide("1/65536"_q, 65537_q); },
+        []{ return rat64_t::checkedPower("1/65536"_q, 2); }};
+    for(const auto& overflow : overflows){
+        [[maybe_unused]] bool threw = false;
+        try{
+            overflow();
+        }catch(const std::exception&){
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    //Tier hints
+    {
+        std::vector<NumType> values = {0, 1, -1, 7, -46341, 65536, max_n, min_n, NumType(1,3), NumType(-2,5),
+                                       NumType(max_n,2), NumType(1,4294967295u), NumType(min_n,4294967293u),
+                                       NumType(mpz_class("-100000000000")), NumType(mpq_class("1/100000000000"))};
+        checkTierHints<WordInt, WordInt>(values);
+        checkTierHints<WordInt, WordRat>(values);
+        checkTierHints<WordRat, WordInt>(values);
+        checkTierHints<WordRat, WordRat>(values);
+    }
+    {
+        rat64_t ans;
+        assert(!rat64_t::subtract(rat64_t(1,2), rat64_t(1,3), ans) && ans == rat64_t(1,6));
+    }
+
+    //Multi-modular evaluation
+    assert(Montgomery64::isPrime(1000000007));
+    assert(!Montgomery64::isPrime(561));
+    assert(!Montgomery64::isPrime(3215031751u)); //Strong pseudoprime to bases 2, 3, 5 and 7
+    assert(Montgomery64::isPrime((uint64_t(1) << 61) - 1));
+    assert(!Montgomery64::isPrime(uint64_t(1000000007) * 998244353));
+    {
+        Montgomery64 field(Montgomery64::primeBelow(uint64_t(1) << 62));
+        [[maybe_unused]] uint64_t a = field.toMont(int64_t(-5));
+        [[maybe_unused]] uint64_t b = field.toMont(uint64_t(7));
+        assert(field.fromMont(field.mul(a, b)) == field.p - 35);
+        assert(field.fromMont(field.mul(b, field.inverse(b))) == 1);
+    }
+
+    t = determinant({2, -3, 1, 2, 0, -1, 1, 4, 5}, 3);
+    assert(t.type == WordInt && t.asWordInt() == 49);
+    t = determinant({1, 2, 3, 4, 5, 6, 7, 8, 9}, 3);
+    assert(t.type == WordInt && t.asWordInt() == 0);
+    t = determinant({NumType(mpz_class("1000000000000000")), 3, 7, NumType(mpz_class("-999999999999999"))}, 2);
+    assert(t.toString() == "-999999999999999000000000000021");
+    {
+        constexpr size_t n = 8;
+        std::vector<NumType> hilbert;
+        for(size_t i = 0; i < n; i++)
+            for(size_t j = 0; j < n; j++)
+                hilbert.push_back(NumType(1, i+j+1));
+        assert(determinant(hilbert, n).toString() == "1/365356847125734485878112256000000");
+    }
+    for(uint32_t seed = 1; seed < 6; seed++){
+        std::vector<NumType> m = testMatrix(6 + seed, seed);
+        MultiModularOptions options;
+        options.threads = 3;
+        assert(determinant(m, 6 + seed, options).toString() == mpqDeterminant(toMpq(m), 6 + seed).get_str());
+    }
+    t = multiModularEvaluate([](const Montgomery64& field, uint64_t& residue){
+        //The harmonic number H_30
+        uint64_t sum = 0;
+        for(uint64_t i = 1; i <= 30; i++) sum = field.add(sum, field.inverse(field.toMont(i)));
+        residue = field.fromMont(sum);
+        return true;
+    });
+    {
+        mpq_class harmonic = 0;
+        for(int i = 1; i <= 30; i++) harmonic += mpq_class(1, i);
+        assert(t.toString() == harmonic.get_str());
+    }
+    {
+        //A round of only unlucky primes must not confirm the first, wrong, candidate for 2^100 + 7
+        std::atomic<int> calls(0);
+        MultiModularOptions options;
+        options.threads = 1;
+        options.primes_per_round = 1;
+        options.integer_result = true;
+        t = multiModularEvaluate([&calls](const Montgomery64& field, uint64_t& residue){
+            if(calls++ == 1) return false;
+            residue = field.fromMont(field.add(field.pow(field.toMont(uint64_t(2)), 100), field.toMont(uint64_t(7))));
+            return true;
+        }, options);
+        assert(t == NumType(mpz_class((mpz_class(1) << 100) + 7)));
+
+        //Running out of primes, or never finding a lucky one, is reported rather than guessed
+        options.threads = 2;
+        options.primes_per_round = 4;
+        options.max_primes = 16;
+        for(bool lucky : {true, false}){
+            [[maybe_unused]] bool thrown = false;
+            try{
+                multiModularEvaluate([lucky](const Montgomery64& field, uint64_t& residue){
+                    residue = (field.p >> 7) % field.p;
+                    return lucky;
+                }, options);
+            }catch(const std::runtime_error&){
+                thrown = true;
+            }
+            assert(thrown);
+        }
+    }
+
+    //Two-limb integers between the word and GMP tiers
+    auto reduced = [](const mpz_class& val){
+        NumType num(val);
+        num.reduce();
+        return num;
+    };
+    t = NumType(max_n) + NumType(1);
+    assert(t.type == WideInt && t.toString() == "2147483648");
+    t -= NumType(1);
+    assert(t.type == WordInt && t.asWordInt() == max_n);
+    t = NumType(min_n) - NumType(1);
+    assert(t.type == WideInt && t.toString() == "-2147483648");
+    assert(-t == reduced(mpz_class("2147483648")));
+    t = std::pow(NumType(2), 126);
+    assert(t.type == WideInt);
+    t += t - NumType(1);
+    assert(t.type == WideInt && t == reduced((mpz_class(1) << 127) - 1));
+    t += NumType(1);
+    assert(t.type == GmpInt && t.toString() == mpz_class(mpz_class(1) << 127).get_str());
+    t -= NumType(1);
+    assert(t.type == WideInt);
+    t = -t - NumType(1);
+    assert(t.type == GmpInt && t.toString() == "-" + mpz_class(mpz_class(1) << 127).get_str());
+    t = std::pow(NumType(3), 80) * std::pow(NumType(-3), 1);
+    assert(t.type == GmpInt);
+    t = t / NumType(mpz_class("147808829414345923316083210206383297601"));
+    assert(t.type == WordInt && t.asWordInt() == -3);
+    {
+        NumType a = reduced(mpz_class("100000000000000000000"));
+        NumType b = a;
+        assert(a.type == WideInt && b.data != a.data);
+        b *= NumType(3,7);
+        assert(b.type == GmpRat && b.toString() == "300000000000000000000/7");
+        assert(a.toString() == "100000000000000000000");
+        b = a;
+        b += NumType(mpq_class("1/3"));
+        assert(b.toString() == "300000000000000000001/3");
+        b = reduced(mpz_class("-5000000000"));
+        [[maybe_unused]] void* block = b.data;
+        b = a;
+        assert(b.data == block && b == a);
+        assert(reduced(mpz_class("5000000000")) < a && -a < NumType(1));
+        assert(a > 0 && !(a < 0) && NumType(min_n) < min_n + 1);
+        b = a.reciprocal();
+        assert(b.type == GmpRat && b.toString() == "1/100000000000000000000");
+        //Reciprocals of unit numerators land in the canonical integer tier, whatever the sign
+        for(int32_t sign : {1, -1}){
+            assert(NumType(sign).reciprocal().type == WordInt && NumType(sign).reciprocal() == sign);
+            for(uint32_t den : {2u, 7u, 2147483647u, 4294967295u}){
+                const NumType recip = NumType(sign, den).reciprocal();
+                NumType expected(mpq_class(mpz_class(sign) * den));
+                expected.reduce();
+                assert(recip.type == expected.type && recip == expected);
+            }
+        }
+        b = a % NumType(7);
+        assert(b.type == WordInt && b.asWordInt() == 2);
+        b = a / reduced(mpz_class("-50000000000"));
+        assert(b.type == WordInt && b.asWordInt() == -2000000000);
+        b = a / NumType(3);
+        assert(b.type == GmpRat && b.toString() == "100000000000000000000/3");
+        b = reduced(mpz_class("10000000000")) * reduced(mpz_class("10000000000"));
+        assert(b.type == WideInt && b == a);
+        assert(std::abs(-a) == a);
+    }
+    for(int32_t z = 12; z <= 36; z++){
+        mpz_class expected;
+        mpz_fac_ui(expected.get_mpz_t(), z);
+        t = NumType::factorial(z);
+        assert(t.toString() == expected.get_str());
+        assert(t.type == (z <= 12 ? WordInt : z <= 33 ? WideInt : GmpInt));
+    }
+
+    //Columnar vectors
+    {
+        std::vector<NumType> a = testColumn(300, 11, 9);
+        std::vector<NumType> b = testColumn(300, 12, 13);
+        a[5] = max_n;
+        b[5] = max_n;
+        a.push_back(NumType(mpq_class("1/100000000000")));
+        a.back().reduce();
+        b.push_back(NumType(-1,2));
+        NumVector va(a);
+        NumVector vb(b);
+        assert(va.size() == 301 && va.chunks.size() == 5);
+        assert(va.toVector() == a && vb.toVector() == b);
+        NumVector ints(testColumn(200, 5, 0));
+        for(size_t c = 0; c < ints.chunks.size(); c++) assert(ints.isIntegerChunk(c));
+        assert(!va.isWordChunk(0));
+
+        va += vb;
+        for(size_t i = 0; i < a.size(); i++) a[i] += b[i];
+        assert(va.toVector() == a);
+        va *= vb;
+        for(size_t i = 0; i < a.size(); i++) a[i] *= b[i];
+        assert(va.toVector() == a);
+        va -= va;
+        for(NumType& val : a) val = 0;
+        assert(va.toVector() == a && va.free_slots.size() == va.arena.size());
+        for(size_t c = 0; c < va.chunks.size(); c++) assert(va.isIntegerChunk(c));
+
+        std::vector<NumType> c = testColumn(200, 5, 0);
+        ints *= NumType(max_n);
+        for(NumType& val : c) val *= NumType(max_n);
+        assert(ints.toVector() == c);
+        ints += NumType(2,3);
+        for(NumType& val : c) val += NumType(2,3);
+        assert(ints.toVector() == c);
+        ints -= NumType(mpz_class("-99999999999999999999999"));
+        for(NumType& val : c) val -= NumType(mpz_class("-99999999999999999999999"));
+        assert(ints.toVector() == c);
+
+        NumVector mixed(testColumn(250, 3, 7));
+        std::vector<NumType> d = mixed.toVector();
+        NumType total;
+        for(const NumType& val : d) total += val;
+        assert(mixed.sum() == total);
+        NumVector wide(std::vector<NumType>(130, NumType(max_n)));
+        assert(wide.sum().type == WideInt && wide.sum().toString() == "279172874110");
+        for(const NumType& bound : {NumType(0), NumType(-3,7), NumType(10000), d[6], d[13]}){
+            std::vector<uint8_t> mask = mixed.lessThan(bound);
+            size_t count = 0;
+            for(size_t i = 0; i < d.size(); i++){
+                assert(mask[i] == (d[i] < bound));
+                count += mask[i];
+            }
+            assert(mixed.countLessThan(bound) == count);
+        }
+
+        NumVector slots;
+        slots.push_back(NumType(mpz_class(mpz_class(1) << 200)));
+        slots.push_back(NumType(1,3));
+        assert(slots.isArena(0) && slots.chunks[0].big == 1 && slots.chunks[0].rat == 1);
+        slots.set(0, 5);
+        slots.set(1, NumType(mpq_class(mpz_class(1) << 100, 3)));
+        assert(slots.arena.size() == 1 && slots.free_slots.empty() && slots.isArena(1));
+        assert(slots.chunks[0].big == 1 && slots.chunks[0].rat == 0);
+        assert(slots[0] == NumType(5) && slots.get(1).type == GmpRat);
+    }
+
+    //Equality and hashing of unreduced values
+    {
+        NumType third(mpq_class("1/3"));
+        third.operator*=<false>(NumType(3));
+        assert(third.type == GmpRat && third == NumType(1) && NumType(1) == third);
+        assert(NumType(mpz_class(5)) == NumType(5) && NumType(mpz_class(5)) != NumType(6));
+        assert(NumType(2,4) == NumType(1,2) && NumType(4,2) == NumType(2) && NumType(2,4) != NumType(1,3));
+        assert(NumType(mpz_class("5000000000")) == reduced(mpz_class("5000000000")));
+        std::unordered_set<NumType> set = {NumType(5), NumType(mpz_class(5)), NumType(10,2), NumType(mpq_class("5"))};
+        assert(set.size() == 1);
+        set.insert(NumType(mpz_class("5000000000")));
+        set.insert(reduced(mpz_class("5000000000")));
+        set.insert(NumType(mpq_class(mpz_class(1) << 200, 3)));
+        set.insert(NumType(mpq_class(mpz_class(1) << 200, 3)) * NumType(1));
+        set.insert(NumType(mpz_class(mpz_class(1) << 200)));
+        set.insert(NumType(2,6));
+        set.insert(NumType(mpq_class("1/3")));
+        assert(set.size() == 5);
+        assert(std::hash<NumType>()(third) == std::hash<NumType>()(NumType(1)));
+    }
+
+    //Deferred canonicalization
+    {
+        LazyNum telescope = 1;
+        for(int32_t i = 1; i <= 200; i++) telescope *= LazyNum(NumType(i, i+1));
+        assert(!telescope.isBig() && telescope.toNumType() == NumType(1,201));
+        assert(telescope == LazyNum(NumType(2,402)) && telescope < LazyNum(NumType(1,200)));
+
+        LazyNum lazy = 1;
+        mpq_class expected = 1;
+        uint32_t seed = 7;
+        for(int step = 0; step < 2000; step++){
+            seed = seed * 1103515245u + 12345u;
+            const int32_t n = static_cast<int32_t>(seed >> 16) % 2000 - 1000;
+            const uint32_t d = (seed >> 4) % 999 + 1;
+            NumType operand(n, d);
+            operand.reduce();
+            const mpq_class q_operand(operand.toString());
+            switch((seed >> 12) % 4){
+                case 0: lazy *= operand; expected *= q_operand; break;
+                case 1: if(n != 0){ lazy /= operand; expected /= q_operand; } break;
+                case 2: lazy += operand; expected += q_operand; break;
+                case 3: lazy -= operand; expected -= q_operand; break;
+            }
+            if(expected == 0){
+                lazy = 1;
+                expected = 1;
+            }
+            if(step % 97 == 0){
+                NumType canonical = lazy.toNumType();
+                assert(canonical.toString() == expected.get_str());
+                assert(std::hash<LazyNum>()(lazy) == std::hash<NumType>()(canonical));
+                assert(lazy == LazyNum(canonical));
+            }
+        }
+        assert(lazy.toString() == expected.get_str());
+
+        LazyNum big = LazyNum(NumType(mpz_class(mpz_class(1) << 100)));
+        assert(big.isBig());
+        big /= LazyNum(NumType(mpz_class(mpz_class(1) << 99)));
+        big.normalize();
+        assert(!big.isBig() && big == 2 && big.toNumType().type == WordInt);
+        big = LazyNum(std::numeric_limits<int32_t>::max());
+        big *= big;
+        assert(!big.isBig() && big.toNumType().type == WideInt);
+        big *= big;
+        assert(big.isBig() && big.toNumType() == std::pow(NumType(std::numeric_limits<int32_t>::max()), 4));
+        assert(-big < big && big.reciprocal() < 1 && (big - big) == 0);
+    }
+
+    //Direct division of every tier pair
+    {
+        std::vector<NumType> values = {0, 1, -7, max_n, min_n, NumType(3,4), NumType(-5,6), NumType(max_n,2),
+                                       NumType(1,4294967295u), NumType(max_n) * NumType(-6),
+                                       std::pow(NumType(3),70), std::pow(NumType(-2),120) + NumType(1),
+                                       NumType(mpz_class("-123456789012345678901234567890123456789012345")),
+                                       NumType(mpz_class(mpz_class(1) << 200)),
+                                       NumType(mpq_class("7/123456789012345678901234567890")),
+                                       NumType(mpq_class("-123456789012345678901234567890123456789/9")),
+                                       NumType(mpq_class(mpz_class(3) << 150, mpz_class(5) << 10))};
+        for(NumType& val : values) val.reduce();
+        for(const NumType& lhs : values){
+            for(const NumType& rhs : values){
+                if(rhs == 0) continue;
+                NumType expected(mpq_class(mpq_class(lhs.toString()) / mpq_class(rhs.toString())));
+                expected.reduce();
+                const NumType ans = lhs / rhs;
+                assert(ans.type == expected.type && ans == expected);
+                NumType lazy = lhs;
+                lazy.operator/=<false>(rhs);
+                assert(lazy == expected);
+                NumType self = rhs;
+                self /= self;
+                assert(self.type == WordInt && self.asWordInt() == 1);
+            }
+        }
+    }
+
+    //Rounded division and remainders
+    {
+        std::vector<NumType> values = {0, 1, -1, 2, -7, 12, max_n, min_n, NumType(3,2), NumType(-5,2), NumType(7,6),
+                                       NumType(-max_n,4294967295u), NumType(max_n) * NumType(-6), std::pow(NumType(3),70),
+                                       NumType(mpz_class("-123456789012345678901234567890123456789012345")),
+                                       NumType(mpq_class("7/123456789012345678901234567890")),
+                                       NumType(mpq_class("-123456789012345678901234567890123456789/2")),
+                                       NumType(mpq_class(mpz_class(3) << 150, mpz_class(5) << 10))};
+        for(NumType& val : values) val.reduce();
+        auto canonical = [](const mpq_class& q){
+            NumType ans(q);
+            ans.reduce();
+            return ans;
+        };
+        for(const NumType& lhs : values){
+            const mpq_class a(lhs.toString());
+            mpz_class expected;
+            mpz_fdiv_q(expected.get_mpz_t(), a.get_num_mpz_t(), a.get_den_mpz_t());
+            assert(lhs.floor() == canonical(expected) && lhs.floor().type == canonical(expected).type);
+            mpz_cdiv_q(expected.get_mpz_t(), a.get_num_mpz_t(), a.get_den_mpz_t());
+            assert(lhs.ceil() == canonical(expected));
+            mpz_tdiv_q(expected.get_mpz_t(), a.get_num_mpz_t(), a.get_den_mpz_t());
+            assert(lhs.trunc() == canonical(expected));
+            mpz_class twice = 2*a.get_num();
+            mpz_class nearest;
+            mpz_fdiv_q(nearest.get_mpz_t(), mpz_class(twice + a.get_den()).get_mpz_t(), mpz_class(2*a.get_den()).get_mpz_t());
+            if(a.get_den() == 2 && mpz_odd_p(nearest.get_mpz_t())) nearest -= 1;
+            assert(lhs.round() == canonical(nearest));
+
+            for(const NumType& rhs : values){
+                if(rhs == 0) continue;
+                const mpq_class b(rhs.toString());
+                const mpq_class ratio = a / b;
+                mpz_class floor_q;
+                mpz_fdiv_q(floor_q.get_mpz_t(), ratio.get_num_mpz_t(), ratio.get_den_mpz_t());
+                NumType q, r;
+                lhs.divmod(rhs, q, r);
+                assert(q == canonical(floor_q) && q.type == canonical(floor_q).type);
+                const NumType expected_r = canonical(a - floor_q*b);
+                assert(r == expected_r && r.type == expected_r.type);
+                mpz_class trunc_q;
+                mpz_tdiv_q(trunc_q.get_mpz_t(), ratio.get_num_mpz_t(), ratio.get_den_mpz_t());
+                const NumType rem = lhs % rhs;
+                assert(rem == canonical(a - trunc_q*b) && rem.type == canonical(a - trunc_q*b).type);
+            }
+        }
+        NumType q = 7, r = 0;
+        q.divmod(NumType(-2), q, r);
+        assert(q == -4 && r == -1);
+        assert(NumType(5,2).round() == 2 && NumType(-5,2).round() == -2 && NumType(7,2).round() == 4);
+        assert(NumType(-7,2).floor() == -4 && NumType(-7,2).ceil() == -3 && NumType(-7,2).trunc() == -3);
+        t = NumType(mpq_class("-3/2"));
+        assert(t.round() == -2 && t.floor().type == WordInt);
+    }
+
+    //Sticky overflow blocks rerun on NumType
+    {
+        auto block = [](auto& ctx, const auto& x){
+            using T = std::decay_t<decltype(x)>;
+            const auto square = ctx.multiply(x, x);
+            return ctx.fma(ctx.power(x, 3), T(2), ctx.divide(T(1), ctx.subtract(square, T(5,4))));
+        };
+        std::vector<rat64_t> values;
+        for(int32_t i = -300; i <= 300; i++) values.push_back(rat64_t(i % 100 ? i : i * 7919, 2 + (i+300) % 13));
+        constexpr size_t block_size = 16;
+        size_t reruns = 0;
+        for(size_t begin = 0; begin < values.size(); begin += block_size){
+            const size_t end = std::min(begin + block_size, values.size());
+            Rat64Context ctx;
+            std::vector<NumType> results;
+            for(size_t i = begin; i < end; i++) results.push_back(block(ctx, values[i]));
+            if(ctx.overflow){
+                reruns++;
+                NumTypeContext big;
+                for(size_t i = begin; i < end; i++) results[i - begin] = block(big, NumType(values[i]));
+            }
+            for(size_t i = begin; i < end; i++){
+                const NumType x(values[i]);
+                const NumType expected = x*x*x*2 + NumType(1) / (x*x - NumType(5,4));
+                assert(results[i - begin] == expected);
+            }
+        }
+        assert(reruns > 0 && reruns < (values.size() + block_size - 1) / block_size);
+
+        [[maybe_unused]] bool threw = false;
+        try{
+            NumTypeContext big;
+            big.divide(NumType(1), NumType(0));
+        }catch(const std::domain_error&){
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    //Dyadic tier
+    {
+        const NumType half = NumType::dyadic(1, 1);
+        assert(half.type == Dyadic && half == NumType(1,2) && half.toString() == "1/2");
+        assert(NumType::dyadic(12, 3).type == Dyadic && NumType::dyadic(12, 3).dyadicMantissa() == 3);
+        assert(NumType::dyadic(12, 3).dyadicExponent() == 1 && NumType::dyadic(-8, 3) == -1);
+        assert(NumType::dyadic(-8, 3).type == WordInt && NumType::dyadic(0, 9).type == WordInt);
+        assert(NumType::fromDouble(-0.375).type == Dyadic && NumType::fromDouble(-0.375) == NumType(-3,8));
+        assert(NumType::fromDouble(1e300) == NumType(mpz_class(1e300)) && NumType::fromDouble(1e300).type == GmpInt);
+        assert(NumType::fromDouble(5e-324).type == GmpRat);
+        assert(NumType::fromDouble(5e-324) == NumType(mpq_class(mpz_class(1), mpz_class(1) << 1074)));
+        assert(NumType::fromDouble(0.1) == NumType(mpq_class(0.1)) && NumType::fromDouble(-3.0).type == WordInt);
+        for([[maybe_unused]] double val : {-0.375, 1e300, 5e-324, 0.1, -3.0, 1e30, 123.456})
+            assert(NumType::fromDouble(val).toDouble() == val);
+        assert(NumType(-3, 8).toDouble() == -0.375 && NumType::decimal(-12345, 2).toDouble() == -123.45);
+
+        //Halving keeps the exponent past the WordRat denominator limit, up to 2^-255
+        NumType t = half;
+        mpq_class expected = mpq_class(1, 2);
+        for(int i = 0; i < 300; i++){
+            t *= half;
+            expected /= 2;
+            assert(t == NumType(expected));
+            assert(t.type == (i < 254 ? Dyadic : GmpRat));
+        }
+        t = 0;
+        expected = 0;
+        for(uint32_t i = 1; i < 80; i++){
+            t += NumType::dyadic(i % 3 ? 1 : -1, i);
+            expected += mpq_class(i % 3 ? 1 : -1, mpz_class(1) << i);
+            assert(t == NumType(expected));
+            assert(t.type == (i < 56 ? Dyadic : GmpRat));
+        }
+        t = NumType(std::numeric_limits<int32_t>::max()) * NumType::dyadic(3, 1);
+        assert(t.type == Dyadic && t == NumType(mpq_class(3*int64_t(std::numeric_limits<int32_t>::max()), 2)));
+        t /= NumType::dyadic(3, 7);
+        assert(t.type == WideInt && t == NumType(std::numeric_limits<int32_t>::max()) * NumType(64));
+        assert(std::pow(NumType::dyadic(-3, 2), 5) == NumType(-243,1024) && std::pow(NumType::dyadic(-3, 2), 5).type == Dyadic);
+        assert(std::pow(NumType::dyadic(1, 200), 2) == NumType(mpq_class(mpz_class(1), mpz_class(1) << 400)));
+
+        std::vector<NumType> values = {0, 7, -1, max_n, NumType(3,4), NumType(-1,3), half, NumType::dyadic(-3, 4),
+                                       NumType::dyadic(12345, 40), NumType::dyadic(-((int64_t(1) << 55) - 1), 255),
+                                       NumType::fromDouble(3.141592653589793), std::pow(NumType(3),70),
+                                       NumType(mpz_class("-123456789012345678901234567890123456789012345")),
+                                       NumType(mpq_class("7/123456789012345678901234567890"))};
+        for(NumType& val : values) val.reduce();
+        [[maybe_unused]] auto canonical = [](const mpq_class& q){
+            NumType ans(q);
+            ans.reduce();
+            return ans;
+        };
+        [[maybe_unused]] auto normalized = [](const NumType& val){
+            return val.type != Dyadic || (val.dyadicMantissa() % 2 != 0 && val.dyadicExponent() >= 1);
+        };
+        for(const NumType& lhs : values){
+            const mpq_class a(lhs.toString());
+            assert(lhs.hash() == canonical(a).hash());
+            mpz_class floor_a;
+            mpz_fdiv_q(floor_a.get_mpz_t(), a.get_num_mpz_t(), a.get_den_mpz_t());
+            assert(lhs.floor() == canonical(floor_a) && lhs.ceil() == -canonical(-a).floor());
+            if(a != 0) assert(lhs.reciprocal() == canonical(1/a) && normalized(lhs.reciprocal()));
+            assert(-lhs == canonical(-a) && std::abs(lhs) == canonical(abs(a)));
+            for(const NumType& rhs : values){
+                const mpq_class b(rhs.toString());
+                assert((lhs < rhs) == (a < b) && (lhs == rhs) == (a == b));
+                const NumType sum = lhs + rhs;
+                const NumType difference = lhs - rhs;
+                const NumType product = lhs * rhs;
+                assert(sum == canonical(a + b) && normalized(sum));
+                assert(difference == canonical(a - b) && normalized(difference));
+                assert(product == canonical(a * b) && normalized(product));
+                if(b == 0) continue;
+                const NumType quotient = lhs / rhs;
+                assert(quotient == canonical(a / b) && normalized(quotient));
+                mpz_class trunc_q;
+                mpz_tdiv_q(trunc_q.get_mpz_t(), mpq_class(a / b).get_num_mpz_t(), mpq_class(a / b).get_den_mpz_t());
+                assert(lhs % rhs == canonical(a - trunc_q*b));
+            }
+        }
+    }
+
+    //Decimal tier
+    {
+        const NumType cents = NumType::decimal(1, 2);
+        assert(cents.type == Decimal && cents == NumType(1,100) && cents.toString() == "1/100");
+        assert(NumType::decimal(1250, 3).type == Decimal && NumType::decimal(1250, 3).decimalMantissa() == 125);
+        assert(NumType::decimal(1250, 3).decimalScale() == 2 && NumType::decimal(5, 1).toString() == "1/2");
+        assert(NumType::decimal(-3000, 3).type == WordInt && NumType::decimal(-3000, 3) == -3);
+        assert(NumType::decimal(0, 9).type == WordInt && NumType::decimal(7, 0).type == WordInt);
+
+        assert(NumType::parseDecimal("123.45").type == Decimal && NumType::parseDecimal("123.45") == NumType(2469,20));
+        assert(NumType::parseDecimal("-0.000000001") == NumType(-1,1000000000));
+        assert(NumType::parseDecimal("42") == 42 && NumType::parseDecimal("-42.000").type == WordInt);
+        assert(NumType::parseDecimal(".5") == NumType(1,2) && NumType::parseDecimal("5.") == 5);
+        assert(NumType::parseDecimal("170141183460469231731687303715884105727") == NumType::fromWide(~(static_cast<WideWord>(1) << 127)));
+        assert(NumType::parseDecimal("123456789012345678901234567890123456789.5") ==
+               NumType(mpq_class("246913578024691357802469135780246913579/2")));
+        assert(NumType::parseDecimal("0.0000000000000000000000000000000000000007") ==
+               NumType(mpq_class(mpz_class(7), mpz_class("10000000000000000000000000000000000000000"))));
+        for(const char* text : {"", "-", ".", "1.2.3", "1e5", "+1", "12a"}){
+            [[maybe_unused]] bool threw = false;
+            try{ NumType::parseDecimal(text); }
+            catch(const std::invalid_argument&){ threw = true; }
+            assert(threw);
+        }
+
+        assert(NumType::parseDecimal("-0.05").toDecimalString() == "-0.05");
+        assert(NumType::parseDecimal("1234567.890123456").toDecimalString() == "1234567.890123456");
+        assert(NumType(3,8).toDecimalString() == "0.375" && NumType(-7).toDecimalString() == "-7");
+        assert(NumType::dyadic(1, 18).toDecimalString() == "0.000003814697265625");
+        assert(NumType(1,3).toDecimalString() == "1/3");
+
+        //Prices at the same scale sum as plain integers
+        NumType t = 0;
+        mpq_class expected = 0;
+        for(int64_t i = 1; i <= 1000; i++){
+            t += NumType::decimal(i * 1000000007 % 999999999, 9);
+            expected += mpq_class(i * 1000000007 % 999999999, 1000000000);
+            assert(t == NumType(expected));
+            assert(t.type == Decimal || t.type == WordInt);
+        }
+        t = NumType::decimal(12345, 2);
+        t *= NumType(1,4);
+        assert(t.type == Decimal && t == NumType(12345,400));
+        t /= NumType(-50);
+        assert(t.type == Decimal && t == NumType(-12345,20000));
+        t /= NumType::decimal(-12345, 9);
+        assert(t.type == WordInt && t == 50000);
+        assert(std::pow(NumType::decimal(-15, 1), 3) == NumType(-3375,1000) && std::pow(NumType::decimal(-15, 1), 3).type == Decimal);
+        mpz_class eleven_pow, ten_pow;
+        mpz_ui_pow_ui(eleven_pow.get_mpz_t(), 11, 40);
+        mpz_ui_pow_ui(ten_pow.get_mpz_t(), 10, 40);
+        assert(std::pow(NumType::decimal(11, 1), 40) == NumType(mpq_class(eleven_pow, ten_pow)));
+
+        std::vector<NumType> values = {0, 7, -1, max_n, NumType(3,4), NumType(-1,3), NumType(1,4096), cents,
+                                       NumType::decimal(-3, 4), NumType::decimal(123456789, 9), NumType::decimal(-((int64_t(1) << 58) - 1), 18),
+                                       NumType::dyadic(3, 5), NumType::dyadic(-1, 40), std::pow(NumType(3),70),
+                                       NumType(mpz_class("-123456789012345678901234567890123456789012345")),
+                                       NumType(mpq_class("7/123456789012345678901234567890"))};
+        for(NumType& val : values) val.reduce();
+        [[maybe_unused]] auto canonical = [](const mpq_class& q){
+            NumType ans(q);
+            ans.reduce();
+            return ans;
+        };
+        [[maybe_unused]] auto normalized = [](const NumType& val){
+            return val.type != Decimal || (val.decimalMantissa() % 10 != 0 && val.decimalScale() >= 1);
+        };
+        for(const NumType& lhs : values){
+            const mpq_class a(lhs.toString());
+            assert(lhs.hash() == canonical(a).hash());
+            mpz_class floor_a;
+            mpz_fdiv_q(floor_a.get_mpz_t(), a.get_num_mpz_t(), a.get_den_mpz_t());
+            assert(lhs.floor() == canonical(floor_a) && lhs.ceil() == -canonical(-a).floor());
+            if(a != 0) assert(lhs.reciprocal() == canonical(1/a));
+            assert(-lhs == canonical(-a) && std::abs(lhs) == canonical(abs(a)));
+            for(const NumType& rhs : values){
+                const mpq_class b(rhs.toString());
+                assert((lhs < rhs) == (a < b) && (lhs == rhs) == (a == b));
+                const NumType sum = lhs + rhs;
+                const NumType difference = lhs - rhs;
+                const NumType product = lhs * rhs;
+                assert(sum == canonical(a + b) && normalized(sum));
+                assert(difference == canonical(a - b) && normalized(difference));
+                assert(product == canonical(a * b) && normalized(product));
+                if(b == 0) continue;
+                const NumType quotient = lhs / rhs;
+                assert(quotient == canonical(a / b) && normalized(quotient));
+                mpz_class trunc_q;
+                mpz_tdiv_q(trunc_q.get_mpz_t(), mpq_class(a / b).get_num_mpz_t(), mpq_class(a / b).get_den_mpz_t());
+                assert(lhs % rhs == canonical(a - trunc_q*b));
+            }
+        }
+    }
+
+    //Invariant divisors
+    {
+        const uint32_t divisors[] = {1, 2, 3, 7, 10, 12, 360, 65536, 65537, 2147483648u, 3234846615u, 4294967291u, 4294967295u};
+        std::vector<uint32_t> numerators = {0, 1, 2, 3, 12, 360, 65535, 65536, 2147483647u, 2147483648u, 4294967295u};
+        for(uint32_t i = 0; i < 2000; i++) numerators.push_back(i * 2654435761u);
+        for(uint32_t d : divisors){
+            const InvariantDivisor divisor(d);
+            for(uint32_t n : numerators){
+                assert(divisor.quotient(n) == n / d && divisor.remainder(n) == n % d);
+                assert(divisor.divides(n) == (n % d == 0) && divisor.gcd(n) == std::gcd(n, d));
+                uint32_t reduced = n;
+                uint32_t cofactor = 0;
+                [[maybe_unused]] const uint32_t gcd = divisor.cancel(reduced, cofactor);
+                assert(gcd == std::gcd(n, d) && reduced == n / gcd && cofactor == d / gcd);
+            }
+        }
+
+        std::vector<rat64_t> values;
+        for(int32_t i = -500; i <= 500; i++) values.push_back(rat64_t(i * 4099, 1 + (i + 500) % 720));
+        values.push_back(rat64_t(std::numeric_limits<int32_t>::max(), 4294967295u));
+        for(const rat64_t& rhs : {rat64_t(360), rat64_t(-7), rat64_t(5,12), rat64_t(-65536,65537), rat64_t(1,4294967295u)}){
+            const rat64_t::Divisor divisor(rhs);
+            std::vector<rat64_t> quotients(values.size());
+            [[maybe_unused]] const bool overflow = rat64_t::divide(values.data(), divisor, quotients.data(), values.size());
+            bool any_overflow = false;
+            for(size_t i = 0; i < values.size(); i++){
+                rat64_t expected;
+                const bool failed = rat64_t::divide(values[i], rhs, expected);
+                any_overflow |= failed;
+                assert(quotients[i] == (failed ? rat64_t() : expected));
+            }
+            assert(overflow == any_overflow);
+
+            std::vector<NumType> nums;
+            for(const rat64_t& val : values) nums.push_back(NumType(val));
+            nums.push_back(NumType(mpq_class("123456789012345678901234567890/7")));
+            nums.push_back(NumType::fromWide(static_cast<WideWord>(1) << 100));
+            std::vector<NumType> expected = nums;
+            for(NumType& val : expected) val /= NumType(rhs);
+            NumType::divide(nums, divisor);
+            for(size_t i = 0; i < nums.size(); i++) assert(nums[i] == expected[i] && nums[i].type == expected[i].type);
+        }
+        const std::vector<NumType> multiples_of_six = {0, 6, -12, NumType(max_n - max_n % 6), NumType::fromWide(static_cast<WideWord>(6) << 100),
+                                                       NumType(mpz_class(mpz_class(6) << 200))};
+        const std::vector<NumType> multiples_of_prime = {0, NumType::fromWide(4294967291u), NumType::fromWide(-(static_cast<WideWord>(4294967291u) << 64))};
+        const std::pair<rat64_t::Divisor, std::vector<NumType>> integer_divisions[] = {
+            {rat64_t::Divisor(1u), multiples_of_six}, {rat64_t::Divisor(6u), multiples_of_six},
+            {rat64_t::Divisor(rat64_t(-6)), multiples_of_six}, {rat64_t::Divisor(4294967291u), multiples_of_prime}};
+        for(const auto& division : integer_divisions){
+            std::vector<NumType> nums = division.second;
+            std::vector<NumType> expected = nums;
+            for(NumType& val : expected) val.inPlaceIntegerDivide(NumType::fromDivisor(division.first));
+            NumType::integerDivide(nums, division.first);
+            for(size_t i = 0; i < nums.size(); i++) assert(nums[i] == expected[i] && nums[i].type == expected[i].type);
+        }
+    }
+
+    //Fused multiply-add and dot products
+    {
+        std::vector<NumType> values = {0, 1, -1, 7, max_n, min_n, NumType(3,2), NumType(-max_n,4294967295u),
+                                       NumType(max_n) * NumType(max_n), std::pow(NumType(-3),70),
+                                       NumType(mpz_class("123456789012345678901234567890123456789012345")),
+                                       NumType(mpq_class("-7/123456789012345678901234567890"))};
+        for(NumType& val : values) val.reduce();
+        auto canonical = [](const mpq_class& q){
+            NumType ans(q);
+            ans.reduce();
+            return ans;
+        };
+        for(const NumType& a : values){
+            for(const NumType& b : values){
+                for(const NumType& c : values){
+                    const NumType expected = canonical(mpq_class(a.toString()) * mpq_class(b.toString()) + mpq_class(c.toString()));
+                    const NumType ans = NumType::fma(a, b, c);
+                    assert(ans == expected && ans.type == expected.type);
+                }
+            }
+        }
+        assert(NumType::fma(max_n, 2, -max_n) == max_n && NumType::fma(max_n, 2, -max_n).type == WordInt);
+        assert(NumType::fma(NumType(65536,3), NumType(32768,5), NumType(-1,15)) == NumType(max_n,15));
+
+        mpq_class expected_dot = 0;
+        std::vector<NumType> lhs, rhs;
+        for(size_t i = 0; i < values.size(); i++){
+            for(size_t j = 0; j < values.size(); j++){
+                lhs.push_back(values[i]);
+                rhs.push_back(values[(i*7 + j) % values.size()]);
+                expected_dot += mpq_class(lhs.back().toString()) * mpq_class(rhs.back().toString());
+            }
+        }
+        assert(NumType::dot(lhs, rhs) == canonical(expected_dot));
+        assert(NumType::dot(lhs.data(), rhs.data(), 0) == 0);
+
+        //Distinct large denominators overflow the 128 bit accumulator long before the sum is done
+        lhs.clear();
+        rhs.clear();
+        expected_dot = 0;
+        for(int32_t i = 0; i < 40; i++){
+            lhs.push_back(NumType(i % 2 ? -1 : 1, 4294967291u - 2*i));
+            rhs.push_back(NumType(max_n - i, 7));
+            expected_dot += mpq_class(lhs.back().toString()) * mpq_class(rhs.back().toString());
+        }
+        assert(NumType::dot(lhs, rhs) == canonical(expected_dot));
+        assert(NumType::dot(lhs, rhs).type == canonical(expected_dot).type);
+        rhs = lhs;
+        for(NumType& val : rhs) val = -val;
+        assert(NumType::dot(lhs, lhs) + NumType::dot(lhs, rhs) == 0);
+
+        //Integer products which each fit in 128 bits but whose sum does not
+        const NumType wide = NumType::fromWide(WideWord(1) << 125);
+        lhs = {wide, wide};
+        rhs = {NumType(3), NumType(3)};
+        assert(NumType::dot(lhs, rhs) == wide * NumType(6));
+    }
+
+    //Three-way comparison across every pair of tiers
+    {
+        const mpz_class big = mpz_class(1) << 130;
+        const std::vector<NumType> values = {
+            NumType(0), NumType(1), NumType(-1), NumType(7,3), NumType(-7,3), NumType(2147483647), NumType(-2147483647),
+            NumType(1, 4294967291u), NumType(-2147483647, 4294967291u), NumType(big), NumType(mpz_class(-big)),
+            NumType(mpz_class(big + 1)), NumType(mpz_class(mpz_class(1) << 33)), NumType(mpq_class(big, 3)),
+            NumType(mpq_class(-big, 3)), NumType(mpq_class(1, big)), NumType(mpq_class(mpz_class(1) << 40, 3)),
+            NumType(mpq_class(mpz_class(1), (mpz_class(1) << 40) + 1)), NumType::fromWide(WideWord(1) << 70),
+            NumType::fromWide(-(WideWord(3) << 40)), NumType::dyadic(3, 100), NumType::dyadic(-5, 1),
+            NumType::dyadic(3, 1), NumType::decimal(123, 2), NumType::decimal(-1, 18), NumType::decimal(5, 1)};
+        std::vector<mpq_class> exact;
+        for(const NumType& val : values) exact.push_back(mpq_class(val.toString()));
+
+        for(size_t i = 0; i < values.size(); i++){
+            [[maybe_unused]] const int expected_sign = (exact[i] > 0) - (exact[i] < 0);
+            assert(values[i].sign() == expected_sign);
+            for(int32_t k : {-2147483647, -3, -1, 0, 1, 2, 2147483647}){
+                [[maybe_unused]] const int expected = (exact[i] > k) - (exact[i] < k);
+                assert(values[i].compare(k) == expected);
+                assert((values[i] < k) == (expected < 0) && (values[i] > k) == (expected > 0));
+                assert((values[i] <= k) == (expected <= 0) && (values[i] >= k) == (expected >= 0));
+            }
+            for(size_t j = 0; j < values.size(); j++){
+                [[maybe_unused]] const int expected = (exact[i] > exact[j]) - (exact[i] < exact[j]);
+                [[maybe_unused]] const NumType& lhs = values[i];
+                [[maybe_unused]] const NumType& rhs = values[j];
+                assert(lhs.compare(rhs) == expected && rhs.compare(lhs) == -expected);
+                assert((lhs < rhs) == (expected < 0) && (lhs > rhs) == (expected > 0));
+                assert((lhs <= rhs) == (expected <= 0) && (lhs >= rhs) == (expected >= 0));
+                assert((lhs == rhs) == (expected == 0));
+            }
+        }
+
+        //Once this thread's scratch registers are warm no comparison touches the GMP allocator
+        mp_set_memory_functions(countingAllocate, countingReallocate, countingFree);
+        int checksum = 0;
+        for(const NumType& lhs : values) for(const NumType& rhs : values) checksum += lhs.compare(rhs);
+        gmp_allocations = 0;
+        for(const NumType& lhs : values) for(const NumType& rhs : values) checksum -= lhs.compare(rhs);
+        assert(checksum == 0 && gmp_allocations == 0);
+        mp_set_memory_functions(nullptr, nullptr, nullptr);
+    }
+
+    //Primitive operands match the general operators on a NumType operand
+    {
+        const mpz_class big = mpz_class(1) << 130;
+        std::vector<NumType> values = {
+            NumType(0), NumType(1), NumType(-6), NumType(2147483647), NumType(-2147483647), NumType(7,3), NumType(-7,12),
+            NumType(1, 4294967291u), NumType(-2147483647, 4294967291u), NumType(big), NumType(mpz_class(-big - 6)),
+            NumType(mpq_class(big, 3)), NumType(mpq_class(-big, 9)), NumType(mpq_class(1, big)),
+            NumType(mpq_class(mpz_class(1), (mpz_class(1) << 40) + 1)), NumType::fromWide(WideWord(1) << 70),
+            NumType::fromWide(-(WideWord(3) << 40)), NumType::fromWide((WideWord(1) << 126) + 1), NumType::dyadic(3, 100),
+            NumType::dyadic(-5, 1), NumType::dyadic(3, 40), NumType::decimal(123, 2), NumType::decimal(-1, 18)};
+        for(NumType& val : values) val.reduce();
+        auto canonical = [](const mpq_class& q){
+            NumType ans(q);
+            ans.reduce();
+            return ans;
+        };
+        auto exact = [](WideWord z){
+            mpz_class ans;
+            NumType::setWide(ans.get_mpz_t(), z);
+            return ans;
+        };
+        [[maybe_unused]] auto same = [](const NumType& a, const NumType& b){
+            return a == b && a.type == b.type;
+        };
+        auto check = [&](const NumType& val, auto z, const mpq_class& q){
+            const NumType operand = canonical(q);
+            NumType ans = val;
+            NumType expected = val;
+            ans += z;
+            expected += operand;
+            assert(same(ans, expected) && mpq_class(ans.toString()) == mpq_class(val.toString()) + q);
+            ans = val;
+            expected = val;
+            ans -= z;
+            expected -= operand;
+            assert(same(ans, expected) && mpq_class(ans.toString()) == mpq_class(val.toString()) - q);
+            ans = val;
+            expected = val;
+            ans *= z;
+            expected *= operand;
+            assert(same(ans, expected) && mpq_class(ans.toString()) == mpq_class(val.toString()) * q);
+            [[maybe_unused]] const int order = (mpq_class(val.toString()) > q) - (mpq_class(val.toString()) < q);
+            assert(val.compare(z) == order && val.compare(operand) == order);
+            assert((val < z) == (order < 0) && (val > z) == (order > 0) && (val == z) == (order == 0));
+            assert((val <= z) == (order <= 0) && (val >= z) == (order >= 0) && (val != z) == (order != 0));
+            if(q == 0) return;
+            ans = val;
+            expected = val;
+            ans /= z;
+            expected /= operand;
+            assert(same(ans, expected) && mpq_class(ans.toString()) == mpq_class(val.toString()) / q);
+            ans = val;
+            expected = val;
+            ans %= z;
+            expected %= operand;
+            assert(same(ans, expected));
+        };
+
+        const int64_t signed_operands[] = {0, 1, -1, 2, -3, 10, 2147483647, -2147483647-1, int64_t(1) << 40,
+                                           std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min()};
+        const uint64_t unsigned_operands[] = {0, 6, uint64_t(1) << 63, std::numeric_limits<uint64_t>::max()};
+        const rat64_t rat_operands[] = {rat64_t(3,4), rat64_t(-5,7), rat64_t(12), rat64_t(0)};
+        for(const NumType& val : values){
+            for(int64_t z : signed_operands) check(val, z, mpq_class(exact(z)));
+            for(uint64_t z : unsigned_operands) check(val, z, mpq_class(exact(z)));
+            for(const rat64_t& z : rat_operands) check(val, z, mpq_class(mpz_class(z.num), mpz_class(z.den)));
+            check(val, 5, mpq_class(5));
+            check(val, 9u, mpq_class(9));
+            check(val, static_cast<int16_t>(-4), mpq_class(-4));
+        }
+
+        //Unscoped enums still count as integers
+        NumType tiers = 0;
+        tiers += WideInt;
+        assert(tiers == 4 && tiers < Dyadic);
+    }
+
+    //Growth-aware sizing of GMP storage
+    {
+        mp_set_memory_functions(countingAllocate, countingReallocate, countingFree);
+        mpz_class expected = 1;
+        for(uint32_t j = 1; j <= 400; j++) expected *= j;
+
+        //Promotion and in-place growth leave headroom, so a long product does not regrow at every limb
+        NumType product = 1;
+        gmp_allocations = 0;
+        for(int32_t j = 1; j <= 400; j++) product *= j;
+        assert(gmp_allocations < 10 && product == NumType(expected));
+        assert(product.capacity() >= NumType::bitLength(expected));
+
+        //A reserved accumulator is sized once, when it is promoted
+        NumType reserved = 1;
+        reserved.reserve(4096);
+        assert(reserved.type == WordInt && reserved.capacity() == 4096);
+        gmp_allocations = 0;
+        for(int32_t j = 1; j <= 400; j++) reserved *= j;
+        assert(gmp_allocations == 1 && reserved == product && reserved.capacity() >= 4096);
+        reserved = 3;
+        reserved *= NumType(mpz_class(mpz_class(1) << 200));
+        assert(reserved.capacity() >= 4096);
+
+        //Reserving GMP storage grows it now, cloning a shared payload first
+        NumType shared = product;
+        const mp_bitcnt_t before = product.capacity();
+        shared.reserve(before + 1000);
+        assert(shared == product && shared.capacity() >= before + 1000 && product.capacity() == before);
+        NumType copy = shared;
+        copy.reserve(0);
+        assert(copy == product && NumType(copy).reserved_bits == 0);
+        NumType fraction = NumType(mpq_class(expected, 7));
+        fraction.reserve(1 << 14);
+        assert(fraction == NumType(mpq_class(expected, 7)) && fraction.capacity() >= (1 << 14));
+
+        //Word rationals that overflow get headroom in both parts
+        NumType halving(1, 3);
+        gmp_allocations = 0;
+        for(int32_t j = 0; j < 300; j++) halving *= NumType(1, 2);
+        assert(gmp_allocations < 6 && halving == NumType(mpq_class(mpz_class(1), mpz_class(3) << 300)));
+        mp_set_memory_functions(nullptr, nullptr, nullptr);
+    }
+
+    //Operation traces
+    {
+        const std::vector<NumType> operands = {
+            NumType(-7), NumType(5, 9), NumType(-5, 9), NumType::fromWide(WideWord(1) << 100),
+            NumType::fromWide(-(WideWord(1) << 90) + 3), NumType::dyadic(-3, 70), NumType::decimal(123456789, 12),
+            NumType(mpz_class((mpz_class(1) << 300) + 1)), NumType(mpz_class(-(mpz_class(3) << 200))),
+            NumType(mpq_class((mpz_class(1) << 150) + 1, mpz_class(1) << 100)),
+            NumType(mpq_class(-(mpz_class(1) << 140) - 1, mpz_class(7) << 90)),
+        };
+        const char ops[] = {'+', '-', '*', '/', '%', '<', '='};
+
+        std::vector<TraceRecord> written;
+        std::stringstream trace;
+        {
+            TraceRecorder recorder(trace);
+            for(size_t i = 0; i < operands.size(); i++){
+                for(size_t j = 0; j < operands.size(); j++){
+                    if(operands[j].sign() == 0) continue;
+                    written.push_back({ops[(i + j) % 7], TraceOperand::of(operands[i]), TraceOperand::of(operands[j])});
+                    recorder.record(written.back());
+                }
+                written.push_back({ops[i % 7], TraceOperand::of(operands[i]), TraceOperand::integer(std::numeric_limits<int64_t>::min() + 9)});
+                recorder.record(written.back());
+                written.push_back({ops[(i + 3) % 7], TraceOperand::of(operands[i]), TraceOperand::integer(-13)});
+                recorder.record(written.back());
+            }
+            assert(recorder.records == written.size());
+        }
+
+        //Records round-trip, with word sized values exactly and GMP values by size and sign
+        TraceReader reader(trace);
+        TraceRecord record;
+        for([[maybe_unused]] const TraceRecord& expected : written){
+            assert(reader.next(record));
+            assert(record.op == expected.op);
+            assert(record.lhs.kind == expected.lhs.kind && record.lhs.a == expected.lhs.a && record.lhs.b == expected.lhs.b);
+            assert(record.rhs.kind == expected.rhs.kind && record.rhs.a == expected.rhs.a && record.rhs.b == expected.rhs.b);
+        }
+        assert(!reader.next(record));
+
+#ifdef NUMTYPE_TRACE
+        //Hinted kernels and NumVector's bulk operations are logged like the operators they stand for
+        {
+            std::stringstream hooked;
+            NumType total;
+            size_t less;
+            {
+                TraceRecorder recorder(hooked);
+                NumType x = 6;
+                x.multiplyHinted<WordInt>(NumType(7));
+                x.addHinted<WordInt>(NumType(1));
+                x.subtractHinted<WordInt>(NumType(2));
+                x.multiplyHinted<WordInt>(NumType(1 << 30)); //Overflows into the cold path, still one record
+                NumVector v(std::vector<NumType>{1, 2, 3});
+                v += NumVector(std::vector<NumType>{4, 5, 6});
+                v *= NumType(2);
+                total = v.sum();
+                less = v.countLessThan(NumType(12));
+                assert(recorder.records == 16);
+            }
+            assert(total == 42 && less == 1);
+            TraceReader hooked_reader(hooked);
+            for(char op : std::string("*+-*+++***+++<<<")){
+                assert(hooked_reader.next(record) && record.op == op);
+            }
+            assert(!hooked_reader.next(record));
+        }
+#endif
+
+        for(size_t i = 0; i < operands.size(); i++){
+            const NumType val = TraceOperand::of(operands[i]).value(i);
+            assert(val.type == operands[i].type && val.sign() == operands[i].sign());
+            if(val.type == GmpInt){
+                assert(NumType::bitLength(val.asBigInt()) == NumType::bitLength(operands[i].asBigInt()));
+            }else if(val.type == GmpRat){
+                assert(NumType::bitLength(val.asBigRat().get_num()) == NumType::bitLength(operands[i].asBigRat().get_num()));
+                assert(NumType::bitLength(val.asBigRat().get_den()) == NumType::bitLength(operands[i].asBigRat().get_den()));
+            }else{
+                assert(val == operands[i]);
+            }
+        }
+
+        //Replaying a record performs the logged operation
+        for(const TraceRecord& entry : written){
+            if(entry.lhs.kind == GmpInt || entry.lhs.kind == GmpRat || entry.rhs.kind == GmpInt || entry.rhs.kind == GmpRat) continue;
+            NumType lhs = entry.lhs.value(0);
+            const NumType rhs = entry.rhs.value(0);
+            NumType expected = lhs;
+            [[maybe_unused]] int result = entry.execute(lhs, rhs);
+            switch (entry.op) {
+                case '+': expected += rhs; break;
+                case '-': expected -= rhs; break;
+                case '*': expected *= rhs; break;
+                case '/': expected /= rhs; break;
+                case '%': expected %= rhs; break;
+                case '<': assert(result == expected.compare(rhs)); break;
+                case '=': assert(result == (expected == rhs)); break;
+            }
+            assert(lhs == expected && entry.mutates() == (entry.op != '<' && entry.op != '='));
+        }
+
+        std::stringstream bad("NTR0");
+        [[maybe_unused]] bool thrown = false;
+        try{ TraceReader reader(bad); }catch(const std::invalid_argument&){ thrown = true; }
+        assert(thrown);
+        std::stringstream truncated(trace.str().substr(0, trace.str().size() - 1));
+        thrown = false;
+        try{
+            TraceReader reader(truncated);
+            while(reader.next(record));
+        }catch(const std::invalid_argument&){ thrown = true; }
+        assert(thrown);
+    }
+
+    //Operand size and latency histograms
+    {
+        assert(BitHistogram::bucketOf(0) == 0 && BitHistogram::bucketOf(1) == 1 && BitHistogram::bucketOf(64) == 7);
+        for(uint32_t i = 1; i < BitHistogram::num_buckets; i++){
+            assert(BitHistogram::bucketOf(BitHistogram::bucketMin(i)) == i && BitHistogram::bucketOf(BitHistogram::bucketMax(i)) == i);
+            if(i > 1) assert(BitHistogram::bucketMin(i) == BitHistogram::bucketMax(i - 1) + 1);
+        }
+        for(uint32_t i = 0; i < LatencyHistogram::num_buckets; i++){
+            assert(LatencyHistogram::bucketOf(LatencyHistogram::bucketMin(i)) == i);
+            assert(LatencyHistogram::bucketOf(LatencyHistogram::bucketMax(i)) == i);
+            if(i > 0) assert(LatencyHistogram::bucketMin(i) == LatencyHistogram::bucketMax(i - 1) + 1);
+            assert(LatencyHistogram::bucketMax(i) - LatencyHistogram::bucketMin(i) <= LatencyHistogram::bucketMin(i) / LatencyHistogram::sub_buckets);
+        }
+        assert(LatencyHistogram::bucketOf(std::numeric_limits<uint64_t>::max()) == LatencyHistogram::num_buckets - 1);
+
+        LatencyHistogram latencies;
+        for(uint64_t ns = 1; ns <= 1000; ns++) latencies.add(ns);
+        assert(latencies.count == 1000 && latencies.min == 1 && latencies.max == 1000 && latencies.sum == 500500);
+        for(double q : {0.5, 0.9, 0.99}){
+            [[maybe_unused]] const uint64_t exact = static_cast<uint64_t>(q * 1000);
+            assert(latencies.quantile(q) >= exact && latencies.quantile(q) <= exact + exact / LatencyHistogram::sub_buckets);
+        }
+        assert(latencies.quantile(1.0) == 1000 && LatencyHistogram().quantile(0.5) == 0);
+
+        //Sizes of the larger part of each tier's value
+        assert(NumStats::operandBits(NumType(0)) == 0 && NumStats::operandBits(NumType(-255)) == 8);
+        assert(NumStats::operandBits(NumType(3, 1000)) == 10);
+        assert(NumStats::operandBits(NumType::fromWide(-(WideWord(1) << 100))) == 101);
+        assert(NumStats::operandBits(NumType::dyadic(3, 70)) == 71);
+        assert(NumStats::operandBits(NumType::decimal(123456789, 2)) == 27);
+        assert(NumStats::operandBits(NumType(mpz_class(mpz_class(1) << 300))) == 301);
+        assert(NumStats::operandBits(NumType(mpq_class(mpz_class(1), (mpz_class(1) << 200) + 1))) == 201);
+
+        NumStats a, b;
+        a.addOperands('+', 5, 300);
+        a.addOperands('*', 0, 64);
+        a.addLatency(typePair(GmpInt, WordInt), 70);
+        b.addOperands('+', 6, 1);
+        b.addLatency(typePair(GmpInt, WordInt), 2000);
+        b.addLatency(typePair(WordInt, WordInt), 3);
+        a.merge(b);
+        [[maybe_unused]] const uint32_t add = NumStats::opIndex('+');
+        assert(a.lhs_bits[add].count == 2 && a.lhs_bits[add].counts[3] == 2);
+        assert(a.rhs_bits[add].counts[9] == 1 && a.rhs_bits[add].counts[1] == 1);
+        [[maybe_unused]] const LatencyHistogram& mixed = a.latency[typePair(GmpInt, WordInt)];
+        assert(mixed.count == 2 && mixed.min == 70 && mixed.max == 2000 && a.latency[typePair(WordInt, WordInt)].count == 1);
+        assert(a.toJson() ==
+            "{\"operations\":{"
+                "\"+\":{\"count\":2,\"lhs_bits\":[{\"min\":4,\"max\":7,\"count\":2}],"
+                    "\"rhs_bits\":[{\"min\":1,\"max\":1,\"count\":1},{\"min\":256,\"max\":511,\"count\":1}]},"
+                "\"*\":{\"count\":1,\"lhs_bits\":[{\"min\":0,\"max\":0,\"count\":1}],"
+                    "\"rhs_bits\":[{\"min\":64,\"max\":127,\"count\":1}]}},"
+            "\"latency_ns\":{"
+                "\"GmpInt,WordInt\":{\"count\":2,\"min\":70,\"max\":2000,\"mean\":1035,\"p50\":71,\"p90\":2000,\"p99\":2000,\"p999\":2000,"
+                    "\"buckets\":[{\"min\":64,\"max\":71,\"count\":1},{\"min\":1920,\"max\":2047,\"count\":1}]},"
+                "\"WordInt,WordInt\":{\"count\":1,\"min\":3,\"max\":3,\"mean\":3,\"p50\":3,\"p90\":3,\"p99\":3,\"p999\":3,"
+                    "\"buckets\":[{\"min\":3,\"max\":3,\"count\":1}]}}}");
+
+        //Threads fold their histograms into the process wide view when they exit or publish
+        NumStats::reset();
+        NumStats::local().stats.addOperands('<', 1, 1);
+        std::thread worker([]{ NumStats::local().stats.addOperands('<', 2, 2); });
+        worker.join();
+        assert(NumStats::snapshot().lhs_bits[NumStats::opIndex('<')].count == 2);
+        NumStats::publish();
+        assert(NumStats::local().stats.lhs_bits[NumStats::opIndex('<')].count == 0);
+        assert(NumStats::snapshot().lhs_bits[NumStats::opIndex('<')].count == 2);
+        NumStats::reset();
+        assert(NumStats::snapshot().toJson() == "{\"operations\":{},\"latency_ns\":{}}");
+
+#ifdef NUMTYPE_STATS
+        //Hinted kernels and NumVector's bulk operations are measured like the operators they stand for
+        {
+            NumType x = 6;
+            NumVector v(std::vector<NumType>{1, 2, 3});
+            const NumVector w(std::vector<NumType>{4, 5, 6});
+            NumStats::reset();
+            x.multiplyHinted<WordInt>(NumType(7));
+            x.addHinted<WordInt>(NumType(1));
+            x.subtractHinted<WordInt>(NumType(2));
+            x.multiplyHinted<WordInt>(NumType(1 << 30)); //Overflows into the cold path, still one operation
+            v += w;
+            v *= NumType(2);
+            const NumType total = v.sum();
+            const size_t less = v.countLessThan(NumType(12));
+            const NumStats stats = NumStats::snapshot();
+            assert(stats.lhs_bits[NumStats::opIndex('*')].count == 5 && stats.lhs_bits[NumStats::opIndex('+')].count == 7);
+            assert(stats.lhs_bits[NumStats::opIndex('-')].count == 1 && stats.lhs_bits[NumStats::opIndex('<')].count == 3);
+            assert(stats.latency[typePair(WordInt, WordInt)].count == 16);
+            assert(total == 42 && less == 1);
+            NumStats::reset();
+        }
+#endif
+    }
+
     std::cout << "ALL TESTS PASSING" << std::endl;
 
     benchmarkSumType();
+    benchmarkTierHints();
     benchmarkGmp();
+    benchmarkCopies();
+    benchmarkScratchAllocations();
+    benchmarkPower();
+    benchmarkMultiModular();
+    benchmarkNumVector();
+    benchmarkLazyNum();
+    benchmarkDivision();
+    benchmarkDivmod();
+    benchmarkFma();
+    benchmarkStickyOverflow();
+    benchmarkDyadic();
+    benchmarkDecimal();
+    benchmarkInvariantDivisor();
+    benchmarkSort();
+    benchmarkPrimitiveOperands();
+    benchmarkGrowth();
 
     return 0;
 }
@@ -0,0 +1,443 @@
+#ifndef MULTI_MODULAR_H
+#define MULTI_MODULAR_H
+
+//Exact evaluation by multi-modular arithmetic.
+//
+//Determinants and other large linear-algebra results have small answers but enormous intermediates
+//when computed directly in mpq_class. Instead the same integer computation is run modulo many
+//62-bit primes, each on plain words, and the exact result is recovered with the Chinese remainder
+//theorem and rational reconstruction. The residue computations are independent, so they are
+//spread over threads. GMP is only used to reduce the inputs and to fold residues together.
+
+#include "big_numeric_sum_type.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+//Arithmetic modulo an odd p < 2^63 in Montgomery form with R = 2^64.
+//Values passed to mul/add/sub/pow are in Montgomery form; see toMont and fromMont.
+struct Montgomery64{
+    uint64_t p;
+    uint64_t p_neg_inv; //-p^-1 mod 2^64
+    uint64_t r2; //R^2 mod p
+    uint64_t one; //R mod p
+
+    explicit Montgomery64(uint64_t modulus) noexcept : p(modulus){
+        assert(p % 2 == 1 && p < (uint64_t(1) << 63));
+        uint64_t inv = p; //Correct to 3 bits, each Newton step doubles that
+        for(int i = 0; i < 5; i++) inv *= 2 - p*inv;
+        p_neg_inv = -inv;
+        one = static_cast<uint64_t>((static_cast<unsigned __int128>(1) << 64) % p);
+        r2 = static_cast<uint64_t>(static_cast<unsigned __int128>(one) * one % p);
+    }
+
+    //t < p*2^64, so t + m*p < 2^128 since p < 2^63
+    uint64_t reduce(unsigned __int128 t) const noexcept{
+        uint64_t m = static_cast<uint64_t>(t) * p_neg_inv;
+        uint64_t u = static_cast<uint64_t>((t + static_cast<unsigned __int128>(m) * p) >> 64);
+        return u >= p ? u - p : u;
+    }
+
+    uint64_t mul(uint64_t a, uint64_t b) const noexcept{
+        return reduce(static_cast<unsigned __int128>(a) * b);
+    }
+
+    uint64_t add(uint64_t a, uint64_t b) const noexcept{
+        uint64_t s = a + b;
+        return s >= p ? s - p : s;
+    }
+
+    uint64_t sub(uint64_t a, uint64_t b) const noexcept{
+        return a >= b ? a - b : a + (p - b);
+    }
+
+    uint64_t neg(uint64_t a) const noexcept{
+        return a == 0 ? 0 : p - a;
+    }
+
+    uint64_t toMont(uint64_t a) const noexcept{
+        return mul(a % p, r2);
+    }
+
+    uint64_t toMont(int64_t a) const noexcept{
+        return a >= 0 ? toMont(static_cast<uint64_t>(a)) : neg(toMont(-static_cast<uint64_t>(a)));
+    }
+
+    uint64_t fromMont(uint64_t a) const noexcept{
+        return reduce(a);
+    }
+
+    uint64_t pow(uint64_t base, uint64_t exp) const noexcept{
+        uint64_t ans = one;
+        while(exp){
+            if(exp & 1) ans = mul(ans, base);
+            base = mul(base, base);
+            exp >>= 1;
+        }
+        return ans;
+    }
+
+    //Only valid for prime p and a != 0
+    uint64_t inverse(uint64_t a) const noexcept{
+        assert(a != 0);
+        return pow(a, p-2);
+    }
+
+    //Deterministic Miller-Rabin; these bases cover every n < 2^64
+    static bool isPrime(uint64_t n) noexcept{
+        if(n < 2) return false;
+        for(uint64_t small : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37})
+            if(n % small == 0) return n == small;
+        if(n >= (uint64_t(1) << 63)) return false; //Outside the Montgomery range, not needed here
+
+        Montgomery64 field(n);
+        uint64_t d = n-1;
+        int s = 0;
+        while(d % 2 == 0){
+            d /= 2;
+            s++;
+        }
+        const uint64_t minus_one = field.neg(field.one);
+        for(uint64_t a : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37}){
+            uint64_t x = field.pow(field.toMont(a), d);
+            if(x == field.one || x == minus_one) continue;
+            bool composite = true;
+            for(int i = 1; i < s && composite; i++){
+                x = field.mul(x, x);
+                composite = (x != minus_one);
+            }
+            if(composite) return false;
+        }
+        return true;
+    }
+
+    static uint64_t primeBelow(uint64_t n) noexcept{
+        assert(n > 3);
+        n -= 1 + (n % 2);
+        while(!isPrime(n)) n -= 2;
+        return n;
+    }
+
+    //The residue of an exact value, or false if p divides its denominator
+    bool residue(const NumType& val, uint64_t& ans) const noexcept{
+        switch(val.type){
+            case WordInt: ans = toMont(val.asWordInt()); return true;
+            case WordRat:{
+                const rat64_t q = val.asWordRat();
+                uint64_t den = toMont(uint64_t(q.den));
+                if(den == 0) return false;
+                ans = mul(toMont(int64_t(q.num)), inverse(den));
+                return true;
+            }
+            case GmpInt: ans = toMont(bigResidue(val.asBigInt().get_mpz_t())); return true;
+            case WideInt:{
+                const WideWord z = val.asWide();
+                const UnsignedWideWord magnitude = z < 0 ? -static_cast<UnsignedWideWord>(z) : z;
+                const uint64_t r = toMont(static_cast<uint64_t>(magnitude % p));
+                ans = z < 0 ? neg(r) : r;
+                return true;
+            }
+            case GmpRat:{
+                const mpq_class& q = val.asBigRat();
+                uint64_t den = toMont(bigResidue(q.get_den_mpz_t()));
+                if(den == 0) return false;
+                ans = mul(toMont(bigResidue(q.get_num_mpz_t())), inverse(den));
+                return true;
+            }
+            case Dyadic:{
+                //The moduli are odd primes, so 2^e is always invertible
+                const uint64_t den = pow(toMont(uint64_t(2)), val.dyadicExponent());
+                ans = mul(toMont(val.dyadicMantissa()), inverse(den));
+                return true;
+            }
+            case Decimal:{
+                const uint64_t den = pow(toMont(uint64_t(10)), val.decimalScale());
+                if(den == 0) return false;
+                ans = mul(toMont(val.decimalMantissa()), inverse(den));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint64_t bigResidue(mpz_srcptr z) const noexcept{
+        return mpz_fdiv_ui(z, p);
+    }
+};
+
+struct MultiModularOptions{
+    //Zero uses one thread per hardware core
+    unsigned threads = 0;
+
+    //Primes evaluated per round; zero uses one per thread.
+    //The candidate found after a round is accepted once every lucky prime of the next round agrees
+    //with it, and at least one of them was lucky.
+    size_t primes_per_round = 0;
+
+    //Integer results use the symmetric residue and skip rational reconstruction,
+    //which halves the number of primes needed
+    bool integer_result = false;
+
+    //When nonzero, a bound on log2 |result| for integers, or log2 |num|*den for rationals.
+    //Evaluation stops with a certain answer once the modulus exceeds it.
+    mp_bitcnt_t bit_bound = 0;
+
+    //Guards against kernels that never stabilize: evaluation throws std::runtime_error once this
+    //many primes have been used without a confirmed result
+    size_t max_primes = 1 << 20;
+};
+
+//Recovers an exact value from residues modulo successive primes.
+//Residues are folded in one prime at a time by Garner's incremental CRT.
+struct CrtAccumulator{
+    bool integer_result;
+    mpz_class value = 0;
+    mpz_class modulus = 1;
+
+    explicit CrtAccumulator(bool integer_result) noexcept : integer_result(integer_result) {}
+
+    void add(const Montgomery64& field, uint64_t residue){
+        //value += modulus * ((residue - value) / modulus mod p)
+        uint64_t delta = field.sub(field.toMont(residue), field.toMont(field.bigResidue(value.get_mpz_t())));
+        uint64_t scale = field.inverse(field.toMont(field.bigResidue(modulus.get_mpz_t())));
+        uint64_t step = field.fromMont(field.mul(delta, scale));
+        mpz_addmul_ui(value.get_mpz_t(), modulus.get_mpz_t(), step);
+        mpz_mul_ui(modulus.get_mpz_t(), modulus.get_mpz_t(), field.p);
+    }
+
+    mp_bitcnt_t modulusBits() const noexcept{
+        return mpz_sizeinbase(modulus.get_mpz_t(), 2);
+    }
+
+    //Finds the candidate value consistent with every residue so far, or false if there is none yet
+    bool reconstruct(NumType& ans) const{
+        if(integer_result){
+            ScratchInt z;
+            mpz_set(z, value.get_mpz_t());
+            ScratchInt half;
+            mpz_fdiv_q_2exp(half, modulus.get_mpz_t(), 1);
+            if(mpz_cmp(z, half) > 0) mpz_sub(z, z, modulus.get_mpz_t());
+            ans = NumType::fromScratch(z);
+            return true;
+        }
+
+        //Half-extended Euclid on (modulus, value) until the remainder drops below sqrt(modulus/2)
+        ScratchInt bound;
+        mpz_fdiv_q_2exp(bound, modulus.get_mpz_t(), 1);
+        mpz_sqrt(bound, bound);
+
+        ScratchInt r0, r1, t0, t1, q, tmp;
+        mpz_set(r0, modulus.get_mpz_t());
+        mpz_set(r1, value.get_mpz_t());
+        mpz_set_ui(t0, 0);
+        mpz_set_ui(t1, 1);
+        while(mpz_cmp(r1, bound) > 0){
+            mpz_fdiv_qr(q, tmp, r0, r1);
+            mpz_swap(r0, r1);
+            mpz_swap(r1, tmp);
+            mpz_mul(tmp, q, t1);
+            mpz_sub(tmp, t0, tmp);
+            mpz_swap(t0, t1);
+            mpz_swap(t1, tmp);
+        }
+
+        if(mpz_cmpabs(t1, bound) > 0) return false;
+        mpz_gcd(tmp, r1, t1);
+        if(mpz_cmp_ui(tmp.z, 1) != 0) return false;
+
+        ScratchRat result;
+        if(mpz_sgn(t1.z) < 0){
+            mpz_neg(r1.z, r1.z);
+            mpz_neg(t1.z, t1.z);
+        }
+        mpz_swap(mpq_numref(result.q), r1);
+        mpz_swap(mpq_denref(result.q), t1);
+        ans = NumType::fromScratch(result.q);
+        return true;
+    }
+};
+
+//Threads started once and woken for each round of primes, so a round costs no thread creation.
+//run(work) calls work(0) on the calling thread and work(1..size) on the workers, returning once all are done.
+struct RoundWorkers{
+    std::function<void(unsigned)> work;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable start, done;
+    size_t round = 0;
+    size_t pending = 0;
+    bool stop = false;
+
+    RoundWorkers(unsigned size, std::function<void(unsigned)> work) : work(std::move(work)){
+        for(unsigned id = 1; id <= size; id++) threads.emplace_back([this, id]{ loop(id); });
+    }
+
+    ~RoundWorkers(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        start.notify_all();
+        for(std::thread& thread : threads) thread.join();
+    }
+
+    RoundWorkers(const RoundWorkers&) = delete;
+    RoundWorkers& operator=(const RoundWorkers&) = delete;
+
+    void run(){
+        if(!threads.empty()){
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = threads.size();
+            round++;
+        }
+        start.notify_all();
+        work(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]{ return pending == 0; });
+    }
+
+    void loop(unsigned id){
+        size_t seen = 0;
+        for(;;){
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                start.wait(lock, [&]{ return stop || round != seen; });
+                if(stop) return;
+                seen = round;
+            }
+            work(id);
+            std::lock_guard<std::mutex> lock(mutex);
+            if(--pending == 0) done.notify_one();
+        }
+    }
+};
+
+//Runs kernel(field, residue) modulo successive 62-bit primes until the exact result is known.
+//The kernel is called concurrently from several threads and must write the result mod p
+//(as a plain residue in [0,p), not in Montgomery form) and return true,
+//or return false if the prime is unlucky for this input (e.g. it divides a denominator).
+template<typename Kernel>
+NumType multiModularEvaluate(const Kernel& kernel, const MultiModularOptions& options = {}){
+    const unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    const size_t per_round = options.primes_per_round ? options.primes_per_round : threads;
+
+    CrtAccumulator crt(options.integer_result);
+    NumType candidate;
+    bool have_candidate = false;
+    uint64_t next_prime = uint64_t(1) << 62;
+    size_t primes_used = 0;
+
+    std::vector<uint64_t> primes(per_round);
+    std::vector<uint64_t> residues(per_round);
+    std::vector<char> lucky(per_round);
+
+    const unsigned active = static_cast<unsigned>(std::min<size_t>(threads, per_round));
+    RoundWorkers workers(active - 1, [&](unsigned thread_id){
+        for(size_t i = thread_id; i < per_round; i += active)
+            lucky[i] = kernel(Montgomery64(primes[i]), residues[i]);
+    });
+
+    for(;;){
+        for(uint64_t& p : primes) p = next_prime = Montgomery64::primeBelow(next_prime);
+        primes_used += per_round;
+        workers.run();
+
+        //Early termination: a candidate survives if every new lucky prime agrees with it,
+        //and a round of only unlucky primes confirms nothing
+        bool confirmed = have_candidate;
+        size_t checked = 0;
+        for(size_t i = 0; i < per_round && confirmed; i++){
+            if(!lucky[i]) continue;
+            Montgomery64 field(primes[i]);
+            uint64_t expected;
+            confirmed = field.residue(candidate, expected) && field.fromMont(expected) == residues[i];
+            checked++;
+        }
+        if(confirmed && checked > 0) return candidate;
+
+        for(size_t i = 0; i < per_round; i++)
+            if(lucky[i]) crt.add(Montgomery64(primes[i]), residues[i]);
+        have_candidate = crt.reconstruct(candidate);
+
+        if(options.bit_bound && crt.modulusBits() > options.bit_bound + 1){
+            if(!have_candidate) throw std::runtime_error("multiModularEvaluate: no rational within the bit bound");
+            return candidate;
+        }
+
+        if(primes_used >= options.max_primes)
+            throw std::runtime_error("multiModularEvaluate: no stable result within max_primes");
+    }
+}
+
+//The determinant of an n x n row-major matrix, by Gaussian elimination over each prime field
+inline NumType determinant(const std::vector<NumType>& entries, size_t n, MultiModularOptions options = {}){
+    assert(entries.size() == n*n);
+    if(n == 0) return 1;
+
+    bool integer_matrix = true;
+    for(const NumType& entry : entries)
+        integer_matrix &= (entry.type == WordInt || entry.type == WideInt || entry.type == GmpInt);
+
+    if(integer_matrix){
+        options.integer_result = true;
+
+        //Hadamard's bound: |det| <= product of the row norms <= product of sqrt(n) * (largest entry in row)
+        if(!options.bit_bound){
+            for(size_t i = 0; i < n; i++){
+                mp_bitcnt_t row_bits = 0;
+                for(size_t j = 0; j < n; j++){
+                    const NumType& entry = entries[i*n + j];
+                    mp_bitcnt_t bits;
+                    if(entry.type == WordInt) bits = rat64_t::bitLength(rat64_t::wordAbs(entry.asWordInt()));
+                    else if(entry.type == WideInt) bits = NumType::wideBitLength(entry.asWide());
+                    else bits = NumType::bitLength(entry.asBigInt());
+                    row_bits = std::max(row_bits, bits);
+                }
+                if(row_bits == 0) return 0;
+                options.bit_bound += row_bits;
+            }
+            options.bit_bound += (n * rat64_t::bitLength(n) + 1) / 2;
+        }
+    }
+
+    auto kernel = [&entries, n](const Montgomery64& field, uint64_t& residue){
+        std::vector<uint64_t> a(n*n);
+        for(size_t i = 0; i < n*n; i++)
+            if(!field.residue(entries[i], a[i])) return false;
+
+        uint64_t det = field.one;
+        for(size_t col = 0; col < n; col++){
+            size_t pivot = col;
+            while(pivot < n && a[pivot*n + col] == 0) pivot++;
+            if(pivot == n){
+                residue = 0;
+                return true;
+            }
+            if(pivot != col){
+                for(size_t j = col; j < n; j++) std::swap(a[pivot*n + j], a[col*n + j]);
+                det = field.neg(det);
+            }
+
+            const uint64_t* pivot_row = &a[col*n];
+            det = field.mul(det, pivot_row[col]);
+            const uint64_t inv = field.inverse(pivot_row[col]);
+            for(size_t i = col+1; i < n; i++){
+                uint64_t* row = &a[i*n];
+                if(row[col] == 0) continue;
+                const uint64_t factor = field.mul(row[col], inv);
+                for(size_t j = col+1; j < n; j++)
+                    row[j] = field.sub(row[j], field.mul(factor, pivot_row[j]));
+            }
+        }
+
+        residue = field.fromMont(det);
+        return true;
+    };
+
+    return multiModularEvaluate(kernel, options);
+}
+
+#endif // MULTI_MODULAR_H
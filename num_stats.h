@@ -0,0 +1,323 @@
+#ifndef NUM_STATS_H
+#define NUM_STATS_H
+
+//Histograms of NumType operand sizes and latencies.
+//
+//A workload slows down when its values grow out of the word tiers, and the operation counts alone
+//do not show it. Built with NUMTYPE_STATS, every outermost arithmetic operation and comparison adds
+//the bit lengths of its operands to a histogram for its operator, and its latency to a histogram
+//for the typePair of its operands. The hinted word kernels count as their operator. NumVector's
+//bulk operations count once per element, timed through the NumType operators rather than the
+//plain integer loops of an uninstrumented build. The histograms are per thread, so recording
+//takes no locks, and merge into a process wide view as threads exit or publish(). Without
+//NUMTYPE_STATS this header may still be used to merge and report histograms, but nothing is
+//recorded automatically.
+
+#include "big_numeric_sum_type.h"
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+//Operand sizes, bucketed by powers of two: bucket 0 holds zero, bucket k holds [2^(k-1), 2^k)
+struct BitHistogram{
+    static constexpr uint32_t num_buckets = 65;
+
+    uint64_t counts[num_buckets] = {};
+    uint64_t count = 0;
+
+    static uint32_t bucketOf(uint64_t bits) noexcept{
+        return bits ? 64 - __builtin_clzll(bits) : 0;
+    }
+    static uint64_t bucketMin(uint32_t i) noexcept{
+        return i ? uint64_t(1) << (i - 1) : 0;
+    }
+    static uint64_t bucketMax(uint32_t i) noexcept{
+        return i ? bucketMin(i) + (bucketMin(i) - 1) : 0;
+    }
+
+    void add(uint64_t bits) noexcept{
+        counts[bucketOf(bits)]++;
+        count++;
+    }
+
+    void merge(const BitHistogram& other) noexcept{
+        for(uint32_t i = 0; i < num_buckets; i++) counts[i] += other.counts[i];
+        count += other.count;
+    }
+};
+
+//Latencies in nanoseconds with HDR style buckets: exact below 2^sub_bits, then 2^sub_bits buckets
+//for each power of two, so a bucket is within 1/2^sub_bits of its values. Latencies of 2^max_bits
+//nanoseconds (about 18 minutes) and more share the last bucket.
+struct LatencyHistogram{
+    static constexpr uint32_t sub_bits = 3;
+    static constexpr uint32_t sub_buckets = 1 << sub_bits;
+    static constexpr uint32_t max_bits = 40;
+    static constexpr uint32_t num_buckets = sub_buckets * (max_bits - sub_bits + 1);
+
+    uint64_t counts[num_buckets] = {};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t min = std::numeric_limits<uint64_t>::max();
+    uint64_t max = 0;
+
+    static uint32_t bucketOf(uint64_t ns) noexcept{
+        if(ns < sub_buckets) return static_cast<uint32_t>(ns);
+        const uint32_t e = 63 - __builtin_clzll(ns);
+        if(e >= max_bits) return num_buckets - 1;
+        return (e - sub_bits + 1) * sub_buckets + static_cast<uint32_t>((ns >> (e - sub_bits)) & (sub_buckets - 1));
+    }
+    static uint64_t bucketMin(uint32_t i) noexcept{
+        if(i < sub_buckets) return i;
+        const uint32_t e = i / sub_buckets + sub_bits - 1;
+        return static_cast<uint64_t>(sub_buckets + i % sub_buckets) << (e - sub_bits);
+    }
+    static uint64_t bucketMax(uint32_t i) noexcept{
+        if(i < sub_buckets) return i;
+        const uint32_t e = i / sub_buckets + sub_bits - 1;
+        return bucketMin(i) + ((uint64_t(1) << (e - sub_bits)) - 1);
+    }
+
+    void add(uint64_t ns) noexcept{
+        counts[bucketOf(ns)]++;
+        count++;
+        sum += ns;
+        min = std::min(min, ns);
+        max = std::max(max, ns);
+    }
+
+    void merge(const LatencyHistogram& other) noexcept{
+        for(uint32_t i = 0; i < num_buckets; i++) counts[i] += other.counts[i];
+        count += other.count;
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+
+    //The largest latency in the bucket holding the q-th quantile, capped by the largest recorded
+    uint64_t quantile(double q) const noexcept{
+        if(count == 0) return 0;
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * count + 0.5));
+        uint64_t seen = 0;
+        for(uint32_t i = 0; i < num_buckets; i++){
+            seen += counts[i];
+            if(seen >= rank) return std::min(bucketMax(i), max);
+        }
+        return max;
+    }
+};
+
+struct NumStats{
+    static constexpr char ops[] = {'+', '-', '*', '/', '%', '<', '='};
+    static constexpr uint32_t num_ops = sizeof(ops);
+    static constexpr uint32_t num_pairs = 1 << 6;
+
+    BitHistogram lhs_bits[num_ops];
+    BitHistogram rhs_bits[num_ops];
+    std::vector<LatencyHistogram> latency = std::vector<LatencyHistogram>(num_pairs);
+
+    static uint32_t opIndex(char op) noexcept{
+        for(uint32_t i = 0; i < num_ops; i++) if(ops[i] == op) return i;
+        assert(false);
+        return 0;
+    }
+
+    static const char* tierName(uint32_t type) noexcept{
+        static const char* names[] = {"GmpInt", "GmpRat", "WordInt", "WordRat", "WideInt", "Dyadic", "Decimal"};
+        return type <= Decimal ? names[type] : "?";
+    }
+
+    //The bit length of the larger part of a value, numerator or denominator
+    static uint64_t operandBits(const NumType& val) noexcept{
+        switch (val.type) {
+            case WordInt: return rat64_t::bitLength(static_cast<uint64_t>(std::abs(val.asWordInt())));
+            case WordRat:{
+                const rat64_t q = val.asWordRat();
+                return std::max(rat64_t::bitLength(static_cast<uint64_t>(std::abs(static_cast<int64_t>(q.num)))),
+                                rat64_t::bitLength(static_cast<uint64_t>(q.den)));
+            }
+            case WideInt: return NumType::wideBitLength(val.asWide());
+            case Dyadic: return std::max<uint64_t>(NumType::wideBitLength(val.dyadicMantissa()), val.dyadicExponent() + 1);
+            case Decimal:
+                return std::max<uint64_t>(NumType::wideBitLength(val.decimalMantissa()),
+                                          rat64_t::bitLength(NumType::powers_of_ten[val.decimalScale()]));
+            case GmpInt: return mpz_sizeinbase(val.asBigInt().get_mpz_t(), 2);
+            case GmpRat:
+                return std::max(mpz_sizeinbase(val.asBigRat().get_num_mpz_t(), 2),
+                                mpz_sizeinbase(val.asBigRat().get_den_mpz_t(), 2));
+        }
+        return 0;
+    }
+
+    void addOperands(char op, uint64_t lhs, uint64_t rhs) noexcept{
+        const uint32_t i = opIndex(op);
+        lhs_bits[i].add(lhs);
+        rhs_bits[i].add(rhs);
+    }
+
+    void addLatency(uint32_t pair, uint64_t ns) noexcept{
+        latency[pair].add(ns);
+    }
+
+    void merge(const NumStats& other){
+        for(uint32_t i = 0; i < num_ops; i++){
+            lhs_bits[i].merge(other.lhs_bits[i]);
+            rhs_bits[i].merge(other.rhs_bits[i]);
+        }
+        for(uint32_t i = 0; i < num_pairs; i++) latency[i].merge(other.latency[i]);
+    }
+
+    void clear(){
+        *this = NumStats();
+    }
+
+    //Only histograms with samples are written, and only their occupied buckets
+    void writeJson(std::ostream& out) const{
+        out << "{\"operations\":{";
+        bool first = true;
+        for(uint32_t i = 0; i < num_ops; i++){
+            if(lhs_bits[i].count == 0) continue;
+            out << (first ? "" : ",") << "\"" << ops[i] << "\":{\"count\":" << lhs_bits[i].count
+                << ",\"lhs_bits\":";
+            writeBuckets(out, lhs_bits[i]);
+            out << ",\"rhs_bits\":";
+            writeBuckets(out, rhs_bits[i]);
+            out << "}";
+            first = false;
+        }
+        out << "},\"latency_ns\":{";
+        first = true;
+        for(uint32_t pair = 0; pair < num_pairs; pair++){
+            const LatencyHistogram& hist = latency[pair];
+            if(hist.count == 0) continue;
+            out << (first ? "" : ",") << "\"" << tierName(pair & 7) << "," << tierName(pair >> 3) << "\":{"
+                << "\"count\":" << hist.count << ",\"min\":" << hist.min << ",\"max\":" << hist.max
+                << ",\"mean\":" << hist.sum / hist.count << ",\"p50\":" << hist.quantile(0.5)
+                << ",\"p90\":" << hist.quantile(0.9) << ",\"p99\":" << hist.quantile(0.99)
+                << ",\"p999\":" << hist.quantile(0.999) << ",\"buckets\":";
+            writeBuckets(out, hist);
+            out << "}";
+            first = false;
+        }
+        out << "}}";
+    }
+
+    std::string toJson() const{
+        std::ostringstream out;
+        writeJson(out);
+        return out.str();
+    }
+
+    template<typename Histogram>
+    static void writeBuckets(std::ostream& out, const Histogram& hist){
+        out << "[";
+        bool first = true;
+        for(uint32_t i = 0; i < Histogram::num_buckets; i++){
+            if(hist.counts[i] == 0) continue;
+            out << (first ? "" : ",") << "{\"min\":" << Histogram::bucketMin(i) << ",\"max\":"
+                << Histogram::bucketMax(i) << ",\"count\":" << hist.counts[i] << "}";
+            first = false;
+        }
+        out << "]";
+    }
+
+    //The histograms of threads which have exited or published, guarded by mutex()
+    static NumStats& retired(){
+        static NumStats stats;
+        return stats;
+    }
+    static std::mutex& mutex(){
+        static std::mutex lock;
+        return lock;
+    }
+
+    //This thread's histograms and the depth of its open StatsScopes
+    struct Local;
+    static Local& local();
+
+    static void publish();
+    static NumStats snapshot();
+    static void dumpJson(std::ostream& out);
+    static void reset();
+
+    static uint64_t nowNs() noexcept{
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+};
+
+struct NumStats::Local{
+    NumStats stats;
+    uint32_t depth = 0;
+
+    Local(){
+        //Constructs the shared state first, so it outlives this thread's histograms
+        retired();
+        mutex();
+    }
+    ~Local(){
+        std::lock_guard<std::mutex> guard(mutex());
+        retired().merge(stats);
+    }
+};
+
+inline NumStats::Local& NumStats::local(){
+    thread_local Local state;
+    return state;
+}
+
+//Moves this thread's histograms into the process wide view
+inline void NumStats::publish(){
+    NumStats& stats = local().stats;
+    std::lock_guard<std::mutex> guard(mutex());
+    retired().merge(stats);
+    stats.clear();
+}
+
+//Every thread which has exited or published, plus this thread
+inline NumStats NumStats::snapshot(){
+    NumStats ans;
+    {
+        std::lock_guard<std::mutex> guard(mutex());
+        ans.merge(retired());
+    }
+    ans.merge(local().stats);
+    return ans;
+}
+
+inline void NumStats::dumpJson(std::ostream& out){
+    snapshot().writeJson(out);
+}
+
+//Forgets everything recorded so far by exited threads and this one
+inline void NumStats::reset(){
+    std::lock_guard<std::mutex> guard(mutex());
+    retired().clear();
+    local().stats.clear();
+}
+
+#ifdef NUMTYPE_STATS
+inline StatsScope::StatsScope(char op, const NumType& lhs, const NumType& rhs)
+    : pair(typePair(lhs.type, rhs.type)){
+    NumStats::Local& state = NumStats::local();
+    if(state.depth++ == 0) state.stats.addOperands(op, NumStats::operandBits(lhs), NumStats::operandBits(rhs));
+    start = NumStats::nowNs();
+}
+
+inline StatsScope::StatsScope(char op, const NumType& lhs, WideWord rhs)
+    : pair(typePair(lhs.type, NumType::isWordOperand(rhs) ? WordInt : WideInt)){
+    NumStats::Local& state = NumStats::local();
+    if(state.depth++ == 0) state.stats.addOperands(op, NumStats::operandBits(lhs), NumType::wideBitLength(rhs));
+    start = NumStats::nowNs();
+}
+
+inline StatsScope::~StatsScope(){
+    const uint64_t end = NumStats::nowNs();
+    NumStats::Local& state = NumStats::local();
+    if(--state.depth == 0) state.stats.addLatency(pair, end - start);
+}
+#endif
+
+#endif // NUM_STATS_H
@@ -0,0 +1,309 @@
+#ifndef NUM_TRACE_H
+#define NUM_TRACE_H
+
+//Operation traces of NumType workloads.
+//
+//Synthetic benchmarks rarely match the mix of tiers and operations of a real program. Building a
+//program with NUMTYPE_TRACE and running its workload inside a TraceRecorder logs every arithmetic
+//operation and comparison to a compact binary trace, which trace_replay then re-executes against
+//any build of the sum type, timing each kind of operation. The hinted word kernels are logged as
+//their operator, and NumVector's bulk operations as one record per element.
+//
+//A trace is the bytes "NTR1" followed by one record per operation: the operator character
+//('+', '-', '*', '/', '%', '<' for a three-way comparison, '=' for equality), then the left and
+//right operands. An operand is a kind byte, a Type or TraceInteger for a primitive integer operand,
+//followed by LEB128 varints, zigzag encoded when signed:
+//  WordInt, WideInt, TraceInteger: the value
+//  WordRat: the numerator and denominator
+//  Dyadic, Decimal: the packed word
+//  GmpInt: the signed bit length
+//  GmpRat: the signed bit length of the numerator and the bit length of the denominator
+//GMP values are logged by size alone, which keeps traces small and free of the program's data.
+//Replay fills them with pseudo-random bits seeded by the record's position, so it is reproducible.
+
+#include "big_numeric_sum_type.h"
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+constexpr uint8_t TraceInteger = 7;
+
+struct TraceOperand{
+    uint8_t kind = WordInt;
+    WideWord a = 0; //The value, numerator, packed word or signed bit length
+    WideWord b = 0; //The denominator or its bit length
+
+    static TraceOperand of(const NumType& val){
+        TraceOperand operand;
+        operand.kind = static_cast<uint8_t>(val.type);
+        switch (val.type) {
+            case WordInt: operand.a = val.asWordInt(); break;
+            case WordRat: operand.a = val.asWordRat().num; operand.b = val.asWordRat().den; break;
+            case WideInt: operand.a = val.asWide(); break;
+            case Dyadic:
+            case Decimal: operand.a = reinterpret_cast<int64_t>(val.data); break;
+            case GmpInt:{
+                mpz_srcptr z = val.asBigInt().get_mpz_t();
+                operand.a = mpz_sgn(z) * static_cast<WideWord>(mpz_sizeinbase(z, 2));
+                break;
+            }
+            case GmpRat:{
+                mpq_srcptr q = val.asBigRat().get_mpq_t();
+                operand.a = mpq_sgn(q) * static_cast<WideWord>(mpz_sizeinbase(mpq_numref(q), 2));
+                operand.b = mpz_sizeinbase(mpq_denref(q), 2);
+                break;
+            }
+        }
+        return operand;
+    }
+
+    static TraceOperand integer(WideWord z){
+        TraceOperand operand;
+        operand.kind = TraceInteger;
+        operand.a = z;
+        return operand;
+    }
+
+    //The value this operand stands for. A primitive integer comes back as a NumType, see execute().
+    NumType value(uint64_t seed) const{
+        switch (kind) {
+            case WordInt: return NumType(static_cast<int32_t>(a));
+            case WordRat: return NumType(static_cast<int32_t>(a), static_cast<uint32_t>(b));
+            case WideInt:
+            case TraceInteger: return NumType::fromWide(a);
+            case Dyadic:
+            case Decimal:{
+                NumType ans;
+                ans.data = reinterpret_cast<void*>(static_cast<int64_t>(a));
+                ans.type = static_cast<Type>(kind);
+                return ans;
+            }
+            case GmpInt:{
+                mpz_class z = randomBits(static_cast<mp_bitcnt_t>(a < 0 ? -a : a), seed);
+                if(a < 0) z = -z;
+                NumType ans(std::move(z));
+                ans.reduce();
+                return ans;
+            }
+            case GmpRat:{
+                //Redrawn until coprime, so the canonical value keeps the logged sizes
+                mpq_class q;
+                do{
+                    q.get_num() = randomBits(static_cast<mp_bitcnt_t>(a < 0 ? -a : a), seed);
+                    q.get_den() = randomBits(std::max<mp_bitcnt_t>(2, static_cast<mp_bitcnt_t>(b)), ~seed);
+                    seed += 0x632be59bd9b4e019ull;
+                }while(gcd(q.get_num(), q.get_den()) != 1);
+                if(a < 0) q = -q;
+                NumType ans(std::move(q));
+                ans.reduce();
+                return ans;
+            }
+        }
+        throw std::invalid_argument("Unknown operand kind in trace");
+    }
+
+    //A number with exactly `bits` bits, the rest filled by splitmix64
+    static mpz_class randomBits(mp_bitcnt_t bits, uint64_t seed){
+        mpz_class z = 0;
+        for(mp_bitcnt_t filled = 0; filled < bits; filled += 64){
+            seed += 0x9e3779b97f4a7c15ull;
+            uint64_t word = seed;
+            word = (word ^ (word >> 30)) * 0xbf58476d1ce4e5b9ull;
+            word = (word ^ (word >> 27)) * 0x94d049bb133111ebull;
+            word ^= word >> 31;
+            z <<= 64;
+            z += word;
+        }
+        if(bits == 0) return z;
+        mpz_fdiv_r_2exp(z.get_mpz_t(), z.get_mpz_t(), bits);
+        mpz_setbit(z.get_mpz_t(), bits - 1);
+        return z;
+    }
+};
+
+struct TraceRecord{
+    char op = '+';
+    TraceOperand lhs;
+    TraceOperand rhs;
+
+    //Applies the operation to lhs, or returns the result of a comparison
+    int execute(NumType& lhs_val, const NumType& rhs_val) const{
+        if(rhs.kind == TraceInteger){
+            switch (op) {
+                case '+': lhs_val.addInteger(rhs.a); return 0;
+                case '-': lhs_val.addInteger(-rhs.a); return 0;
+                case '*': lhs_val.multiplyInteger(rhs.a); return 0;
+                case '/': lhs_val.divideInteger(rhs.a); return 0;
+                case '%': lhs_val.remainderInteger(rhs.a); return 0;
+                case '<': return lhs_val.compareInteger(rhs.a);
+                case '=': return lhs_val.compareInteger(rhs.a) == 0;
+            }
+        }else{
+            switch (op) {
+                case '+': lhs_val += rhs_val; return 0;
+                case '-': lhs_val -= rhs_val; return 0;
+                case '*': lhs_val *= rhs_val; return 0;
+                case '/': lhs_val /= rhs_val; return 0;
+                case '%': lhs_val %= rhs_val; return 0;
+                case '<': return lhs_val.compare(rhs_val);
+                case '=': return lhs_val == rhs_val;
+            }
+        }
+        throw std::invalid_argument(std::string("Unknown operation in trace: ") + op);
+    }
+
+    bool mutates() const noexcept{
+        return op != '<' && op != '=';
+    }
+};
+
+struct TraceWriter{
+    static void putVarint(std::string& out, UnsignedWideWord val){
+        while(val >= 0x80){
+            out.push_back(static_cast<char>((val & 0x7f) | 0x80));
+            val >>= 7;
+        }
+        out.push_back(static_cast<char>(val));
+    }
+
+    static void putSigned(std::string& out, WideWord val){
+        putVarint(out, (static_cast<UnsignedWideWord>(val) << 1) ^ static_cast<UnsignedWideWord>(val >> 127));
+    }
+
+    static void putOperand(std::string& out, const TraceOperand& operand){
+        out.push_back(static_cast<char>(operand.kind));
+        switch (operand.kind) {
+            case WordRat:
+            case GmpRat:
+                putSigned(out, operand.a);
+                putVarint(out, static_cast<UnsignedWideWord>(operand.b));
+                break;
+            default:
+                putSigned(out, operand.a);
+        }
+    }
+
+    static void putRecord(std::string& out, const TraceRecord& record){
+        out.push_back(record.op);
+        putOperand(out, record.lhs);
+        putOperand(out, record.rhs);
+    }
+};
+
+struct TraceReader{
+    std::istream& in;
+
+    //Checks the header, throwing std::invalid_argument if this is not a trace
+    explicit TraceReader(std::istream& in) : in(in){
+        char magic[4];
+        if(!in.read(magic, 4) || std::string(magic, 4) != "NTR1")
+            throw std::invalid_argument("Not a NumType trace");
+    }
+
+    //False at the end of the trace. A truncated record throws std::invalid_argument.
+    bool next(TraceRecord& record){
+        const int op = in.get();
+        if(op == std::char_traits<char>::eof()) return false;
+        record.op = static_cast<char>(op);
+        record.lhs = getOperand();
+        record.rhs = getOperand();
+        return true;
+    }
+
+    uint8_t getByte(){
+        const int byte = in.get();
+        if(byte == std::char_traits<char>::eof()) throw std::invalid_argument("Truncated trace");
+        return static_cast<uint8_t>(byte);
+    }
+
+    UnsignedWideWord getVarint(){
+        UnsignedWideWord val = 0;
+        for(uint32_t shift = 0; shift < 133; shift += 7){
+            const uint8_t byte = getByte();
+            val |= static_cast<UnsignedWideWord>(byte & 0x7f) << shift;
+            if(!(byte & 0x80)) return val;
+        }
+        throw std::invalid_argument("Malformed varint in trace");
+    }
+
+    WideWord getSigned(){
+        const UnsignedWideWord val = getVarint();
+        return static_cast<WideWord>(val >> 1) ^ -static_cast<WideWord>(val & 1);
+    }
+
+    TraceOperand getOperand(){
+        TraceOperand operand;
+        operand.kind = getByte();
+        if(operand.kind > TraceInteger) throw std::invalid_argument("Unknown operand kind in trace");
+        operand.a = getSigned();
+        if(operand.kind == WordRat || operand.kind == GmpRat) operand.b = static_cast<WideWord>(getVarint());
+        return operand;
+    }
+};
+
+//Logs the operations of this thread to `out` while it is alive. Recorders nest, the innermost one
+//receives the records. Without NUMTYPE_TRACE nothing is logged automatically, but record() still
+//appends to the trace.
+struct TraceRecorder{
+    static constexpr size_t flush_bytes = 1 << 16;
+
+    std::ostream& out;
+    std::string buffer;
+    size_t records = 0;
+    TraceRecorder* previous;
+
+    struct State{
+        TraceRecorder* recorder;
+        uint32_t depth;
+    };
+
+    static State& state() noexcept{
+        thread_local State current = {nullptr, 0};
+        return current;
+    }
+
+    explicit TraceRecorder(std::ostream& out) : out(out), previous(state().recorder){
+        buffer = "NTR1";
+        state().recorder = this;
+    }
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    ~TraceRecorder(){
+        flush();
+        state().recorder = previous;
+    }
+
+    void record(const TraceRecord& record){
+        TraceWriter::putRecord(buffer, record);
+        records++;
+        if(buffer.size() >= flush_bytes) flush();
+    }
+
+    void flush(){
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+};
+
+#ifdef NUMTYPE_TRACE
+inline TraceScope::TraceScope(char op, const NumType& lhs, const NumType& rhs){
+    TraceRecorder::State& state = TraceRecorder::state();
+    if(state.recorder && state.depth == 0) state.recorder->record({op, TraceOperand::of(lhs), TraceOperand::of(rhs)});
+    state.depth++;
+}
+
+inline TraceScope::TraceScope(char op, const NumType& lhs, WideWord rhs){
+    TraceRecorder::State& state = TraceRecorder::state();
+    if(state.recorder && state.depth == 0) state.recorder->record({op, TraceOperand::of(lhs), TraceOperand::integer(rhs)});
+    state.depth++;
+}
+
+inline TraceScope::~TraceScope(){
+    TraceRecorder::state().depth--;
+}
+#endif
+
+#endif // NUM_TRACE_H
@@ -0,0 +1,327 @@
+#ifndef NUM_VECTOR_H
+#define NUM_VECTOR_H
+
+//Columnar storage for many NumType values.
+//
+//A std::vector<NumType> branches on the tier of every element and chases pointers into GMP
+//payloads scattered over the heap. NumVector keeps word tier elements in two dense arrays of
+//numerators and denominators and moves every other tier (WideInt, Dyadic, Decimal and GMP) into
+//a side arena. A zero denominator marks an arena element, whose numerator is then its arena slot.
+//Every chunk of chunk_size elements counts its arena and word rational elements, so bulk
+//operations run plain integer loops over chunks holding only word integers and only fall back to
+//NumType dispatch in chunks which need it. Built with NUMTYPE_TRACE or NUMTYPE_STATS, the plain
+//loops are skipped and every element goes through the NumType operators, so each one is logged
+//and measured.
+
+#include "big_numeric_sum_type.h"
+#include <vector>
+
+struct NumVector{
+    static constexpr size_t chunk_size = 64;
+#if defined(NUMTYPE_TRACE) || defined(NUMTYPE_STATS)
+    static constexpr bool bulk_kernels = false;
+#else
+    static constexpr bool bulk_kernels = true;
+#endif
+
+    struct ChunkSummary{
+        uint32_t big = 0;
+        uint32_t rat = 0;
+    };
+
+    std::vector<int32_t> nums; //Word numerator, or the arena slot when the denominator is 0
+    std::vector<uint32_t> dens; //1 for word integers, 0 for arena elements
+    std::vector<ChunkSummary> chunks;
+    std::vector<NumType> arena; //WideInt, Dyadic, Decimal and GMP elements
+    std::vector<int32_t> free_slots;
+
+    NumVector() = default;
+    explicit NumVector(size_t n) : nums(n, 0), dens(n, 1), chunks((n + chunk_size - 1) / chunk_size) {}
+    NumVector(const std::vector<NumType>& values){
+        reserve(values.size());
+        for(const NumType& val : values) push_back(val);
+    }
+
+    size_t size() const noexcept{
+        return nums.size();
+    }
+
+    bool empty() const noexcept{
+        return nums.empty();
+    }
+
+    void reserve(size_t n){
+        nums.reserve(n);
+        dens.reserve(n);
+        chunks.reserve((n + chunk_size - 1) / chunk_size);
+    }
+
+    bool isWordChunk(size_t c) const noexcept{
+        return chunks[c].big == 0;
+    }
+
+    bool isIntegerChunk(size_t c) const noexcept{
+        return chunks[c].big == 0 && chunks[c].rat == 0;
+    }
+
+    bool isArena(size_t i) const noexcept{
+        return dens[i] == 0;
+    }
+
+    NumType get(size_t i) const{
+        if(dens[i] == 1) return NumType(nums[i]);
+        else if(dens[i] != 0) return NumType(rat64_t(nums[i], dens[i]));
+        else return arena[nums[i]];
+    }
+
+    NumType operator[](size_t i) const{
+        return get(i);
+    }
+
+    void push_back(const NumType& val){
+        if(size() % chunk_size == 0) chunks.emplace_back();
+        nums.push_back(0);
+        dens.push_back(1);
+        place(size() - 1, val);
+    }
+
+    void push_back(NumType&& val){
+        if(size() % chunk_size == 0) chunks.emplace_back();
+        nums.push_back(0);
+        dens.push_back(1);
+        place(size() - 1, std::move(val));
+    }
+
+    void set(size_t i, const NumType& val){
+        if(dens[i] == 0 && !isWordTier(val)) arena[nums[i]] = val;
+        else{
+            vacate(i);
+            place(i, val);
+        }
+    }
+
+    void set(size_t i, NumType&& val){
+        if(dens[i] == 0 && !isWordTier(val)) arena[nums[i]] = std::move(val);
+        else{
+            vacate(i);
+            place(i, std::move(val));
+        }
+    }
+
+    std::vector<NumType> toVector() const{
+        std::vector<NumType> ans;
+        ans.reserve(size());
+        for(size_t i = 0; i < size(); i++) ans.push_back(get(i));
+        return ans;
+    }
+
+    void operator+=(const NumVector& other){
+        elementwise(other, [](int64_t a, int64_t b){ return a + b; },
+                           [](NumType& a, const NumType& b){ a += b; });
+    }
+
+    void operator-=(const NumVector& other){
+        elementwise(other, [](int64_t a, int64_t b){ return a - b; },
+                           [](NumType& a, const NumType& b){ a -= b; });
+    }
+
+    void operator*=(const NumVector& other){
+        elementwise(other, [](int64_t a, int64_t b){ return a * b; },
+                           [](NumType& a, const NumType& b){ a *= b; });
+    }
+
+    void operator+=(const NumType& scalar){
+        broadcast(scalar, [](int64_t a, int64_t b){ return a + b; },
+                          [](NumType& a, const NumType& b){ a += b; });
+    }
+
+    void operator-=(const NumType& scalar){
+        broadcast(scalar, [](int64_t a, int64_t b){ return a - b; },
+                          [](NumType& a, const NumType& b){ a -= b; });
+    }
+
+    void operator*=(const NumType& scalar){
+        broadcast(scalar, [](int64_t a, int64_t b){ return a * b; },
+                          [](NumType& a, const NumType& b){ a *= b; });
+    }
+
+    //Word integers are summed in 128 bits, which cannot overflow for fewer than 2^96 elements
+    NumType sum() const{
+        if constexpr(!bulk_kernels){
+            NumType ans;
+            for(size_t i = 0; i < size(); i++) ans += get(i);
+            return ans;
+        }
+        WideWord integer_sum = 0;
+        NumType rest;
+        for(size_t c = 0; c < chunks.size(); c++){
+            const size_t begin = c * chunk_size;
+            const size_t end = chunkEnd(c);
+            if(isIntegerChunk(c)){
+                int64_t chunk_sum = 0;
+                for(size_t i = begin; i < end; i++) chunk_sum += nums[i];
+                integer_sum += chunk_sum;
+            }else{
+                for(size_t i = begin; i < end; i++){
+                    if(dens[i] == 1) integer_sum += nums[i];
+                    else rest += get(i);
+                }
+            }
+        }
+        rest += NumType::fromWide(integer_sum);
+        return rest;
+    }
+
+    //mask[i] is 1 when element i is less than the bound
+    std::vector<uint8_t> lessThan(const NumType& bound) const{
+        std::vector<uint8_t> mask(size());
+        compareLess(bound, mask.data());
+        return mask;
+    }
+
+    size_t countLessThan(const NumType& bound) const{
+        std::vector<uint8_t> mask(size());
+        compareLess(bound, mask.data());
+        size_t count = 0;
+        for(uint8_t flag : mask) count += flag;
+        return count;
+    }
+
+    static bool isWordTier(const NumType& val) noexcept{
+        return val.type == WordInt || val.type == WordRat;
+    }
+
+    size_t chunkEnd(size_t c) const noexcept{
+        return std::min((c + 1) * chunk_size, size());
+    }
+
+    //Element i must currently hold a word integer with no arena slot
+    template<typename T>
+    void place(size_t i, T&& val){
+        ChunkSummary& chunk = chunks[i / chunk_size];
+        switch (val.type) {
+            case WordInt:
+                nums[i] = static_cast<int32_t>(val.asWordInt());
+                dens[i] = 1;
+                break;
+            case WordRat:{
+                const rat64_t q = val.asWordRat();
+                nums[i] = q.num;
+                dens[i] = q.den;
+                chunk.rat++;
+                break;
+            }
+            default:{
+                int32_t slot;
+                if(free_slots.empty()){
+                    slot = static_cast<int32_t>(arena.size());
+                    arena.push_back(std::forward<T>(val));
+                }else{
+                    slot = free_slots.back();
+                    free_slots.pop_back();
+                    arena[slot] = std::forward<T>(val);
+                }
+                nums[i] = slot;
+                dens[i] = 0;
+                chunk.big++;
+            }
+        }
+    }
+
+    void vacate(size_t i){
+        ChunkSummary& chunk = chunks[i / chunk_size];
+        if(dens[i] == 0){
+            arena[nums[i]] = NumType();
+            free_slots.push_back(nums[i]);
+            chunk.big--;
+        }else if(dens[i] != 1){
+            chunk.rat--;
+        }
+        nums[i] = 0;
+        dens[i] = 1;
+    }
+
+    //Runs a word integer kernel over a chunk, only storing the results if all of them stay word integers
+    template<typename Kernel>
+    bool integerChunk(size_t begin, size_t end, Kernel kernel){
+        int64_t results[chunk_size];
+        bool fits = true;
+        for(size_t i = begin; i < end; i++){
+            const int64_t ans = kernel(i);
+            results[i - begin] = ans;
+            fits &= NumType::fitsWordInt(ans);
+        }
+        if(!fits) return false;
+        for(size_t i = begin; i < end; i++) nums[i] = static_cast<int32_t>(results[i - begin]);
+        return true;
+    }
+
+    //Arena elements are updated in place so an unshared GMP payload is not copied
+    template<typename Op>
+    void apply(size_t i, const NumType& rhs, Op op){
+        if(dens[i] == 0){
+            NumType& val = arena[nums[i]];
+            op(val, rhs);
+            if(isWordTier(val)){
+                const NumType word = val;
+                vacate(i);
+                place(i, word);
+            }
+        }else{
+            NumType val = get(i);
+            op(val, rhs);
+            set(i, std::move(val));
+        }
+    }
+
+    template<typename WordOp, typename Op>
+    void elementwise(const NumVector& other, WordOp word_op, Op op){
+        assert(size() == other.size());
+        for(size_t c = 0; c < chunks.size(); c++){
+            const size_t begin = c * chunk_size;
+            const size_t end = chunkEnd(c);
+            if(bulk_kernels && isIntegerChunk(c) && other.isIntegerChunk(c) &&
+               integerChunk(begin, end, [&](size_t i){ return word_op(nums[i], other.nums[i]); })) continue;
+            for(size_t i = begin; i < end; i++) apply(i, other.get(i), op);
+        }
+    }
+
+    template<typename WordOp, typename Op>
+    void broadcast(const NumType& scalar, WordOp word_op, Op op){
+        for(size_t c = 0; c < chunks.size(); c++){
+            const size_t begin = c * chunk_size;
+            const size_t end = chunkEnd(c);
+            if(bulk_kernels && scalar.type == WordInt && isIntegerChunk(c)){
+                const int64_t z = scalar.asWordInt();
+                if(integerChunk(begin, end, [&](size_t i){ return word_op(nums[i], z); })) continue;
+            }
+            for(size_t i = begin; i < end; i++) apply(i, scalar, op);
+        }
+    }
+
+    //A word bound p/q is compared by cross multiplication, n*q < p*d, which fits in 64 bits
+    void compareLess(const NumType& bound, uint8_t* mask) const{
+        if(!bulk_kernels || !isWordTier(bound)){
+            for(size_t i = 0; i < size(); i++) mask[i] = get(i) < bound;
+            return;
+        }
+        const rat64_t q = bound.type == WordInt ? rat64_t(static_cast<int32_t>(bound.asWordInt())) : bound.asWordRat();
+        const int64_t p = q.num;
+        const int64_t d = q.den;
+        for(size_t c = 0; c < chunks.size(); c++){
+            const size_t begin = c * chunk_size;
+            const size_t end = chunkEnd(c);
+            if(isWordChunk(c)){
+                for(size_t i = begin; i < end; i++)
+                    mask[i] = static_cast<int64_t>(nums[i]) * d < p * static_cast<int64_t>(dens[i]);
+            }else{
+                for(size_t i = begin; i < end; i++)
+                    mask[i] = dens[i] == 0 ?
+                              arena[nums[i]] < bound :
+                              static_cast<int64_t>(nums[i]) * d < p * static_cast<int64_t>(dens[i]);
+            }
+        }
+    }
+};
+
+#endif // NUM_VECTOR_H
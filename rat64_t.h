@@ -3,6 +3,7 @@
 //dynamic allocation can be avoided until necessary. Most operations must be checked
 //to determine if they overflow/underflow, in which case they will return true.
 //Fractions are simplified prior to division to avoid intermediate overflow.
+//All arithmetic is constexpr; only the void* conversions used for sum type storage are not.
 
 #ifndef RAT64_T_H
 #define RAT64_T_H
@@ -12,7 +13,112 @@
 #include <cstring>
 #include <inttypes.h>
 #include <iostream>
+#include <limits>
 #include <numeric>
+#include <stdexcept>
+
+//A 32 bit divisor prepared once for many divisions and gcds by the same value.
+//Quotients, remainders and divisibility tests multiply by the reciprocal ceil(2^64/d) instead of dividing
+//(Lemire, Kaser and Kurz, "Faster Remainder by Direct Computation"). The divisor is factored up front,
+//so a gcd with it only tests each of its primes, using the same reciprocal trick per prime.
+//Factoring is trial division, which only pays off over a batch.
+struct InvariantDivisor{
+    typedef uint32_t UnsignedHalfWord;
+    typedef uint64_t UnsignedWord;
+    static constexpr int max_primes = 9; //3*5*7*...*29 is the largest product of distinct odd primes below 2^32
+
+    UnsignedHalfWord divisor;
+    UnsignedWord reciprocal;
+    int twos;
+    int num_primes; //Odd prime factors
+    UnsignedHalfWord primes[max_primes];
+    UnsignedWord prime_reciprocals[max_primes];
+    int exponents[max_primes];
+
+    constexpr explicit InvariantDivisor(UnsignedHalfWord d)
+        : divisor(d), reciprocal(reciprocalOf(d)), twos(0), num_primes(0), primes(), prime_reciprocals(), exponents(){
+        assert(d != 0);
+        for(; d % 2 == 0; d /= 2) twos++;
+        for(UnsignedHalfWord p = 3; p <= d / p; p += 2){
+            if(d % p) continue;
+            primes[num_primes] = p;
+            prime_reciprocals[num_primes] = reciprocalOf(p);
+            for(; d % p == 0; d /= p) exponents[num_primes]++;
+            num_primes++;
+        }
+        if(d > 1){
+            primes[num_primes] = d;
+            prime_reciprocals[num_primes] = reciprocalOf(d);
+            exponents[num_primes++] = 1;
+        }
+    }
+
+    static constexpr UnsignedWord reciprocalOf(UnsignedHalfWord d){
+        return d == 1 ? 0 : std::numeric_limits<UnsignedWord>::max() / d + 1;
+    }
+
+    //These are exact for every 32 bit n and d > 1
+    static constexpr UnsignedHalfWord quotient(UnsignedHalfWord n, UnsignedHalfWord d, UnsignedWord reciprocal){
+#ifdef __SIZEOF_INT128__
+        (void)d;
+        return static_cast<UnsignedHalfWord>((static_cast<unsigned __int128>(reciprocal) * n) >> 64);
+#else
+        (void)reciprocal;
+        return n / d;
+#endif
+    }
+
+    static constexpr bool divisible(UnsignedHalfWord n, UnsignedWord reciprocal){
+        return n * reciprocal <= reciprocal - 1;
+    }
+
+    constexpr UnsignedHalfWord quotient(UnsignedHalfWord n) const{
+        return divisor == 1 ? n : quotient(n, divisor, reciprocal);
+    }
+
+    constexpr UnsignedHalfWord remainder(UnsignedHalfWord n) const{
+#ifdef __SIZEOF_INT128__
+        return divisor == 1 ? 0 : static_cast<UnsignedHalfWord>((static_cast<unsigned __int128>(reciprocal * n) * divisor) >> 64);
+#else
+        return n % divisor;
+#endif
+    }
+
+    constexpr bool divides(UnsignedHalfWord n) const{
+        return divisor == 1 || divisible(n, reciprocal);
+    }
+
+    //Takes gcd(n, d) out of n and returns it, setting cofactor to d/gcd(n, d)
+    constexpr UnsignedHalfWord cancel(UnsignedHalfWord& n, UnsignedHalfWord& cofactor) const{
+        if(n == 0){
+            cofactor = 1;
+            return divisor;
+        }
+#if defined(__GNUC__) || defined(__clang__)
+        const int shared_twos = std::min(twos, __builtin_ctz(n));
+#else
+        int shared_twos = 0;
+        while(shared_twos < twos && (n >> shared_twos) % 2 == 0) shared_twos++;
+#endif
+        n >>= shared_twos;
+        UnsignedHalfWord gcd = UnsignedHalfWord(1) << shared_twos;
+        cofactor = UnsignedHalfWord(1) << (twos - shared_twos);
+        for(int i = 0; i < num_primes; i++){
+            int e = 0;
+            for(; e < exponents[i] && divisible(n, prime_reciprocals[i]); e++){
+                n = quotient(n, primes[i], prime_reciprocals[i]);
+                gcd *= primes[i];
+            }
+            for(; e < exponents[i]; e++) cofactor *= primes[i];
+        }
+        return gcd;
+    }
+
+    constexpr UnsignedHalfWord gcd(UnsignedHalfWord n) const{
+        UnsignedHalfWord cofactor = 0;
+        return cancel(n, cofactor);
+    }
+};
 
 struct rat64_t{
     typedef int32_t SignedHalfWord;
@@ -20,39 +126,43 @@ struct rat64_t{
     typedef int64_t SignedWord;
     typedef uint64_t UnsignedWord;
 
-    static UnsignedHalfWord safeAbs(const SignedHalfWord& num){
+    static constexpr UnsignedHalfWord safeAbs(const SignedHalfWord& num){
         assert(num != std::numeric_limits<SignedHalfWord>::min());
-        return std::abs(num);
+        return num < 0 ? -num : num;
+    }
+
+    static constexpr UnsignedWord wordAbs(const SignedWord& num){
+        return num < 0 ? -static_cast<UnsignedWord>(num) : static_cast<UnsignedWord>(num);
     }
 
-    static bool multWithOverflowCheck(UnsignedHalfWord a, UnsignedHalfWord b, UnsignedHalfWord& ans){
+    static constexpr bool multWithOverflowCheck(UnsignedHalfWord a, UnsignedHalfWord b, UnsignedHalfWord& ans){
         UnsignedWord full = static_cast<UnsignedWord>(a) * static_cast<UnsignedWord>(b);
         ans = a*b;
         return full > std::numeric_limits<UnsignedHalfWord>::max();
     }
 
-    static bool multWithOverflowCheck(SignedHalfWord a, SignedHalfWord b, SignedHalfWord& ans){
+    static constexpr bool multWithOverflowCheck(SignedHalfWord a, SignedHalfWord b, SignedHalfWord& ans){
         SignedWord full = static_cast<SignedWord>(a) * static_cast<SignedWord>(b);
         ans = full;
         return full > std::numeric_limits<SignedHalfWord>::max() ||
                full <= std::numeric_limits<SignedHalfWord>::min();
     }
 
-    static bool multWithOverflowCheck(SignedHalfWord a, UnsignedHalfWord b, SignedHalfWord& ans){
+    static constexpr bool multWithOverflowCheck(SignedHalfWord a, UnsignedHalfWord b, SignedHalfWord& ans){
         SignedWord full = static_cast<SignedWord>(a) * static_cast<SignedWord>(b);
         ans = full;
         return full > std::numeric_limits<SignedHalfWord>::max() ||
                full <= std::numeric_limits<SignedHalfWord>::min();
     }
 
-    static bool multWithOverflowCheck(UnsignedHalfWord a, SignedWord b, SignedHalfWord& ans){
+    static constexpr bool multWithOverflowCheck(UnsignedHalfWord a, SignedWord b, SignedHalfWord& ans){
         SignedWord full = static_cast<SignedWord>(a) * static_cast<SignedWord>(b);
         ans = full;
         return full > std::numeric_limits<SignedHalfWord>::max() ||
                full <= std::numeric_limits<SignedHalfWord>::min();
     }
 
-    void canonicalize(){
+    constexpr void canonicalize(){
         const auto gcd = std::gcd(safeAbs(num), den);
         num /= static_cast<int32_t>(gcd);
         den /= gcd;
@@ -61,13 +171,13 @@ struct rat64_t{
     SignedHalfWord num; //CANNOT be std::numeric_limits<int32_t>::min(), as it has no positive counterpart
     UnsignedHalfWord den;
 
-    rat64_t() : num(0), den(1) {}
+    constexpr rat64_t() : num(0), den(1) {}
 
-    rat64_t(SignedHalfWord num) : num(num), den(1) {
+    constexpr rat64_t(SignedHalfWord num) : num(num), den(1) {
         assert(num != std::numeric_limits<int32_t>::min());
     }
 
-    rat64_t(SignedHalfWord num, UnsignedHalfWord den)
+    constexpr rat64_t(SignedHalfWord num, UnsignedHalfWord den)
         : num(num), den(den){
         assert(num != std::numeric_limits<int32_t>::min());
         assert(den!=0);
@@ -87,16 +197,16 @@ struct rat64_t{
         return vpointer;
     }
 
-    operator double() const noexcept{
+    constexpr operator double() const noexcept{
         return num / static_cast<double>(den);
     }
 
-    rat64_t operator-() const noexcept{
+    constexpr rat64_t operator-() const noexcept{
         assert(num != std::numeric_limits<int32_t>::min());
         return rat64_t({-num, den});
     }
 
-    static bool multiply(const rat64_t& lhs, const rat64_t& rhs, rat64_t& ans){
+    static constexpr bool multiply(const rat64_t& lhs, const rat64_t& rhs, rat64_t& ans){
         const auto gcd1 = std::gcd(safeAbs(lhs.num), rhs.den);
         const auto gcd2 = std::gcd(safeAbs(rhs.num), lhs.den);
 
@@ -108,45 +218,96 @@ struct rat64_t{
         return multWithOverflowCheck(d1, d2, ans.den) || multWithOverflowCheck(n1, n2, ans.num);
     }
 
-    static bool divide(const rat64_t& lhs, const rat64_t& rhs, rat64_t& ans){
-        const auto gcd1 = std::gcd(lhs.num, rhs.num);
-        const auto gcd2 = std::gcd(rhs.den, lhs.den);
+    //The sign of the divisor moves to the numerator so the denominator stays positive
+    static constexpr bool divide(const rat64_t& lhs, const rat64_t& rhs, rat64_t& ans){
+        assert(rhs.num != 0);
+        if(lhs.num == 0){
+            ans = rat64_t();
+            return false;
+        }
+        const UnsignedHalfWord gcd1 = std::gcd(safeAbs(lhs.num), safeAbs(rhs.num));
+        const UnsignedHalfWord gcd2 = std::gcd(rhs.den, lhs.den);
 
-        const SignedHalfWord n1 = lhs.num/static_cast<SignedHalfWord>(gcd1);
-        const UnsignedHalfWord n2 = rhs.den/static_cast<SignedHalfWord>(gcd2);
+        const SignedHalfWord n1 = (rhs.num < 0 ? -lhs.num : lhs.num)/static_cast<SignedHalfWord>(gcd1);
+        const UnsignedHalfWord n2 = rhs.den/gcd2;
         const UnsignedHalfWord d1 = lhs.den/gcd2;
-        const SignedHalfWord d2 = rhs.num/gcd1;
+        const UnsignedHalfWord d2 = safeAbs(rhs.num)/gcd1;
 
         return multWithOverflowCheck(n1, n2, ans.num) || multWithOverflowCheck(d1, d2, ans.den);
     }
 
-    static bool multiply(const rat64_t& lhs, const UnsignedHalfWord& rhs, rat64_t& ans){
+    static constexpr bool multiply(const rat64_t& lhs, const UnsignedHalfWord& rhs, rat64_t& ans){
         const auto gcd = std::gcd(lhs.den, rhs);
         ans.den = lhs.den / gcd;
         return multWithOverflowCheck(lhs.num, rhs/gcd, ans.num);
     }
 
-    inline static bool multiply(const UnsignedHalfWord& lhs, const rat64_t& rhs, rat64_t& ans){
+    static constexpr bool multiply(const UnsignedHalfWord& lhs, const rat64_t& rhs, rat64_t& ans){
         return multiply(rhs, lhs, ans);
     }
 
-    static bool multiply(const rat64_t& lhs, const SignedHalfWord& rhs, rat64_t& ans){
+    static constexpr bool multiply(const rat64_t& lhs, const SignedHalfWord& rhs, rat64_t& ans){
         const auto gcd = std::gcd(lhs.den, safeAbs(rhs));
         ans.den = lhs.den / gcd;
         return multWithOverflowCheck(lhs.num, rhs/static_cast<SignedHalfWord>(gcd), ans.num);
     }
 
-    inline static bool multiply(const SignedHalfWord& lhs, const rat64_t&rhs, rat64_t& ans){
+    static constexpr bool multiply(const SignedHalfWord& lhs, const rat64_t&rhs, rat64_t& ans){
         return multiply(rhs, lhs, ans);
     }
 
-    static bool divide(const rat64_t& lhs, const UnsignedHalfWord& rhs, rat64_t& ans){
-        const auto gcd = std::gcd(safeAbs(lhs.num), rhs);
-        ans.num = lhs.num / gcd;
+    static constexpr bool divide(const rat64_t& lhs, const UnsignedHalfWord& rhs, rat64_t& ans){
+        assert(rhs != 0);
+        if(lhs.num == 0){
+            ans = rat64_t();
+            return false;
+        }
+        const UnsignedHalfWord gcd = std::gcd(safeAbs(lhs.num), rhs);
+        ans.num = lhs.num / static_cast<SignedHalfWord>(gcd);
         return multWithOverflowCheck(lhs.den, rhs/gcd, ans.den);
     }
 
-    static bool multiply(const rat64_t& lhs, const size_t& rhs, rat64_t& ans){
+    //A divisor p/q prepared for dividing many values. a/b divided by p/q is (a/|p|)*(q/b), and both cross
+    //gcds are taken against the cached factors of |p| and q, so no division instruction is left.
+    struct Divisor{
+        InvariantDivisor num; //|p|
+        InvariantDivisor den;
+        bool negative;
+
+        constexpr explicit Divisor(const rat64_t& val) : num(safeAbs(val.num)), den(val.den), negative(val.num < 0) {}
+        constexpr explicit Divisor(UnsignedHalfWord val) : num(val), den(1), negative(false) {}
+    };
+
+    static constexpr bool divide(const rat64_t& lhs, const Divisor& rhs, rat64_t& ans){
+        if(lhs.num == 0){
+            ans = rat64_t();
+            return false;
+        }
+        UnsignedHalfWord a = safeAbs(lhs.num);
+        UnsignedHalfWord b = lhs.den;
+        UnsignedHalfWord p = 0;
+        UnsignedHalfWord q = 0;
+        rhs.num.cancel(a, p);
+        if(rhs.den.divisor == 1) q = 1;
+        else rhs.den.cancel(b, q);
+        const SignedHalfWord n1 = (lhs.num < 0) != rhs.negative ? -static_cast<SignedHalfWord>(a) : static_cast<SignedHalfWord>(a);
+        return multWithOverflowCheck(n1, q, ans.num) || multWithOverflowCheck(b, p, ans.den);
+    }
+
+    //Divides n values by one divisor, returning true if any quotient overflowed. As in Rat64Context, an
+    //overflowed quotient is left as 0. lhs and ans may be the same array.
+    static constexpr bool divide(const rat64_t* lhs, const Divisor& rhs, rat64_t* ans, size_t n){
+        bool overflow = false;
+        for(size_t i = 0; i < n; i++){
+            if(divide(lhs[i], rhs, ans[i])){
+                ans[i] = rat64_t();
+                overflow = true;
+            }
+        }
+        return overflow;
+    }
+
+    static constexpr bool multiply(const rat64_t& lhs, const size_t& rhs, rat64_t& ans){
         const auto gcd = std::gcd(lhs.den, rhs);
         ans.den = lhs.den / gcd;
         const auto reduced_rhs = rhs/gcd;
@@ -154,16 +315,16 @@ struct rat64_t{
                multWithOverflowCheck(lhs.num, static_cast<SignedHalfWord>(reduced_rhs), ans.num);
     }
 
-    static bool multiply(const rat64_t& lhs, const long long& rhs, rat64_t& ans){
-        const auto gcd = std::gcd(lhs.den, safeAbs(rhs));
+    static constexpr bool multiply(const rat64_t& lhs, const long long& rhs, rat64_t& ans){
+        const auto gcd = std::gcd(static_cast<UnsignedWord>(lhs.den), wordAbs(rhs));
         ans.den = lhs.den / gcd;
-        const auto reduced_rhs = rhs/gcd;
+        const auto reduced_rhs = rhs/static_cast<SignedWord>(gcd);
         return reduced_rhs > std::numeric_limits<SignedHalfWord>::max() ||
                reduced_rhs < std::numeric_limits<SignedHalfWord>::min() ||
                multWithOverflowCheck(lhs.num, static_cast<SignedHalfWord>(reduced_rhs), ans.num);
     }
 
-    static bool add(const SignedWord& ad, const SignedWord& bc, const UnsignedWord& bd, rat64_t& ans){
+    static constexpr bool add(const SignedWord& ad, const SignedWord& bc, const UnsignedWord& bd, rat64_t& ans){
         // a/b + c/d = (a*d + b*c)/(b*d)
 
         if((ad >= 0) == (bc >= 0)){
@@ -179,8 +340,8 @@ struct rat64_t{
                 ans.num = unsigned_num;
                 ans.den = den;
 
-                return unsigned_num > std::numeric_limits<UnsignedHalfWord>::max() ||
-                       den > std::numeric_limits<SignedHalfWord>::max();
+                return unsigned_num > static_cast<UnsignedWord>(std::numeric_limits<SignedHalfWord>::max()) ||
+                       den > std::numeric_limits<UnsignedHalfWord>::max();
             }else{
                 UnsignedWord ad_bc =
                         static_cast<UnsignedWord>(-ad)+static_cast<UnsignedWord>(-bc);
@@ -192,14 +353,14 @@ struct rat64_t{
                 ans.num = -unsigned_num;
                 ans.den = den;
 
-                return unsigned_num > std::numeric_limits<UnsignedHalfWord>::max() ||
-                       den > -(SignedWord)std::numeric_limits<SignedHalfWord>::min();
+                return unsigned_num > static_cast<UnsignedWord>(std::numeric_limits<SignedHalfWord>::max()) ||
+                       den > std::numeric_limits<UnsignedHalfWord>::max();
             }
         }else{
             //The addition result will fit in a signed word
             SignedWord ad_bc = ad + bc;
 
-            const UnsignedWord gcd = std::gcd(safeAbs(ad_bc), bd);
+            const UnsignedWord gcd = std::gcd(wordAbs(ad_bc), bd);
 
             const SignedWord num = ad_bc / static_cast<SignedWord>(gcd);
             const UnsignedWord den = bd / gcd;
@@ -213,7 +374,7 @@ struct rat64_t{
         }
     }
 
-    static bool add(const rat64_t& lhs, const rat64_t& rhs, rat64_t& ans){
+    static constexpr bool add(const rat64_t& lhs, const rat64_t& rhs, rat64_t& ans){
         // a/b + c/d = (a*d + b*c)/(b*d)
 
         const SignedWord ad = static_cast<SignedWord>(rhs.num)*static_cast<SignedWord>(lhs.den);
@@ -223,12 +384,12 @@ struct rat64_t{
         return add(ad, bc, bd, ans);
     }
 
-    static bool subtract(const rat64_t& lhs, const rat64_t& rhs, rat64_t& ans){
+    static constexpr bool subtract(const rat64_t& lhs, const rat64_t& rhs, rat64_t& ans){
         // a/b - c/d = (a*d - b*c)/(b*d)
 
         UnsignedWord bd = static_cast<UnsignedWord>(lhs.den) * static_cast<UnsignedWord>(rhs.den);
-        SignedWord ad = static_cast<SignedWord>(rhs.num)*static_cast<SignedWord>(lhs.den);
-        SignedWord bc = static_cast<SignedWord>(-lhs.num)*static_cast<SignedWord>(rhs.den);
+        SignedWord ad = static_cast<SignedWord>(lhs.num)*static_cast<SignedWord>(rhs.den);
+        SignedWord bc = static_cast<SignedWord>(-rhs.num)*static_cast<SignedWord>(lhs.den);
 
         //Make sure to convert to larger type before negating, because
         // -std::numeric_limits<SignedWord>::min() is UB
@@ -236,10 +397,10 @@ struct rat64_t{
         return add(ad, bc, bd, ans);
     }
 
-    static bool add(const rat64_t& lhs, const SignedHalfWord& rhs, rat64_t& ans){
+    static constexpr bool add(const rat64_t& lhs, const SignedHalfWord& rhs, rat64_t& ans){
         //The addition result will fit in a signed word
         const SignedWord ad_bc = static_cast<SignedWord>(rhs)*static_cast<SignedWord>(lhs.den) + lhs.num;
-        const UnsignedWord gcd = std::gcd(safeAbs(ad_bc), lhs.den);
+        const UnsignedWord gcd = std::gcd(wordAbs(ad_bc), static_cast<UnsignedWord>(lhs.den));
         const SignedWord num = ad_bc / static_cast<SignedWord>(gcd);
         const UnsignedWord den = lhs.den / gcd;
 
@@ -251,24 +412,187 @@ struct rat64_t{
                den > std::numeric_limits<UnsignedHalfWord>::max();
     }
 
-    static bool power(const rat64_t& lhs, const uint8_t& rhs, rat64_t& ans){
-        SignedWord num = 1;
-        UnsignedWord den = 1;
+    static constexpr int bitLength(UnsignedWord x){
+#if defined(__GNUC__) || defined(__clang__)
+        return x ? 64 - __builtin_clzll(x) : 0;
+#else
+        int bits = 0;
+        for(; x; x >>= 1) bits++;
+        return bits;
+#endif
+    }
+
+    static constexpr bool powWithOverflowCheck(UnsignedWord base, UnsignedHalfWord exp, UnsignedWord limit, UnsignedWord& ans){
+        //A b-bit base raised to exp has between (b-1)*exp+1 and b*exp bits.
+        //If the lower bound already passes the limit the result is predicted to overflow,
+        //otherwise b*exp <= 63 and the exact power is computed by squaring in a word.
+        if(base <= 1 || exp == 0){
+            ans = (exp == 0) ? 1 : base;
+            return ans > limit;
+        }
+
+        const UnsignedWord low_bits = static_cast<UnsignedWord>(bitLength(base) - 1) * exp;
+        if(low_bits >= static_cast<UnsignedWord>(bitLength(limit))) return true;
 
-        for(int i = 0; i < rhs; i++){
-            num *= lhs.num;
-            den *= lhs.den;
-            if(num > std::numeric_limits<SignedHalfWord>::max() ||
-               num <= std::numeric_limits<SignedHalfWord>::min() ||
-               den > std::numeric_limits<UnsignedHalfWord>::max())
-                return true;
+        UnsignedWord result = 1;
+        for(;;){
+            if(exp & 1) result *= base;
+            exp >>= 1;
+            if(exp == 0) break;
+            base *= base;
         }
 
-        ans.num = num;
+        ans = result;
+        return result > limit;
+    }
+
+    static constexpr bool power(const rat64_t& lhs, const UnsignedHalfWord& rhs, rat64_t& ans){
+        UnsignedWord num = 0;
+        UnsignedWord den = 0;
+        if(powWithOverflowCheck(safeAbs(lhs.num), rhs, std::numeric_limits<SignedHalfWord>::max(), num) ||
+           powWithOverflowCheck(lhs.den, rhs, std::numeric_limits<UnsignedHalfWord>::max(), den))
+            return true;
+
+        ans.num = (lhs.num < 0 && rhs % 2) ? -static_cast<SignedWord>(num) : static_cast<SignedWord>(num);
         ans.den = den;
         return false;
     }
 
+    //Value returning forms of the kernels, which throw where the kernels return true. In a constant
+    //expression an overflow is then a compile error, as it is for an out of range _q literal.
+    static constexpr rat64_t checkedAdd(const rat64_t& lhs, const rat64_t& rhs){
+        rat64_t ans;
+        if(add(lhs, rhs, ans)) throw std::overflow_error("rat64_t addition overflowed");
+        return ans;
+    }
+
+    static constexpr rat64_t checkedSubtract(const rat64_t& lhs, const rat64_t& rhs){
+        rat64_t ans;
+        if(subtract(lhs, rhs, ans)) throw std::overflow_error("rat64_t subtraction overflowed");
+        return ans;
+    }
+
+    static constexpr rat64_t checkedMultiply(const rat64_t& lhs, const rat64_t& rhs){
+        rat64_t ans;
+        if(multiply(lhs, rhs, ans)) throw std::overflow_error("rat64_t multiplication overflowed");
+        return ans;
+    }
+
+    static constexpr rat64_t checkedDivide(const rat64_t& lhs, const rat64_t& rhs){
+        if(rhs.num == 0) throw std::domain_error("rat64_t division by zero");
+        rat64_t ans;
+        if(divide(lhs, rhs, ans)) throw std::overflow_error("rat64_t division overflowed");
+        return ans;
+    }
+
+    static constexpr rat64_t checkedPower(const rat64_t& lhs, const UnsignedHalfWord& rhs){
+        rat64_t ans;
+        if(power(lhs, rhs, ans)) throw std::overflow_error("rat64_t power overflowed");
+        return ans;
+    }
+
+#ifdef __SIZEOF_INT128__
+    //Fused kernels keep one exact fraction in 128 bit words and only have to fit the final result.
+    typedef __int128 SignedDoubleWord;
+    typedef unsigned __int128 UnsignedDoubleWord;
+
+    static constexpr UnsignedDoubleWord doubleWordAbs(const SignedDoubleWord& num){
+        return num < 0 ? -static_cast<UnsignedDoubleWord>(num) : static_cast<UnsignedDoubleWord>(num);
+    }
+
+    static constexpr UnsignedWord doubleWordGcd(UnsignedDoubleWord a, UnsignedWord b){
+        assert(b != 0);
+        return std::gcd(b, static_cast<UnsignedWord>(a % b));
+    }
+
+    //lhs*rhs as a reduced fraction, which always fits in words
+    static constexpr void product(const rat64_t& lhs, const rat64_t& rhs, SignedWord& num, UnsignedWord& den){
+        if(lhs.num == 0 || rhs.num == 0){
+            num = 0;
+            den = 1;
+            return;
+        }
+        const auto gcd1 = std::gcd(safeAbs(lhs.num), rhs.den);
+        const auto gcd2 = std::gcd(safeAbs(rhs.num), lhs.den);
+
+        num = (lhs.num/static_cast<SignedWord>(gcd1)) * (rhs.num/static_cast<SignedWord>(gcd2));
+        den = static_cast<UnsignedWord>(lhs.den/gcd2) * (rhs.den/gcd1);
+    }
+
+    //num/den += p/q for reduced fractions, leaving num/den untouched if the sum overflows.
+    //The only common factors of the sum and b*d/gcd(b,d) divide gcd(b,d), so the
+    //result is reduced with two word gcds.
+    static constexpr bool accumulate(SignedDoubleWord& num, SignedDoubleWord& den, const SignedDoubleWord& p, const UnsignedWord& q){
+        assert(den > 0 && q > 0);
+        if(den == 1 && q == 1){
+            SignedDoubleWord sum = 0;
+            if(__builtin_add_overflow(num, p, &sum)) return true;
+            num = sum;
+            return false;
+        }
+
+        const UnsignedWord gcd = doubleWordGcd(static_cast<UnsignedDoubleWord>(den), q);
+        const SignedDoubleWord q_gcd = q / gcd;
+        SignedDoubleWord lhs = 0;
+        SignedDoubleWord rhs = 0;
+        SignedDoubleWord sum = 0;
+        SignedDoubleWord lcm = 0;
+        if(__builtin_mul_overflow(num, q_gcd, &lhs) ||
+           __builtin_mul_overflow(p, den / static_cast<SignedDoubleWord>(gcd), &rhs) ||
+           __builtin_add_overflow(lhs, rhs, &sum) ||
+           __builtin_mul_overflow(den, q_gcd, &lcm))
+            return true;
+
+        const SignedDoubleWord reduction = sum == 0 ? lcm : doubleWordGcd(doubleWordAbs(sum), gcd);
+        num = sum / reduction;
+        den = lcm / reduction;
+        return false;
+    }
+
+    static constexpr bool narrow(const SignedDoubleWord& num, const SignedDoubleWord& den, rat64_t& ans){
+        if(num > std::numeric_limits<SignedHalfWord>::max() ||
+           num <= std::numeric_limits<SignedHalfWord>::min() ||
+           den > std::numeric_limits<UnsignedHalfWord>::max())
+            return true;
+        ans.num = static_cast<SignedHalfWord>(num);
+        ans.den = static_cast<UnsignedHalfWord>(den);
+        return false;
+    }
+
+    //a*b + c as a reduced 128 bit fraction. The terms are below 2^95 and the denominator below 2^96.
+    static constexpr void fma(const rat64_t& a, const rat64_t& b, const rat64_t& c, SignedDoubleWord& num, SignedDoubleWord& den){
+        SignedWord p = 0;
+        UnsignedWord q = 0;
+        product(a, b, p, q);
+        num = c.num;
+        den = c.den;
+        const bool overflow = accumulate(num, den, p, q);
+        assert(!overflow);
+        (void)overflow;
+    }
+
+    //a*b + c with a single reduction, so a product which does not fit is not an overflow
+    static constexpr bool fma(const rat64_t& a, const rat64_t& b, const rat64_t& c, rat64_t& ans){
+        SignedDoubleWord num = 0;
+        SignedDoubleWord den = 0;
+        fma(a, b, c, num, den);
+        return narrow(num, den, ans);
+    }
+
+    //The sum of a[i]*b[i], which overflows only if the result or a 128 bit partial sum does not fit
+    static constexpr bool dot(const rat64_t* a, const rat64_t* b, size_t n, rat64_t& ans){
+        SignedDoubleWord num = 0;
+        SignedDoubleWord den = 1;
+        for(size_t i = 0; i < n; i++){
+            SignedWord p = 0;
+            UnsignedWord q = 0;
+            product(a[i], b[i], p, q);
+            if(accumulate(num, den, p, q)) return true;
+        }
+        return narrow(num, den, ans);
+    }
+#endif
+
     std::string toStr() const{
         return std::to_string(num) + '/' + std::to_string(den);
     }
@@ -278,19 +602,19 @@ struct rat64_t{
         return out;
     }
 
-    bool operator==(const rat64_t& rhs) const{
+    constexpr bool operator==(const rat64_t& rhs) const{
         assert(std::gcd(safeAbs(num), den) == 1);
         assert(std::gcd(safeAbs(rhs.num), rhs.den) == 1);
         return num == rhs.num && den == rhs.den;
     }
 
-    bool operator!=(const rat64_t& rhs) const{
+    constexpr bool operator!=(const rat64_t& rhs) const{
         assert(std::gcd(safeAbs(num), den) == 1);
         assert(std::gcd(safeAbs(rhs.num), rhs.den) == 1);
         return num != rhs.num || den != rhs.den;
     }
 
-    bool operator<(const rat64_t& rhs) const{
+    constexpr bool operator<(const rat64_t& rhs) const{
         assert(std::gcd(safeAbs(num), den) == 1);
         assert(std::gcd(safeAbs(rhs.num), rhs.den) == 1);
         return
@@ -299,11 +623,11 @@ struct rat64_t{
             static_cast<SignedWord>(rhs.num)*static_cast<SignedWord>(den);
     }
 
-    bool operator<(int32_t rhs) const{
+    constexpr bool operator<(int32_t rhs) const{
         return num < static_cast<SignedWord>(rhs) * static_cast<SignedWord>(den);
     }
 
-    bool operator<=(const rat64_t& rhs) const{
+    constexpr bool operator<=(const rat64_t& rhs) const{
         assert(std::gcd(safeAbs(num), den) == 1);
         assert(std::gcd(safeAbs(rhs.num), rhs.den) == 1);
         return
@@ -312,7 +636,7 @@ struct rat64_t{
             static_cast<SignedWord>(rhs.num)*static_cast<SignedWord>(den);
     }
 
-    bool operator>(const rat64_t& rhs) const{
+    constexpr bool operator>(const rat64_t& rhs) const{
         assert(std::gcd(safeAbs(num), den) == 1);
         assert(std::gcd(safeAbs(rhs.num), rhs.den) == 1);
         return
@@ -321,11 +645,11 @@ struct rat64_t{
             static_cast<SignedWord>(rhs.num)*static_cast<SignedWord>(den);
     }
 
-    bool operator>(int32_t rhs) const{
+    constexpr bool operator>(int32_t rhs) const{
         return num > static_cast<SignedWord>(rhs) * static_cast<SignedWord>(den);
     }
 
-    bool operator>=(const rat64_t& rhs) const{
+    constexpr bool operator>=(const rat64_t& rhs) const{
         assert(std::gcd(safeAbs(num), den) == 1);
         assert(std::gcd(safeAbs(rhs.num), rhs.den) == 1);
         return
@@ -334,15 +658,15 @@ struct rat64_t{
             static_cast<SignedWord>(rhs.num)*static_cast<SignedWord>(den);
     }
 
-    void operator%=(int64_t rhs) noexcept{
+    constexpr void operator%=(int64_t rhs) noexcept{
         num %= den*rhs;
     }
 
-    rat64_t operator%(int64_t rhs) noexcept{
+    constexpr rat64_t operator%(int64_t rhs) noexcept{
         return rat64_t({num %= den*rhs, den}); //Will not need any reduction
     }
 
-    bool greaterThanPi() const{
+    constexpr bool greaterThanPi() const{
         //165707065/52746197 is the closest rat64_t to pi. It is greater by ~1.64084e-16.
         //80143857/25510582 is the closest rat64_t less than pi. It is less by ~5.79087e-16
         //Compare with the double approximation π-4*atan(1) with an error of ~3.4641e-07
@@ -351,10 +675,115 @@ struct rat64_t{
 };
 
 namespace std {
-    rat64_t abs(const rat64_t& val){
+    constexpr rat64_t abs(const rat64_t& val){
         assert(val.num != std::numeric_limits<rat64_t::SignedHalfWord>::min());
-        return rat64_t({std::abs(val.num), val.den});
+        return rat64_t({val.num < 0 ? -val.num : val.num, val.den});
     }
 }
 
+//Rational literals such as "-3/4"_q or 7_q, canonicalized at compile time.
+//Malformed or out of range literals throw, which is a compile error in a constant expression.
+constexpr rat64_t operator""_q(const char* str, size_t len){
+    size_t i = 0;
+    const bool negative = (len > 0 && str[0] == '-');
+    if(negative) i++;
+
+    rat64_t::UnsignedWord parts[2] = {0, 1};
+    for(int part = 0; part < 2; part++){
+        const size_t start = i;
+        rat64_t::UnsignedWord value = 0;
+        for(; i < len && str[i] >= '0' && str[i] <= '9'; i++){
+            if(value > (std::numeric_limits<rat64_t::UnsignedWord>::max() - 9) / 10)
+                throw std::overflow_error("rat64_t literal out of range");
+            value = 10*value + static_cast<rat64_t::UnsignedWord>(str[i] - '0');
+        }
+        if(i == start) throw std::invalid_argument("rat64_t literal is missing digits");
+        parts[part] = value;
+        if(i == len) break;
+        if(part == 1 || str[i] != '/') throw std::invalid_argument("rat64_t literal is not of the form n/d");
+        i++;
+    }
+
+    if(parts[1] == 0) throw std::domain_error("rat64_t literal has a zero denominator");
+    const rat64_t::UnsignedWord gcd = std::gcd(parts[0], parts[1]);
+    const rat64_t::UnsignedWord num = parts[0] / gcd;
+    const rat64_t::UnsignedWord den = parts[1] / gcd;
+    if(num > static_cast<rat64_t::UnsignedWord>(std::numeric_limits<rat64_t::SignedHalfWord>::max()) ||
+       den > std::numeric_limits<rat64_t::UnsignedHalfWord>::max())
+        throw std::overflow_error("rat64_t literal out of range");
+
+    rat64_t ans;
+    ans.num = negative ? -static_cast<rat64_t::SignedHalfWord>(num) : static_cast<rat64_t::SignedHalfWord>(num);
+    ans.den = static_cast<rat64_t::UnsignedHalfWord>(den);
+    return ans;
+}
+
+constexpr rat64_t operator""_q(unsigned long long val){
+    if(val > static_cast<unsigned long long>(std::numeric_limits<rat64_t::SignedHalfWord>::max()))
+        throw std::overflow_error("rat64_t literal out of range");
+    return rat64_t(static_cast<rat64_t::SignedHalfWord>(val));
+}
+
+//Checked arithmetic for straight-line kernels. Operations do not stop at an overflow but OR it into a
+//sticky flag, so a whole block of work is checked once and rerun on a wider tier if the flag is set.
+//A result which overflowed is replaced with 0, so later operations in the block stay well defined.
+//A zero divisor is not an overflow, since no wider tier can divide by it. It sets a separate sticky
+//flag, and its quotient is 0 like an overflowed result.
+struct Rat64Context{
+    bool overflow = false;
+    bool divide_by_zero = false;
+
+    constexpr void clear() noexcept{
+        overflow = false;
+        divide_by_zero = false;
+    }
+
+    constexpr rat64_t checked(bool failed, const rat64_t& ans) noexcept{
+        overflow |= failed;
+        return failed ? rat64_t() : ans;
+    }
+
+    constexpr rat64_t add(const rat64_t& lhs, const rat64_t& rhs){
+        rat64_t ans;
+        const bool failed = rat64_t::add(lhs, rhs, ans);
+        return checked(failed, ans);
+    }
+
+    constexpr rat64_t subtract(const rat64_t& lhs, const rat64_t& rhs){
+        rat64_t ans;
+        const bool failed = rat64_t::subtract(lhs, rhs, ans);
+        return checked(failed, ans);
+    }
+
+    constexpr rat64_t multiply(const rat64_t& lhs, const rat64_t& rhs){
+        rat64_t ans;
+        const bool failed = rat64_t::multiply(lhs, rhs, ans);
+        return checked(failed, ans);
+    }
+
+    constexpr rat64_t divide(const rat64_t& lhs, const rat64_t& rhs){
+        if(rhs.num == 0){
+            divide_by_zero = true;
+            return rat64_t();
+        }
+        rat64_t ans;
+        const bool failed = rat64_t::divide(lhs, rhs, ans);
+        return checked(failed, ans);
+    }
+
+    constexpr rat64_t power(const rat64_t& lhs, rat64_t::UnsignedHalfWord rhs){
+        rat64_t ans;
+        const bool failed = rat64_t::power(lhs, rhs, ans);
+        return checked(failed, ans);
+    }
+
+#ifdef __SIZEOF_INT128__
+    constexpr rat64_t fma(const rat64_t& a, const rat64_t& b, const rat64_t& c){
+        rat64_t ans;
+        const bool failed = rat64_t::fma(a, b, c, ans);
+        return checked(failed, ans);
+    }
+#endif
+};
+
 #endif // RAT64_T_H
@@ -0,0 +1,123 @@
+//Replays a NumType trace (num_trace.h) against this build and reports the time of each kind of
+//operation, keyed by operator and operand tiers, so changes to the sum type can be judged on a
+//recorded workload.
+//
+//Usage: trace_replay <trace> [repetitions]
+//
+//The whole trace is first run once in order. Then the records of each kind are run together,
+//repetitions times on fresh copies of their operands, and the fastest run is reported.
+
+#include "num_trace.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <tuple>
+#include <vector>
+
+static const char* kindName(uint8_t kind){
+    static const char* names[] = {"GmpInt", "GmpRat", "WordInt", "WordRat", "WideInt", "Dyadic", "Decimal", "Integer"};
+    return kind <= TraceInteger ? names[kind] : "?";
+}
+
+//A copy which does not share its GMP payload, so a timed operation never pays for copy-on-write
+static NumType uniqueCopy(const NumType& val){
+    if(val.type == GmpInt) return NumType(mpz_class(val.asBigInt()));
+    if(val.type == GmpRat) return NumType(mpq_class(val.asBigRat()));
+    return val;
+}
+
+struct Group{
+    std::vector<size_t> records;
+    std::vector<NumType> lhs;
+    std::vector<NumType> rhs;
+    double best_ns = 0;
+};
+
+int main(int argc, char** argv){
+    if(argc < 2){
+        std::cerr << "Usage: " << argv[0] << " <trace> [repetitions]" << std::endl;
+        return 2;
+    }
+    const size_t repetitions = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if(!file){
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 2;
+    }
+
+    std::vector<TraceRecord> records;
+    try{
+        TraceReader reader(file);
+        TraceRecord record;
+        while(reader.next(record)) records.push_back(record);
+    }catch(const std::invalid_argument& e){
+        std::cerr << argv[1] << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<NumType> lhs, rhs;
+    lhs.reserve(records.size());
+    rhs.reserve(records.size());
+    for(size_t i = 0; i < records.size(); i++){
+        lhs.push_back(records[i].lhs.value(2*i));
+        rhs.push_back(records[i].rhs.value(2*i + 1));
+    }
+
+    //The trace in its recorded order, each record on a copy of its left operand
+    int64_t sink = 0;
+    std::vector<NumType> work;
+    work.reserve(records.size());
+    for(const NumType& val : lhs) work.push_back(uniqueCopy(val));
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < records.size(); i++) sink += records[i].execute(work[i], rhs[i]);
+    auto end = std::chrono::high_resolution_clock::now();
+    const double sequential_ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+    std::map<std::tuple<char, uint8_t, uint8_t>, Group> groups;
+    for(size_t i = 0; i < records.size(); i++){
+        Group& group = groups[std::make_tuple(records[i].op, records[i].lhs.kind, records[i].rhs.kind)];
+        group.records.push_back(i);
+        group.lhs.push_back(lhs[i]);
+        group.rhs.push_back(rhs[i]);
+    }
+
+    double grouped_ns = 0;
+    for(auto& entry : groups){
+        Group& group = entry.second;
+        for(size_t rep = 0; rep < repetitions; rep++){
+            work.clear();
+            for(const NumType& val : group.lhs) work.push_back(uniqueCopy(val));
+            start = std::chrono::high_resolution_clock::now();
+            for(size_t j = 0; j < group.records.size(); j++) sink += records[group.records[j]].execute(work[j], group.rhs[j]);
+            end = std::chrono::high_resolution_clock::now();
+            const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+            if(rep == 0 || ns < group.best_ns) group.best_ns = ns;
+        }
+        grouped_ns += group.best_ns;
+    }
+
+    std::vector<std::pair<std::tuple<char, uint8_t, uint8_t>, Group*>> order;
+    for(auto& entry : groups) order.push_back({entry.first, &entry.second});
+    std::sort(order.begin(), order.end(), [](const auto& a, const auto& b){ return a.second->best_ns > b.second->best_ns; });
+
+    std::cout << records.size() << " operations, " << std::fixed << std::setprecision(3)
+              << sequential_ns / 1e6 << "ms in trace order, " << grouped_ns / 1e6 << "ms grouped by kind" << std::endl;
+    std::cout << std::left << std::setw(4) << "op" << std::setw(9) << "lhs" << std::setw(9) << "rhs"
+              << std::right << std::setw(10) << "count" << std::setw(12) << "ns/op" << std::setw(9) << "share" << std::endl;
+    for(const auto& entry : order){
+        const Group& group = *entry.second;
+        std::cout << std::left << std::setw(4) << std::get<0>(entry.first)
+                  << std::setw(9) << kindName(std::get<1>(entry.first))
+                  << std::setw(9) << kindName(std::get<2>(entry.first)) << std::right
+                  << std::setw(10) << group.records.size()
+                  << std::setw(12) << std::setprecision(1) << group.best_ns / group.records.size()
+                  << std::setw(8) << std::setprecision(1) << 100 * group.best_ns / grouped_ns << "%" << std::endl;
+    }
+
+    //Keeps the comparisons from being optimized away
+    return sink == std::numeric_limits<int64_t>::min();
+}